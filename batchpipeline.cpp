@@ -0,0 +1,677 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batchpipeline.h"
+#include "binaryinstance.h"
+#include "boundedqueue.h"
+#include "contenthash.h"
+#include "journal.h"
+#include "packwriter.h"
+#include "textwriter.h"
+#include "vrptwinstancegenerator.h"
+#include "workstealingpool.h"
+
+namespace
+{
+   //! Seconds elapsed since a moment
+   double secondsSince(std::chrono::steady_clock::time_point start)
+   {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   //! Instance generated (not yet formatted)
+   struct tGeneratedInstance
+   {
+      size_t index;
+      std::unique_ptr<VRPTWInstanceGenerator> generator;
+      double generationTime;
+   };
+
+   //! Instance formatted: its output files, their contents and the hashes of the matrices
+   struct tFormattedInstance
+   {
+      size_t index;
+      std::vector<tOutputFile> files;
+      std::vector<std::string> contents;
+      std::vector<tContentHash> hashes;
+      std::vector<uint64_t> checksums;
+      double generationTime;
+      double formattingTime;
+   };
+
+   //! Matrix already written: its file (or entry of the pack)
+   struct tStoredMatrix
+   {
+      std::string fileName;
+      size_t entry;
+   };
+
+   //! Returns true if a kind of file is a matrix
+   bool isMatrix(tOutputFileKind kind)
+   {
+      return kind == DISTANCE_MATRIX_FILE || kind == TIME_MATRIX_FILE;
+   }
+
+   //! Returns true if two scenarios have the same sample of costumers (hence the same matrices)
+   bool sameSample(const tScenario& first, const tScenario& second)
+   {
+      return first.size == second.size && first.matrixSeed == second.matrixSeed &&
+             first.samplingMode == second.samplingMode && first.samplingRadius == second.samplingRadius &&
+             first.numberOfClusters == second.numberOfClusters && first.clusterProportions == second.clusterProportions;
+   }
+
+   //! Splits a list of scenarios into ranges [first, second) of consecutive scenarios with the same sample
+   void groupBySample(const std::vector<tScenario>& scenarios, std::vector<std::pair<size_t, size_t> >& groups)
+   {
+      groups.clear();
+      for (size_t i = 0; i < scenarios.size(); i++)
+         if (i > 0 && sameSample(scenarios[i - 1], scenarios[i]))
+            groups.back().second = i + 1;
+         else
+            groups.push_back(std::make_pair(i, i + 1));
+   }
+
+   //! Writes a file to disk
+   void writeFile(const std::string& fileName, const std::string& contents)
+   {
+      TextWriter file;
+      file.open(fileName);
+      file.write(contents.data(), contents.size());
+      file.close();
+   }
+
+   //! Flushes a file to disk
+   void syncFile(const std::string& fileName)
+   {
+      int descriptor = ::open(fileName.c_str(), O_RDONLY);
+      if (descriptor < 0)
+         throw std::runtime_error("Unable to open " + fileName + ": " + strerror(errno));
+      int result = fsync(descriptor);
+      ::close(descriptor);
+      if (result != 0)
+         throw std::runtime_error("Unable to write " + fileName + ": " + strerror(errno));
+   }
+
+   //! Returns true if a file has a given size and, if verify is true, a given checksum
+   bool checkFile(const std::string& fileName, uint64_t size, uint64_t checksum, bool verify)
+   {
+      struct stat status;
+      if (stat(fileName.c_str(), &status) != 0 || (uint64_t)status.st_size != size)
+         return false;
+      if (!verify)
+         return true;
+
+      std::ifstream file(fileName.c_str(), std::ios::binary);
+      char block[65536];
+      uint64_t hash = binaryInstanceHashSeed;
+      while (file.read(block, sizeof(block)) || file.gcount() > 0)
+         hash = binaryInstanceHash(hash, block, file.gcount());
+      return hash == checksum;
+   }
+
+   //! Returns true if a file has the given content (compared byte by byte)
+   bool sameContents(const std::string& fileName, const std::string& contents)
+   {
+      std::ifstream file(fileName.c_str(), std::ios::binary);
+      char block[65536];
+      size_t done = 0;
+      while (file.read(block, sizeof(block)) || file.gcount() > 0)
+      {
+         size_t length = file.gcount();
+         if (length > contents.size() - done || memcmp(block, contents.data() + done, length) != 0)
+            return false;
+         done += length;
+      }
+      return file.eof() && done == contents.size();
+   }
+
+   //! Makes a file a hard link to another one (false if the file system does not allow it)
+   bool linkFile(const std::string& target, const std::string& fileName)
+   {
+      if (unlink(fileName.c_str()) != 0 && errno != ENOENT)
+         return false;
+      return ::link(target.c_str(), fileName.c_str()) == 0;
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that finds the scenarios whose instances have been written
+  according to the journal: their files are the ones the scenario would
+  write and are still there. Within a pack, the entries recorded are
+  added back to its index (the pack must have been opened with the size
+  recorded in the journal).
+  @param scenarios is the list of scenarios.
+  @param pack is the pack of the batch (NULL if the files are written to disk).
+  @param remaining is where the scenarios still to be written are stored.
+  @throw std::runtime_error if the pack cannot be read.
+*/
+void BatchPipeline::resume(const std::vector<tScenario>& scenarios, PackWriter* pack, std::vector<tScenario>& remaining)
+{
+   const std::vector<Journal::tRecord>& records = this->journal->getRecords();
+
+   // The last record of each instance, if its files are still there
+   std::map<std::string, const Journal::tRecord*> written;
+   for (size_t r = 0; r < records.size(); r++)
+   {
+      bool found = true;
+      for (size_t i = 0; i < records[r].files.size() && found; i++)
+      {
+         const Journal::tFile& file = records[r].files[i];
+         if (pack != NULL)
+            found = pack->contains(file.offset, file.size, file.checksum, this->verifyChecksums);
+         else
+            found = checkFile(file.name, file.size, file.checksum, this->verifyChecksums);
+      }
+
+      if (found)
+         written[records[r].instance] = &records[r];
+      else
+         written.erase(records[r].instance);
+
+      // The entries of the pack are added back to its index
+      for (size_t i = 0; i < records[r].files.size() && found && pack != NULL; i++)
+      {
+         const Journal::tFile& file = records[r].files[i];
+         pack->recover(file.name, file.offset, file.size, file.checksum);
+      }
+   }
+
+   remaining.clear();
+   VRPTWInstanceGenerator generator(this->network);
+   std::vector<tOutputFile> files;
+   for (size_t i = 0; i < scenarios.size(); i++)
+   {
+      std::map<std::string, const Journal::tRecord*>::const_iterator record = written.find(scenarios[i].name);
+      bool done = (record != written.end());
+      if (done)
+      {
+         // The options of the scenario may have changed since it was written
+         generator.setScenario(scenarios[i]);
+         generator.getOutputFiles(files);
+         done = (files.size() == record->second->files.size());
+         for (size_t f = 0; f < files.size() && done; f++)
+            done = (files[f].second == record->second->files[f].name);
+      }
+
+      if (!done)
+         remaining.push_back(scenarios[i]);
+   }
+
+   std::cout << "Journal: " << scenarios.size() - remaining.size() << " of " << scenarios.size()
+             << " instances already written" << std::endl;
+}
+
+// --- Public --- //
+
+/**
+  Ctor.
+  @param network is the network the instances are drawn from.
+*/
+BatchPipeline::BatchPipeline(std::shared_ptr<const Network> network) : network(network), queueCapacity(2), generateThreads(0), formatThreads(0), deduplication(true),
+                                                                        journal(NULL), verifyChecksums(false)
+{
+}
+
+/**
+  Method that sets the max number of instances waiting between two stages.
+  @param capacity is the number of instances (at least 1).
+*/
+void BatchPipeline::setQueueCapacity(size_t capacity)
+{
+   this->queueCapacity = std::max<size_t>(capacity, 1);
+}
+
+/**
+  Method that sets the number of threads that generate instances.
+  @param threads is the number of threads (0 means as many as cores).
+*/
+void BatchPipeline::setGenerateThreads(unsigned threads)
+{
+   this->generateThreads = threads;
+}
+
+/**
+  Method that sets the number of threads that format instances.
+  @param threads is the number of threads (0 means as many as cores).
+*/
+void BatchPipeline::setFormatThreads(unsigned threads)
+{
+   this->formatThreads = threads;
+}
+
+/**
+  Method that sets whether identical matrices are stored only once.
+  @param deduplication is true to hard-link (or share within a pack) identical matrices.
+*/
+void BatchPipeline::setDeduplication(bool deduplication)
+{
+   this->deduplication = deduplication;
+}
+
+/**
+  Method that sets the journal where the instances written are recorded.
+  If it has records (the batch was interrupted), the batch is resumed.
+  @param journal is the journal, already open (NULL for none).
+  @param verifyChecksums is true to read the files recorded to verify
+         their checksums when resuming (otherwise, their sizes are checked).
+*/
+void BatchPipeline::setJournal(Journal* journal, bool verifyChecksums)
+{
+   this->journal = journal;
+   this->verifyChecksums = verifyChecksums;
+}
+
+/**
+  Method that generates and writes the instances of a list of scenarios.
+  The files are written (and announced) in the same order as generating
+  the scenarios one after the other would. Generators are not created per
+  instance: once formatted, a generator is reset and draws another one.
+  @param scenarios is the list of scenarios.
+  @param pack is the pack where the files are added (NULL to write them to disk).
+  @throw std::runtime_error if a file cannot be formatted or written.
+*/
+void BatchPipeline::run(const std::vector<tScenario>& batch, PackWriter* pack)
+{
+   std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+
+   // Instances already written (see setJournal) are skipped
+   std::vector<tScenario> remaining;
+   if (this->journal != NULL)
+      resume(batch, pack, remaining);
+   const std::vector<tScenario>& scenarios = (this->journal != NULL) ? remaining : batch;
+
+   unsigned formatters = this->formatThreads;
+   if (formatters == 0)
+      formatters = std::max(1u, std::thread::hardware_concurrency());
+   formatters = std::min<size_t>(formatters, std::max<size_t>(scenarios.size(), 1));
+
+   BoundedQueue<tGeneratedInstance> generated(this->queueCapacity);
+   BoundedQueue<tFormattedInstance> formatted(this->queueCapacity);
+
+   // Instances are generated at most a window ahead of the last one written
+   WorkStealingPool workers(this->generateThreads);
+   size_t window = workers.size() + formatters + 2 * this->queueCapacity;
+   size_t written = 0;
+   std::mutex windowMutex;
+   std::condition_variable windowMoved;
+
+   // Set when a stage fails, so that the others stop
+   std::atomic<bool> stopped(false);
+   std::string failure;
+   std::mutex failureMutex;
+   auto fail = [&](const std::string& message)
+   {
+      std::lock_guard<std::mutex> lock(failureMutex);
+      if (failure.empty())
+         failure = message;
+      stopped = true;
+      generated.close();
+      formatted.close();
+      {
+         // Workers waiting for the window check stopped while holding its mutex
+         std::lock_guard<std::mutex> windowLock(windowMutex);
+      }
+      windowMoved.notify_all();
+   };
+
+   // Scenarios that share a sample of costumers are generated by the same worker, one after the other
+   std::vector<std::pair<size_t, size_t> > groups;
+   groupBySample(scenarios, groups);
+
+   // Generators formatted are reset and reused (their memory is kept), so there are only as many as instances in flight
+   std::vector<std::unique_ptr<VRPTWInstanceGenerator> > spareGenerators;
+   std::mutex spareMutex;
+   auto takeGenerator = [&]()
+   {
+      std::lock_guard<std::mutex> lock(spareMutex);
+      if (spareGenerators.empty())
+         return std::unique_ptr<VRPTWInstanceGenerator>(new VRPTWInstanceGenerator(this->network));
+      std::unique_ptr<VRPTWInstanceGenerator> generator = std::move(spareGenerators.back());
+      spareGenerators.pop_back();
+      return generator;
+   };
+
+   // Generate stage: each worker generates its own instances from the shared network
+   std::thread generatorThread([&]()
+   {
+      try
+      {
+         workers.run(groups.size(), [&](size_t group, unsigned)
+         {
+            // The sample is drawn once; it is only copied for the instances that share it but the last one
+            std::unique_ptr<VRPTWInstanceGenerator> sample;
+            for (size_t i = groups[group].first; i < groups[group].second && !stopped; i++)
+            {
+               {
+                  std::unique_lock<std::mutex> lock(windowMutex);
+                  windowMoved.wait(lock, [&]() { return stopped || i < written + window; });
+               }
+
+               tGeneratedInstance instance;
+               instance.index = i;
+               std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+               if (!sample)
+               {
+                  sample = takeGenerator();
+                  sample->setScenario(scenarios[i]);
+                  sample->generateMatrices();
+               }
+               if (i + 1 < groups[group].second)
+               {
+                  instance.generator = takeGenerator();
+                  *instance.generator = *sample;
+               }
+               else
+                  instance.generator = std::move(sample);
+               instance.generator->setScenario(scenarios[i]);
+               instance.generator->generateSpecifications();
+               instance.generationTime = secondsSince(start);
+               if (!generated.push(std::move(instance)))
+                  break;
+            }
+         });
+      }
+      catch (const std::exception& exception)
+      {
+         fail(exception.what());
+      }
+      generated.close();
+   });
+
+   // Format stage: the last formatter to finish closes the queue of the write stage
+   std::atomic<unsigned> runningFormatters(formatters);
+   std::vector<std::thread> formatterThreads;
+   for (unsigned f = 0; f < formatters; f++)
+      formatterThreads.push_back(std::thread([&]()
+      {
+         tGeneratedInstance instance;
+         while (!stopped && generated.pop(instance))
+         {
+            tFormattedInstance output;
+            output.index = instance.index;
+            output.generationTime = instance.generationTime;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try
+            {
+               instance.generator->getOutputFiles(output.files);
+               output.contents.resize(output.files.size());
+               output.hashes.resize(output.files.size());
+               output.checksums.resize(output.files.size());
+               for (size_t i = 0; i < output.files.size(); i++)
+               {
+                  instance.generator->writeOutputToString(output.files[i].first, output.contents[i]);
+                  if (this->deduplication && isMatrix(output.files[i].first))
+                     output.hashes[i] = contentHash(output.contents[i].data(), output.contents[i].size());
+                  if (this->journal != NULL)
+                     output.checksums[i] = binaryInstanceHash(binaryInstanceHashSeed, output.contents[i].data(), output.contents[i].size());
+               }
+            }
+            catch (const std::exception& exception)
+            {
+               fail(exception.what());
+               break;
+            }
+            instance.generator->reset();
+            {
+               std::lock_guard<std::mutex> lock(spareMutex);
+               spareGenerators.push_back(std::move(instance.generator));
+            }
+            output.formattingTime = secondsSince(start);
+            if (!formatted.push(std::move(output)))
+               break;
+         }
+         if (--runningFormatters == 0)
+            formatted.close();
+      }));
+
+   // Write stage: instances formatted out of order wait for the previous ones
+   std::map<size_t, tFormattedInstance> pending;
+   std::map<std::pair<tContentHash, size_t>, tStoredMatrix> matrices;
+   // Key of the matrix stored in each file, whose entry is dropped if the file is written again
+   std::map<std::string, std::pair<tContentHash, size_t> > matrixFiles;
+   size_t nextInstance = 0;
+   size_t totalBytes = 0;
+
+   // Files written since the journal was last written to disk, which are flushed before it
+   std::vector<std::string> unsynced;
+   auto syncJournal = [&]()
+   {
+      if (pack != NULL)
+         pack->sync();
+      for (size_t i = 0; i < unsynced.size(); i++)
+         syncFile(unsynced[i]);
+      unsynced.clear();
+      this->journal->sync();
+   };
+
+   std::ios defaultFormat(NULL);
+   defaultFormat.copyfmt(std::cout);
+   tFormattedInstance instance;
+   while (!stopped && formatted.pop(instance))
+   {
+      pending[instance.index] = std::move(instance);
+      for (std::map<size_t, tFormattedInstance>::iterator next = pending.find(nextInstance);
+           next != pending.end() && !stopped; next = pending.find(++nextInstance))
+      {
+         tFormattedInstance& output = next->second;
+         std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+         size_t bytes = 0;
+         try
+         {
+            Journal::tRecord record;
+            record.instance = scenarios[nextInstance].name;
+            for (size_t i = 0; i < output.files.size(); i++)
+            {
+               const std::string& fileName = output.files[i].second;
+               const std::string& contents = output.contents[i];
+               VRPTWInstanceGenerator::announce(output.files[i]);
+               bytes += contents.size();
+
+               // A matrix already written is linked instead (once its bytes are confirmed, as hashes may collide)
+               tStoredMatrix* stored = NULL;
+               std::pair<tContentHash, size_t> key(output.hashes[i], contents.size());
+               if (this->deduplication && isMatrix(output.files[i].first))
+               {
+                  std::map<std::pair<tContentHash, size_t>, tStoredMatrix>::iterator match = matrices.find(key);
+                  if (match != matrices.end() &&
+                      (pack != NULL ? pack->equals(match->second.entry, contents.data(), contents.size())
+                                    : sameContents(match->second.fileName, contents)))
+                     stored = &match->second;
+               }
+
+               Journal::tFile file = { fileName, contents.size(), output.checksums[i], 0 };
+               if (pack != NULL)
+               {
+                  size_t entry = 0;
+                  if (stored != NULL)
+                  {
+                     entry = stored->entry;
+                     pack->link(fileName, entry);
+                  }
+                  else
+                  {
+                     entry = pack->append(fileName, contents.data(), contents.size());
+                     if (this->deduplication && isMatrix(output.files[i].first))
+                        matrices[key] = tStoredMatrix{ fileName, entry };
+                  }
+                  if (this->journal != NULL)
+                     file.offset = pack->entry(entry).offset;
+               }
+               else
+               {
+                  // A matrix stored in a file that is about to be replaced can no longer be linked to
+                  std::map<std::string, std::pair<tContentHash, size_t> >::iterator previous = matrixFiles.find(fileName);
+                  if (previous != matrixFiles.end() && (stored == NULL || stored->fileName != fileName))
+                  {
+                     std::map<std::pair<tContentHash, size_t>, tStoredMatrix>::iterator match = matrices.find(previous->second);
+                     if (match != matrices.end() && match->second.fileName == fileName)
+                        matrices.erase(match);
+                     matrixFiles.erase(previous);
+                  }
+
+                  if (stored == NULL || (stored->fileName != fileName && !linkFile(stored->fileName, fileName)))
+                  {
+                     writeFile(fileName, contents);
+                     if (stored == NULL && this->deduplication && isMatrix(output.files[i].first))
+                     {
+                        matrices[key] = tStoredMatrix{ fileName, 0 };
+                        matrixFiles[fileName] = key;
+                     }
+                  }
+                  if (this->journal != NULL)
+                     unsynced.push_back(fileName);
+               }
+               record.files.push_back(file);
+            }
+
+            if (this->journal != NULL)
+            {
+               this->journal->append(record);
+               if (this->journal->isSyncDue())
+                  syncJournal();
+            }
+         }
+         catch (const std::exception& exception)
+         {
+            fail(exception.what());
+         }
+
+         totalBytes += bytes;
+         std::cout << "Instance " << nextInstance + 1 << "/" << scenarios.size() << " (" << scenarios[nextInstance].name << "): "
+                   << std::fixed << std::setprecision(3)
+                   << "generated in " << output.generationTime << " s, formatted in " << output.formattingTime
+                   << " s, written in " << secondsSince(start) << " s, " << bytes / 1048576.0 << " MB" << std::endl;
+         std::cout.copyfmt(defaultFormat);
+         pending.erase(next);
+
+         {
+            std::lock_guard<std::mutex> lock(windowMutex);
+            written = nextInstance + 1;
+         }
+         windowMoved.notify_all();
+      }
+   }
+
+   generatorThread.join();
+   for (size_t f = 0; f < formatterThreads.size(); f++)
+      formatterThreads[f].join();
+
+   // The instances written are recorded even if the batch has failed
+   if (this->journal != NULL)
+   {
+      try
+      {
+         syncJournal();
+      }
+      catch (const std::exception& exception)
+      {
+         if (failure.empty())
+            failure = exception.what();
+      }
+   }
+
+   if (!failure.empty())
+      throw std::runtime_error(failure);
+
+   double elapsed = secondsSince(batchStart);
+   std::cout << std::fixed << std::setprecision(3) << "Batch: " << scenarios.size() << " instances in " << elapsed << " s ("
+             << scenarios.size() / elapsed << " instances/s, " << totalBytes / 1048576.0 / elapsed << " MB/s)" << std::endl;
+   std::cout.copyfmt(defaultFormat);
+}
+
+/**
+  Method that selects the scenarios of one of the shards of a batch. The
+  partition only depends on the list of scenarios, so processes that read
+  the same batch agree on it without communicating. Consecutive scenarios
+  with the same sample of costumers go to the same shard (their matrices
+  are generated once), and the groups are balanced by their cost (the
+  number of instances times the square of their size, as formatting the
+  matrices dominates): the most expensive group goes first to the shard
+  with the lowest cost so far.
+  @param scenarios is the list of scenarios of the whole batch.
+  @param shard is the shard (from 0 to shards - 1).
+  @param shards is the number of shards (at least 1).
+  @param selected is where the scenarios of the shard are stored (in the order of the batch).
+*/
+void BatchPipeline::shard(const std::vector<tScenario>& scenarios, unsigned shard, unsigned shards, std::vector<tScenario>& selected)
+{
+   std::vector<std::pair<size_t, size_t> > groups;
+   groupBySample(scenarios, groups);
+
+   std::vector<double> costs(groups.size());
+   for (size_t g = 0; g < groups.size(); g++)
+   {
+      double nodes = scenarios[groups[g].first].size + 1.0;
+      costs[g] = (groups[g].second - groups[g].first) * nodes * nodes;
+   }
+
+   // Ties are broken by the order of the groups and of the shards, so every process gets the same partition
+   std::vector<size_t> order(groups.size());
+   for (size_t g = 0; g < order.size(); g++)
+      order[g] = g;
+   std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) { return costs[a] > costs[b]; });
+
+   std::vector<double> loads(std::max(shards, 1u), 0.0);
+   std::vector<bool> taken(groups.size(), false);
+   for (size_t g = 0; g < order.size(); g++)
+   {
+      size_t lightest = std::min_element(loads.begin(), loads.end()) - loads.begin();
+      loads[lightest] += costs[order[g]];
+      taken[order[g]] = (lightest == shard);
+   }
+
+   selected.clear();
+   for (size_t g = 0; g < groups.size(); g++)
+      if (taken[g])
+         selected.insert(selected.end(), scenarios.begin() + groups[g].first, scenarios.begin() + groups[g].second);
+}
@@ -0,0 +1,128 @@
+#ifndef BATCHPIPELINE_H
+#define BATCHPIPELINE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dataTypes.h"
+
+class Journal;
+class PackWriter;
+class Network;
+
+/**
+  Pipelined generation of a batch of instances:
+     Three stages run at the same time, connected by bounded queues:
+        - Generate: the instances are generated (generateAll) by a pool of
+          workers with work stealing (see WorkStealingPool), each one with
+          its own generator, all of them sharing the network (read once).
+          Consecutive scenarios with the same sample of costumers (e.g. the
+          variants of a scenario) are generated by the same worker and
+          share it: their matrices are generated once, and only the
+          specifications of each one are.
+        - Format: the output files of each instance are formatted in memory
+          (several instances at the same time, one per thread).
+        - Write: the files are written to disk (or added to a pack) in the
+          order of the scenarios, by the thread that invokes run().
+     While an instance is being written, the next ones are being formatted
+     and generated, so the throughput approaches that of the slowest stage.
+     When a queue is full, the stage that feeds it waits (back-pressure),
+     hence at most a few instances are held in memory (workers do not get
+     further ahead of the last instance written than a few instances).
+     Every instance draws its random numbers from generators seeded with
+     its own seeds, so the files are the same whatever the number of
+     threads and the order in which instances are generated. The time employed
+     by each stage for each instance and the throughput of the whole batch
+     are reported as the instances are written.
+     Matrices are content-addressed (see contentHash): a matrix identical
+     to one already written in the batch, e.g. that of an instance that
+     only differs in its time windows or demands, is not written again,
+     but hard-linked to the previous file (or, within a pack, added as an
+     entry that shares the data of the previous one).
+     With a journal (see Journal), every instance written is recorded and
+     the batch can be resumed: the instances of the journal whose files
+     are still there (same names and sizes, and checksums if verified) are
+     skipped, and the rest are generated (a file that was being written
+     when the batch was interrupted is written again). Files are flushed
+     to disk before the journal records them.
+     A batch can be split into shards (see shard), generated by separate
+     processes, each one with its own pack (see PackWriter::merge).
+     Formatting and writing errors are reported by throwing
+     std::runtime_error; generation errors exit (see
+     VRPTWInstanceGenerator::error).
+*/
+class BatchPipeline
+{
+   private:
+      //! Network shared by the generators of all the instances
+      std::shared_ptr<const Network> network;
+
+      //! Max number of instances waiting in each queue
+      size_t queueCapacity;
+
+      //! Number of threads of the generate and format stages (0 means as many as cores)
+      unsigned generateThreads;
+      unsigned formatThreads;
+
+      //! If true, identical matrices are stored only once
+      bool deduplication;
+
+      //! Journal of the instances written (NULL if none) and whether checksums are verified when resuming
+      Journal* journal;
+      bool verifyChecksums;
+
+      //! Method that returns the scenarios that have not been written according to the journal
+      void resume(const std::vector<tScenario>&, PackWriter*, std::vector<tScenario>&);
+
+      //! Non-copyable
+      BatchPipeline(const BatchPipeline&);
+      BatchPipeline& operator=(const BatchPipeline&);
+
+   public:
+
+      //! Ctor.
+      /*!
+        \param network is the network the instances are drawn from (already read).
+      */
+      explicit BatchPipeline(std::shared_ptr<const Network> network);
+
+      //! Sets the max number of instances waiting between two stages (2 by default)
+      void setQueueCapacity(size_t);
+
+      //! Sets the number of threads that generate instances (0, the default, means as many as cores)
+      void setGenerateThreads(unsigned);
+
+      //! Sets the number of threads that format instances (0, the default, means as many as cores)
+      void setFormatThreads(unsigned);
+
+      //! Sets whether identical matrices are stored only once (true by default)
+      void setDeduplication(bool);
+
+      //! Sets the journal where the instances written are recorded and from which the batch is resumed
+      /*!
+        \param journal is the journal, already open (NULL for none, the default). It must outlive the pipeline.
+        \param verifyChecksums is true to read the files of the instances of the journal to verify them
+               (otherwise, only their sizes are checked).
+      */
+      void setJournal(Journal* journal, bool verifyChecksums = false);
+
+      //! Method that generates and writes the instances of a list of scenarios
+      /*!
+        \param scenarios is the list of scenarios.
+        \param pack is the pack where the files are added (NULL to write them to disk).
+      */
+      void run(const std::vector<tScenario>& scenarios, PackWriter* pack);
+
+      //! Method that selects the scenarios of one of the shards of a batch (the same ones in every process)
+      /*!
+        \param scenarios is the list of scenarios of the whole batch.
+        \param shard is the shard (from 0 to shards - 1).
+        \param shards is the number of shards.
+        \param selected is where the scenarios of the shard are stored (in the order of the batch).
+      */
+      static void shard(const std::vector<tScenario>& scenarios, unsigned shard, unsigned shards, std::vector<tScenario>& selected);
+};
+
+#endif // BATCHPIPELINE_H
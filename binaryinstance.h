@@ -0,0 +1,262 @@
+#ifndef BINARYINSTANCE_H
+#define BINARYINSTANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+  Binary instances (<prefix>Instance.bin):
+     The same information as the DistanceMatrix, TimeMatrix and Specs
+     files, ready to be mapped in memory by a solver:
+        - Header (tBinaryHeader, 128 bytes).
+        - Distance matrix: n x n doubles, row-major.
+        - Time matrix: n x n doubles, row-major.
+        - Costumers: n tBinaryCostumer (the depot first), as in the Specs file.
+     n is the number of costumers plus the depot. Every section starts at
+     an offset multiple of 64 (padding is zeroed). Values are stored in the
+     byte order of the machine that wrote the file, which is recorded in
+     the header. The checksum is the 64-bit FNV-1a hash of everything that
+     follows the header.
+     This file is header-only so that solvers only need to include it.
+   \code
+      BinaryInstanceReader instance("test100Instance.bin");
+      BinaryInstanceReader::MatrixView distances = instance.distances();
+      double d = distances(0, 5);
+   \endcode
+*/
+
+//! Header of a binary instance
+struct tBinaryHeader
+{
+    char magic[8];            // "MVRPTWIN"
+    uint32_t version;         // 1
+    uint32_t byteOrder;       // 0x01020304 written in the byte order of the file
+    uint32_t elementType;     // 1: IEEE 754 double (8 bytes)
+    uint32_t elementSize;     // sizeof(double)
+    uint32_t nodes;           // Costumers + depot
+    uint32_t fleetSize;       // Number of vehicles
+    int64_t capacity;         // Capacity of each vehicle
+    uint64_t distanceOffset;  // Offsets (from the start of the file) of each section
+    uint64_t timeOffset;
+    uint64_t costumersOffset;
+    uint64_t fileSize;
+    uint64_t checksum;        // FNV-1a of [sizeof(tBinaryHeader), fileSize)
+    char reserved[48];
+};
+
+//! Costumer of a binary instance (one row of the Specs file)
+struct tBinaryCostumer
+{
+    uint32_t id;
+    uint32_t reserved;
+    double lat;
+    double lng;
+    double demand;
+    double readyTime;
+    double dueDate;
+    double serviceTime;
+};
+
+static_assert(sizeof(tBinaryHeader) == 128, "Unexpected size of tBinaryHeader");
+static_assert(sizeof(tBinaryCostumer) == 56, "Unexpected size of tBinaryCostumer");
+
+//! Constants of the format
+const char binaryInstanceMagic[8] = {'M', 'V', 'R', 'P', 'T', 'W', 'I', 'N'};
+const uint32_t binaryInstanceVersion = 1;
+const uint32_t binaryInstanceByteOrder = 0x01020304;
+const uint32_t binaryInstanceDouble = 1;
+const uint64_t binaryInstanceAlignment = 64;
+
+//! Returns the offset aligned to the start of the next section
+inline uint64_t binaryInstanceAlign(uint64_t offset)
+{
+    return (offset + binaryInstanceAlignment - 1) / binaryInstanceAlignment * binaryInstanceAlignment;
+}
+
+//! Incremental 64-bit FNV-1a hash (start with binaryInstanceHashSeed)
+const uint64_t binaryInstanceHashSeed = 14695981039346656037ULL;
+
+inline uint64_t binaryInstanceHash(uint64_t hash, const void* data, size_t length)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+  Reader of binary instances:
+     The file is mapped in memory (read only) and the matrices and the
+     costumers are accessed in place, without copying nor parsing them.
+     Errors are reported by throwing std::runtime_error.
+*/
+class BinaryInstanceReader
+{
+   public:
+      //! Zero-copy view of a square matrix stored in the mapped file
+      class MatrixView
+      {
+         private:
+            const double* values;
+            size_t n;
+
+         public:
+            MatrixView(const double* values, size_t n) : values(values), n(n) {}
+
+            //! Value of row i, column j
+            double operator()(size_t i, size_t j) const { return this->values[i * this->n + j]; }
+
+            //! Pointer to the first value of row i (n contiguous values)
+            const double* row(size_t i) const { return this->values + i * this->n; }
+
+            //! Pointer to all the values (row-major)
+            const double* data() const { return this->values; }
+
+            //! Number of rows (and columns)
+            size_t size() const { return this->n; }
+      };
+
+   private:
+      //! Mapped file
+      const char* data;
+      size_t length;
+
+      //! Header of the file (within the mapping)
+      const tBinaryHeader* header;
+
+      //! Method that throws an error about the file
+      void fail(const std::string& fileName, const std::string& message)
+      {
+         close();
+         throw std::runtime_error(fileName + ": " + message);
+      }
+
+      //! Method that checks that a section lies within the file
+      bool fits(uint64_t offset, uint64_t size) const
+      {
+         return offset % binaryInstanceAlignment == 0 && offset <= this->length && size <= this->length - offset;
+      }
+
+      //! Non-copyable
+      BinaryInstanceReader(const BinaryInstanceReader&);
+      BinaryInstanceReader& operator=(const BinaryInstanceReader&);
+
+   public:
+
+      //! Default Ctor. Nothing is mapped until open() is invoked.
+      BinaryInstanceReader() : data(NULL), length(0), header(NULL) {}
+
+      //! Ctor. It maps the given file.
+      explicit BinaryInstanceReader(const char* fileName) : data(NULL), length(0), header(NULL)
+      {
+         open(fileName);
+      }
+
+      //! Dtor. It unmaps the file.
+      ~BinaryInstanceReader()
+      {
+         close();
+      }
+
+      //! Method that maps a binary instance and checks its header
+      void open(const char* fileName)
+      {
+         close();
+
+         int descriptor = ::open(fileName, O_RDONLY);
+         if (descriptor < 0)
+            throw std::runtime_error("Unable to open " + std::string(fileName));
+
+         struct stat status;
+         if (fstat(descriptor, &status) != 0 || (size_t)status.st_size < sizeof(tBinaryHeader))
+         {
+            ::close(descriptor);
+            throw std::runtime_error(std::string(fileName) + ": not a binary instance");
+         }
+
+         void* address = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+         ::close(descriptor);
+         if (address == MAP_FAILED)
+            throw std::runtime_error("Unable to map " + std::string(fileName));
+
+         this->data = static_cast<const char*>(address);
+         this->length = status.st_size;
+         this->header = reinterpret_cast<const tBinaryHeader*>(this->data);
+
+         if (memcmp(this->header->magic, binaryInstanceMagic, sizeof(binaryInstanceMagic)) != 0)
+            fail(fileName, "not a binary instance");
+         if (this->header->byteOrder != binaryInstanceByteOrder)
+            fail(fileName, "written with a different byte order");
+         if (this->header->version != binaryInstanceVersion)
+            fail(fileName, "unsupported version " + std::to_string(this->header->version));
+         if (this->header->elementType != binaryInstanceDouble || this->header->elementSize != sizeof(double))
+            fail(fileName, "unsupported type of element");
+
+         // Each matrix must fit in the file, checked before n * n * sizeof(double) may wrap
+         uint64_t n = this->header->nodes;
+         if (n > 0 && n > this->length / sizeof(double) / n)
+            fail(fileName, "truncated or corrupted file");
+         if (this->header->fileSize != this->length ||
+             !fits(this->header->distanceOffset, n * n * sizeof(double)) ||
+             !fits(this->header->timeOffset, n * n * sizeof(double)) ||
+             !fits(this->header->costumersOffset, n * sizeof(tBinaryCostumer)))
+            fail(fileName, "truncated or corrupted file");
+      }
+
+      //! Method that unmaps the file
+      void close()
+      {
+         if (this->data)
+            munmap(const_cast<char*>(this->data), this->length);
+         this->data = NULL;
+         this->length = 0;
+         this->header = NULL;
+      }
+
+      //! Method that checks the checksum (it reads the whole file)
+      bool verify() const
+      {
+         size_t start = sizeof(tBinaryHeader);
+         return binaryInstanceHash(binaryInstanceHashSeed, this->data + start, this->length - start) == this->header->checksum;
+      }
+
+      //! Returns the header of the file
+      const tBinaryHeader& getHeader() const { return *this->header; }
+
+      //! Returns the number of nodes (costumers + depot)
+      size_t size() const { return this->header->nodes; }
+
+      //! Returns the number of vehicles and their capacity
+      unsigned fleetSize() const { return this->header->fleetSize; }
+      long capacity() const { return this->header->capacity; }
+
+      //! Returns the distance and time matrices
+      MatrixView distances() const
+      {
+         return MatrixView(reinterpret_cast<const double*>(this->data + this->header->distanceOffset), this->header->nodes);
+      }
+
+      MatrixView times() const
+      {
+         return MatrixView(reinterpret_cast<const double*>(this->data + this->header->timeOffset), this->header->nodes);
+      }
+
+      //! Returns the costumers (the depot first)
+      const tBinaryCostumer* costumers() const
+      {
+         return reinterpret_cast<const tBinaryCostumer*>(this->data + this->header->costumersOffset);
+      }
+};
+
+#endif // BINARYINSTANCE_H
@@ -0,0 +1,79 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+  Queue between the stages of a pipeline:
+     A producer waits while the queue is full (back-pressure), so a fast
+     stage cannot get far ahead of a slow one, and a consumer waits while
+     it is empty. Closing the queue wakes everybody up: pending items can
+     still be popped, but nothing else can be pushed.
+*/
+template <typename T>
+class BoundedQueue
+{
+   private:
+      //! Items and max number of them
+      std::deque<T> items;
+      size_t capacity;
+
+      //! The producers have finished (or the pipeline has been stopped)
+      bool closed;
+
+      //! Mutex that guards the queue and conditions on which stages wait
+      std::mutex queueMutex;
+      std::condition_variable notFull;
+      std::condition_variable notEmpty;
+
+      //! Non-copyable
+      BoundedQueue(const BoundedQueue&);
+      BoundedQueue& operator=(const BoundedQueue&);
+
+   public:
+
+      //! Ctor.
+      /*!
+        \param capacity is the max number of items in the queue (at least 1).
+      */
+      explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1), closed(false) {}
+
+      //! Method that adds an item, waiting while the queue is full (false if it has been closed)
+      bool push(T item)
+      {
+         std::unique_lock<std::mutex> lock(this->queueMutex);
+         this->notFull.wait(lock, [this]() { return this->closed || this->items.size() < this->capacity; });
+         if (this->closed)
+            return false;
+         this->items.push_back(std::move(item));
+         this->notEmpty.notify_one();
+         return true;
+      }
+
+      //! Method that takes an item, waiting while the queue is empty (false if it is closed and empty)
+      bool pop(T& item)
+      {
+         std::unique_lock<std::mutex> lock(this->queueMutex);
+         this->notEmpty.wait(lock, [this]() { return this->closed || !this->items.empty(); });
+         if (this->items.empty())
+            return false;
+         item = std::move(this->items.front());
+         this->items.pop_front();
+         this->notFull.notify_one();
+         return true;
+      }
+
+      //! Method that closes the queue
+      void close()
+      {
+         std::lock_guard<std::mutex> lock(this->queueMutex);
+         this->closed = true;
+         this->notFull.notify_all();
+         this->notEmpty.notify_all();
+      }
+};
+
+#endif // BOUNDEDQUEUE_H
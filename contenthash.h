@@ -0,0 +1,110 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+  128-bit hash of the content of a file (MurmurHash3 x64_128, by Austin
+  Appleby, public domain):
+     It processes 16 bytes per step, so hashing a matrix takes a small
+     fraction of the time employed to format it. It is used to find
+     output files with the same content, never as a checksum of the
+     format (see binaryInstanceHash).
+*/
+struct tContentHash
+{
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const tContentHash& other) const { return this->low == other.low && this->high == other.high; }
+    bool operator<(const tContentHash& other) const
+    {
+        return this->high < other.high || (this->high == other.high && this->low < other.low);
+    }
+};
+
+namespace contenthash
+{
+   inline uint64_t rotate(uint64_t x, int r)
+   {
+      return (x << r) | (x >> (64 - r));
+   }
+
+   inline uint64_t mix(uint64_t k)
+   {
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccdULL;
+      k ^= k >> 33;
+      k *= 0xc4ceb9fe1a85ec53ULL;
+      k ^= k >> 33;
+      return k;
+   }
+
+   const uint64_t c1 = 0x87c37b91114253d5ULL;
+   const uint64_t c2 = 0x4cf5ad432745937fULL;
+}
+
+//! Returns the 128-bit hash of a block of bytes
+inline tContentHash contentHash(const void* data, size_t length, uint64_t seed = 0)
+{
+    using namespace contenthash;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const size_t blocks = length / 16;
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+
+    for (size_t i = 0; i < blocks; i++)
+    {
+        uint64_t k1, k2;
+        memcpy(&k1, bytes + i * 16, sizeof(k1));
+        memcpy(&k2, bytes + i * 16 + 8, sizeof(k2));
+
+        k1 *= c1; k1 = rotate(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotate(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotate(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotate(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    // Last 0 to 15 bytes
+    const unsigned char* tail = bytes + blocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    switch (length & 15)
+    {
+        case 15: k2 ^= uint64_t(tail[14]) << 48; // fall through
+        case 14: k2 ^= uint64_t(tail[13]) << 40; // fall through
+        case 13: k2 ^= uint64_t(tail[12]) << 32; // fall through
+        case 12: k2 ^= uint64_t(tail[11]) << 24; // fall through
+        case 11: k2 ^= uint64_t(tail[10]) << 16; // fall through
+        case 10: k2 ^= uint64_t(tail[9]) << 8;   // fall through
+        case  9: k2 ^= uint64_t(tail[8]);
+                 k2 *= c2; k2 = rotate(k2, 33); k2 *= c1; h2 ^= k2;
+                 // fall through
+        case  8: k1 ^= uint64_t(tail[7]) << 56;  // fall through
+        case  7: k1 ^= uint64_t(tail[6]) << 48;  // fall through
+        case  6: k1 ^= uint64_t(tail[5]) << 40;  // fall through
+        case  5: k1 ^= uint64_t(tail[4]) << 32;  // fall through
+        case  4: k1 ^= uint64_t(tail[3]) << 24;  // fall through
+        case  3: k1 ^= uint64_t(tail[2]) << 16;  // fall through
+        case  2: k1 ^= uint64_t(tail[1]) << 8;   // fall through
+        case  1: k1 ^= uint64_t(tail[0]);
+                 k1 *= c1; k1 = rotate(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= length;
+    h2 ^= length;
+    h1 += h2;
+    h2 += h1;
+    h1 = mix(h1);
+    h2 = mix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    tContentHash hash = { h1, h2 };
+    return hash;
+}
+
+#endif // CONTENTHASH_H
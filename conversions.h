@@ -34,15 +34,65 @@
 #ifndef CONVERSIONS_H
 #define CONVERSIONS_H
 
-#include <string>
-#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+
+/**
+   Function that receives a range of characters and returns the value converted to T.
+   It does not allocate memory (std::from_chars). Leading and trailing blanks
+   are ignored, but the rest of the range must be a valid number.
+   @param first is the first character of the range.
+   @param last is the end of the range.
+   @return value with the given value converted.
+   @throw std::invalid_argument if the range is not a number or it is out of range for T.
+*/
+template <typename T>
+inline T fromStringTo (const char* first, const char* last)
+{
+   while (first != last && isspace((unsigned char)*first))
+      first++;
+   while (last != first && isspace((unsigned char)*(last - 1)))
+      last--;
+
+   const char* begin = first;
+   // from_chars does not accept an explicit positive sign
+   if (first != last && *first == '+')
+      first++;
 
+   T result = T();
+   std::from_chars_result conversion = std::from_chars(first, last, result);
+   if (conversion.ec != std::errc() || conversion.ptr != last || first == last)
+      throw std::invalid_argument("Unable to convert \"" + std::string(begin, last) + "\"" +
+                                  ((conversion.ec == std::errc::result_out_of_range)? " (out of range)" : ""));
+   return result;
+}
+
+/**
+   Function that receives a C string and returns the value converted to T.
+   @param inputString is the string we want to convert (it may not be NULL).
+   @return value with the given value converted.
+   @throw std::invalid_argument if the string is NULL or it is not a number.
+*/
+template <typename T>
+inline T fromStringTo (const char* inputString)
+{
+   if (inputString == NULL)
+      throw std::invalid_argument("Unable to convert a missing value");
+   return fromStringTo<T>(inputString, inputString + strlen(inputString));
+}
 
 /**
    Function that receives a std::string and return a value converted to T.
    @param inputString is a constant reference to the string value we want to convert.
    @return value with the given value converted.
+   @throw std::invalid_argument if the string is not a number.
    @note this is specially useful when we read plain-text files with data.
    \code
       // This is just an example of its use.
@@ -53,15 +103,33 @@
 template <typename T>
 inline T fromStringTo (const std::string& inputString)
 {
-   T result;
-   std::istringstream stream(inputString);
-   assert(stream >> result);
-   return result;
-   // This must be done by launching an exception.
+   return fromStringTo<T>(inputString.data(), inputString.data() + inputString.size());
+}
+
+/**
+   Function that writes a number into a buffer without allocating memory
+   (std::to_chars). Floating-point values use the shortest representation
+   that reads back to the same value.
+   @param first is the first character of the buffer.
+   @param last is the end of the buffer.
+   @param something is the value we want to convert.
+   @return pointer to the end of the written characters.
+   @throw std::length_error if the buffer is too small.
+*/
+template <typename T>
+inline char* somethingToChars(char* first, char* last, const T& something)
+{
+   std::to_chars_result conversion = std::to_chars(first, last, something);
+   if (conversion.ec != std::errc())
+      throw std::length_error("Buffer too small to convert a value");
+   return conversion.ptr;
 }
 
 /**
    Function that receives a value (T) and return a std::string containing that value.
+   Numbers are converted with std::to_chars (floating-point values use the
+   shortest representation that reads back to the same value); any other type
+   is written through its operator<<.
    @param something is the value we want to convert.
    @return string with the given value.
    \code
@@ -71,7 +139,16 @@ inline T fromStringTo (const std::string& inputString)
    \endcode
 */
 template <typename T>
-inline std::string somethingToString(const T& something)
+inline typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, std::string>::type
+somethingToString(const T& something)
+{
+   char buffer[64];
+   return std::string(buffer, somethingToChars(buffer, buffer + sizeof(buffer), something));
+}
+
+template <typename T>
+inline typename std::enable_if<!std::is_arithmetic<T>::value || std::is_same<T, bool>::value, std::string>::type
+somethingToString(const T& something)
 {
    std::ostringstream outputStream;
    outputStream << something;
@@ -1,22 +1,11 @@
 #ifndef DATATYPES_H
 #define DATATYPES_H
 
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
-/**
-  Cost between nodes:
-     Structure to store the cost between pairs of node.
-*/
-struct tData
-{
-   unsigned from;
-   unsigned to;
-   double length;
-};
-
-typedef std::vector<tData> rawInfoVector;
-
-
 /**
 Position of the costumers:
   For each costumer, we will hold the the
@@ -33,6 +22,32 @@ struct tPos
 typedef std::vector<tPos> costumersPosType;
 
 
+/**
+Continuous Distribution Specification Structure:
+  Instead of discrete categories, an attribute can be drawn from a continuous
+  distribution. The meaning of the parameters depends on the type:
+     - Uniform: first = min, second = max.
+     - Normal: first = mean, second = standard deviation.
+     - LogNormal: first = mu, second = sigma (of the underlying normal).
+  Values are clipped to [min, max].
+*/
+enum tDistributionType
+{
+    NO_DISTRIBUTION,
+    UNIFORM_DISTRIBUTION,
+    NORMAL_DISTRIBUTION,
+    LOGNORMAL_DISTRIBUTION
+};
+
+struct tDistribution
+{
+    tDistributionType type;
+    double first;
+    double second;
+    double min;
+    double max;
+};
+
 /**
 Time Window Scepecifications Structure:
   In order to avoid the use of inheritance and reduce
@@ -56,6 +71,10 @@ struct tTimeWindow
 {
     tTimeWindowDepot timeWindowDepot;
     std::vector<tTimeWindowCostumer> timeWindowsCostumers;
+    // If set, time windows open at a time drawn from opensDistribution
+    //   and last a time drawn from widthDistribution.
+    tDistribution opensDistribution;
+    tDistribution widthDistribution;
 };
 
 /**
@@ -75,6 +94,7 @@ struct tDemand
 {
     unsigned delta;
     std::vector<tDemandCostumer> demandsCostumers;
+    tDistribution distribution;
 };
 
 /**
@@ -89,7 +109,11 @@ struct tServiceTimeCostumer
    unsigned probability;
 };
 
-typedef std::vector<tServiceTimeCostumer> tServiceTime;
+struct tServiceTime
+{
+   std::vector<tServiceTimeCostumer> serviceTimesCostumers;
+   tDistribution distribution;
+};
 
 /**
 Solomon-like Specification Structure
@@ -108,6 +132,78 @@ struct tSolomon
     unsigned long serviceTime;
 };
 
+/**
+Compiled Specifications:
+  Specifications as read from the files together with the accumulative
+  probabilities employed to select their categories randomly (roulette
+  wheel), which are computed only once.
+*/
+struct tTimeWindowSpec
+{
+    tTimeWindow timeWindows;
+    std::vector<double> accProbability;
+};
+
+struct tDemandSpec
+{
+    tDemand demands;
+    std::vector<double> accProbability;
+};
+
+struct tServiceTimeSpec
+{
+    tServiceTime serviceTimes;
+    std::vector<double> accProbability;
+};
+
+/**
+Scenario:
+  Everything needed to generate one instance (see ScenarioFile): size,
+  seeds, selection of costumers, compiled specifications and output options.
+*/
+struct tScenario
+{
+    std::string name;
+    unsigned size;
+
+    unsigned matrixSeed;
+    unsigned timeWindowSeed;
+    unsigned demandSeed;
+    unsigned serviceTimeSeed;
+
+    std::string samplingMode;
+    double samplingRadius;
+    unsigned numberOfClusters;
+    std::vector<double> clusterProportions;
+    bool reachableTimeWindows;
+    unsigned demandScenarios;
+
+    std::shared_ptr<const tTimeWindowSpec> timeWindows;
+    std::shared_ptr<const tDemandSpec> demands;
+    std::shared_ptr<const tServiceTimeSpec> serviceTimes;
+
+    std::string prefix;
+    std::string matrixFormat;
+    int matrixPrecision;
+    bool binaryOutput;
+    std::string compression;
+};
+
+/**
+Output files:
+  Kinds of files written for an instance, and the kind with the path of a file.
+*/
+enum tOutputFileKind
+{
+    DISTANCE_MATRIX_FILE,
+    TIME_MATRIX_FILE,
+    SPECIFICATIONS_FILE,
+    DEMAND_SCENARIOS_FILE,
+    BINARY_INSTANCE_FILE
+};
+
+typedef std::pair<tOutputFileKind, std::string> tOutputFile;
+
 /**
  Generic Data Types
 */
@@ -125,4 +221,35 @@ typedef std::vector<std::vector<double> > matrixType;
 */
 typedef std::vector<double> accProbabilityType;
 
+/**
+Instance:
+  Everything generated for one instance from a network: the costumers drawn
+  (indexes within the ids of the network, the depot first), the matrices,
+  the categories and values of each costumer (index 0 is the depot), the
+  fleet and the stochastic demand scenarios (see VRPTWInstanceGenerator).
+*/
+struct tInstance
+{
+    std::vector<unsigned> randomIds;
+
+    matrixType distanceMatrix;
+    matrixType timeMatrix;
+
+    std::vector<unsigned> timeWindowsIndexes;
+    idsType demandsIndexes;
+    idsType serviceTimesIndexes;
+
+    std::vector<double> opensValues;
+    std::vector<double> closesValues;
+    std::vector<double> demandValues;
+    std::vector<double> serviceTimeValues;
+
+    unsigned sizeOfFleet;
+    capacityType vehicleMaxCapacity;
+
+    std::vector<unsigned> scenarioDemands;
+    std::vector<unsigned> scenarioFleetSizes;
+    std::vector<capacityType> scenarioCapacities;
+};
+
 #endif // DATATYPES_H
@@ -0,0 +1,137 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "distributions.h"
+
+/**
+  Function that returns a distribution that is not set.
+  @return a distribution of type NO_DISTRIBUTION.
+*/
+tDistribution noDistribution()
+{
+   tDistribution distribution;
+   distribution.type = NO_DISTRIBUTION;
+   distribution.first = 0;
+   distribution.second = 0;
+   distribution.min = 0;
+   distribution.max = std::numeric_limits<double>::max();
+   return distribution;
+}
+
+/**
+  Function that translates the name of a distribution to its type.
+  @param name is the name of the distribution (uniform, normal or lognormal).
+  @param type is the type of distribution found.
+  @return false if the name is unknown.
+*/
+bool distributionTypeFromString(const std::string& name, tDistributionType& type)
+{
+   if (name == "uniform")
+      type = UNIFORM_DISTRIBUTION;
+   else if (name == "normal")
+      type = NORMAL_DISTRIBUTION;
+   else if (name == "lognormal")
+      type = LOGNORMAL_DISTRIBUTION;
+   else
+      return false;
+   return true;
+}
+
+/**
+  Function that draws n values of a distribution in batch.
+  @param distribution is the distribution to sample.
+  @param randomGenerator is the generator of uniform numbers.
+  @param n is the number of values.
+  @param values is the vector (resized to n) where values are stored.
+*/
+void sampleDistribution(const tDistribution& distribution, MTRand& randomGenerator, size_t n, std::vector<double>& values)
+{
+   const double twoPi = 2.0 * 3.14159265358979323846;
+
+   values.resize(n);
+   if (n == 0)
+      return;
+
+   switch (distribution.type)
+   {
+      case UNIFORM_DISTRIBUTION:
+      {
+         double width = distribution.second - distribution.first;
+         for (size_t i = 0; i < n; i++)
+            values[i] = randomGenerator.rand();
+         for (size_t i = 0; i < n; i++)
+            values[i] = distribution.first + width * values[i];
+         break;
+      }
+      case NORMAL_DISTRIBUTION:
+      case LOGNORMAL_DISTRIBUTION:
+      {
+         // Box-Muller: both values of each pair are employed
+         size_t pairs = (n + 1) / 2;
+         std::vector<double> radius(pairs);
+         std::vector<double> angle(pairs);
+         for (size_t i = 0; i < pairs; i++)
+         {
+            radius[i] = 1.0 - randomGenerator.randDblExc();
+            angle[i] = randomGenerator.randExc();
+         }
+         for (size_t i = 0; i < pairs; i++)
+         {
+            radius[i] = sqrt(-2.0 * log(radius[i])) * distribution.second;
+            angle[i] *= twoPi;
+         }
+
+         values.resize(2 * pairs);
+         for (size_t i = 0; i < pairs; i++)
+         {
+            values[2 * i] = distribution.first + radius[i] * cos(angle[i]);
+            values[2 * i + 1] = distribution.first + radius[i] * sin(angle[i]);
+         }
+         values.resize(n);
+
+         if (distribution.type == LOGNORMAL_DISTRIBUTION)
+            for (size_t i = 0; i < n; i++)
+               values[i] = exp(values[i]);
+         break;
+      }
+      default:
+         std::fill(values.begin(), values.end(), 0.0);
+         return;
+   }
+
+   for (size_t i = 0; i < n; i++)
+      values[i] = std::min(std::max(values[i], distribution.min), distribution.max);
+}
@@ -0,0 +1,34 @@
+#ifndef DISTRIBUTIONS_H
+#define DISTRIBUTIONS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "dataTypes.h"
+#include "MersenneTwister.h"
+
+/**
+  Batched sampling of continuous distributions:
+     All the uniform numbers are drawn first from the generator and then
+     transformed in separate loops over contiguous arrays (Box-Muller
+     produces two normal values per pair of uniforms), so the transforms
+     can be vectorised and there is no per-value call overhead.
+*/
+
+//! Returns a distribution that is not set (categories are used instead)
+tDistribution noDistribution();
+
+//! Returns the type of distribution given its name (uniform, normal or lognormal)
+bool distributionTypeFromString(const std::string& name, tDistributionType& type);
+
+//! Method that draws n values of a distribution
+/*!
+  \param distribution is the distribution to sample.
+  \param randomGenerator is the generator of uniform numbers.
+  \param n is the number of values.
+  \param values is the vector (resized to n) where values are stored.
+*/
+void sampleDistribution(const tDistribution& distribution, MTRand& randomGenerator, size_t n, std::vector<double>& values);
+
+#endif // DISTRIBUTIONS_H
@@ -0,0 +1,346 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binaryinstance.h"
+#include "journal.h"
+
+namespace
+{
+   //! Returns a 64-bit value in hexadecimal (16 digits)
+   std::string hexadecimal(uint64_t value)
+   {
+      char digits[17];
+      snprintf(digits, sizeof(digits), "%016" PRIx64, value);
+      return std::string(digits, 16);
+   }
+
+   //! Reads the next field of a line (they are separated by tabs), false if there is none
+   bool nextField(const char*& current, const char* end, std::string& field)
+   {
+      if (current >= end)
+         return false;
+      const char* tab = static_cast<const char*>(memchr(current, '\t', end - current));
+      if (tab == NULL)
+         tab = end;
+      field.assign(current, tab);
+      current = (tab < end) ? tab + 1 : end;
+      return true;
+   }
+
+   //! Reads the next field of a line as an integer (decimal or, if hexadecimal is true, hexadecimal)
+   bool nextNumber(const char*& current, const char* end, uint64_t& value, bool hexadecimal = false)
+   {
+      std::string field;
+      if (!nextField(current, end, field) || field.empty())
+         return false;
+      char* last = NULL;
+      errno = 0;
+      value = strtoull(field.c_str(), &last, hexadecimal ? 16 : 10);
+      return errno == 0 && *last == '\0';
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that appends a line to the buffer, followed by the checksum of
+  everything that precedes it in the line.
+  @param line is the line (fields followed by a tab, it is modified).
+*/
+void Journal::appendLine(std::string& line)
+{
+   line += hexadecimal(binaryInstanceHash(binaryInstanceHashSeed, line.data(), line.size()));
+   line += '\n';
+   this->buffer += line;
+}
+
+/**
+  Method that parses a line of the journal:
+     "pack <size> <checksum>" or
+     "instance <name> <files> (<file> <size> <checksum> <offset>)... <checksum>".
+  @param first is the first character of the line.
+  @param last is the end of the line (its new line character).
+  @return false if the line is not valid (e.g. it is torn).
+*/
+bool Journal::parseLine(const char* first, const char* last)
+{
+   // The checksum of the line is its last field
+   const char* checksumField = last;
+   while (checksumField > first && *(checksumField - 1) != '\t')
+      checksumField--;
+   uint64_t checksum = 0;
+   const char* current = checksumField;
+   if (checksumField == first || !nextNumber(current, last, checksum, true) ||
+       binaryInstanceHash(binaryInstanceHashSeed, first, checksumField - first) != checksum)
+      return false;
+
+   current = first;
+   std::string kind;
+   nextField(current, checksumField, kind);
+   if (kind == "pack")
+      return nextNumber(current, checksumField, this->packSize);
+
+   tRecord record;
+   uint64_t files = 0;
+   if (kind != "instance" || !nextField(current, checksumField, record.instance) || !nextNumber(current, checksumField, files))
+      return false;
+   record.files.resize(files);
+   for (size_t i = 0; i < record.files.size(); i++)
+   {
+      tFile& file = record.files[i];
+      if (!nextField(current, checksumField, file.name) || !nextNumber(current, checksumField, file.size) ||
+          !nextNumber(current, checksumField, file.checksum, true) || !nextNumber(current, checksumField, file.offset))
+         return false;
+   }
+   this->records.push_back(record);
+   return true;
+}
+
+// --- Public --- //
+
+/**
+  Default Ctor.
+*/
+Journal::Journal() : descriptor(-1), packSize(0), bufferedRecords(0), syncRecords(64), syncSeconds(5)
+{
+}
+
+/**
+  Dtor. It writes the pending records (errors are ignored, call close() to detect them).
+*/
+Journal::~Journal()
+{
+   try
+   {
+      close();
+   }
+   catch (const std::exception&)
+   {
+   }
+}
+
+/**
+  Method that opens a journal. If the file exists, its records are read
+  (a torn or corrupted line and the lines after it are discarded, and the
+  file is truncated there) and the new ones are appended after them;
+  otherwise, it is created.
+  @param fileName is the path to the journal.
+  @throw std::runtime_error if it cannot be opened.
+*/
+void Journal::open(const std::string& fileName)
+{
+   close();
+   this->fileName = fileName;
+   this->records.clear();
+   this->packSize = 0;
+
+   this->descriptor = ::open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+   if (this->descriptor < 0)
+      throw std::runtime_error("Unable to open " + fileName + ": " + strerror(errno));
+
+   std::string contents;
+   char block[65536];
+   ssize_t length;
+   while ((length = ::read(this->descriptor, block, sizeof(block))) != 0)
+   {
+      if (length < 0 && errno == EINTR)
+         continue;
+      if (length < 0)
+      {
+         ::close(this->descriptor);
+         this->descriptor = -1;
+         throw std::runtime_error("Unable to read " + fileName + ": " + strerror(errno));
+      }
+      contents.append(block, length);
+   }
+
+   size_t valid = 0;
+   while (valid < contents.size())
+   {
+      size_t newLine = contents.find('\n', valid);
+      if (newLine == std::string::npos || !parseLine(contents.data() + valid, contents.data() + newLine))
+         break;
+      valid = newLine + 1;
+   }
+
+   if ((valid < contents.size() && ftruncate(this->descriptor, valid) != 0) || lseek(this->descriptor, valid, SEEK_SET) < 0)
+   {
+      ::close(this->descriptor);
+      this->descriptor = -1;
+      throw std::runtime_error("Unable to write " + fileName + ": " + strerror(errno));
+   }
+   this->lastSync = std::chrono::steady_clock::now();
+}
+
+/**
+  Method that writes the pending records and closes the journal.
+  @throw std::runtime_error if they cannot be written.
+*/
+void Journal::close()
+{
+   if (this->descriptor < 0)
+      return;
+
+   std::string message;
+   try
+   {
+      sync();
+   }
+   catch (const std::runtime_error& exception)
+   {
+      message = exception.what();
+   }
+
+   ::close(this->descriptor);
+   this->descriptor = -1;
+   this->buffer.clear();
+   this->bufferedRecords = 0;
+   if (!message.empty())
+      throw std::runtime_error(message);
+}
+
+/**
+  Method that returns the records read when the journal was opened.
+  @return the records, in the order they were appended.
+*/
+const std::vector<Journal::tRecord>& Journal::getRecords() const
+{
+   return this->records;
+}
+
+/**
+  Method that returns the size of the pack of the batch when it was first
+  opened with this journal: the entries written after that offset are
+  recovered from the records.
+  @return the size in bytes (0 if the batch is not written to a pack).
+*/
+uint64_t Journal::getPackSize() const
+{
+   return this->packSize;
+}
+
+/**
+  Method that sets the size of the pack of the batch when it is first
+  opened with this journal. It is written by the next sync.
+  @param size is the size in bytes.
+*/
+void Journal::setPackSize(uint64_t size)
+{
+   this->packSize = size;
+   std::string line = "pack\t" + std::to_string(size) + "\t";
+   appendLine(line);
+}
+
+/**
+  Method that adds a record. It is kept in memory until the next sync.
+  @param record is the instance and its files.
+*/
+void Journal::append(const tRecord& record)
+{
+   std::string line = "instance\t" + record.instance + "\t" + std::to_string(record.files.size()) + "\t";
+   for (size_t i = 0; i < record.files.size(); i++)
+   {
+      const tFile& file = record.files[i];
+      line += file.name + "\t" + std::to_string(file.size) + "\t" + hexadecimal(file.checksum) + "\t" + std::to_string(file.offset) + "\t";
+   }
+   appendLine(line);
+   this->bufferedRecords++;
+}
+
+/**
+  Method that tells whether the records kept in memory should be written,
+  that is, there are as many as set by setSyncInterval or the oldest one
+  has been kept for longer than it allows.
+  @return true if sync() should be invoked.
+*/
+bool Journal::isSyncDue() const
+{
+   if (this->bufferedRecords == 0)
+      return false;
+   return this->bufferedRecords >= this->syncRecords ||
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - this->lastSync).count() >= this->syncSeconds;
+}
+
+/**
+  Method that writes the records kept in memory and flushes the journal to
+  disk. The files they describe must have been flushed before.
+  @throw std::runtime_error if they cannot be written.
+*/
+void Journal::sync()
+{
+   if (this->descriptor < 0)
+      throw std::runtime_error("The journal is not open");
+
+   const char* data = this->buffer.data();
+   size_t length = this->buffer.size();
+   while (length > 0)
+   {
+      ssize_t written = ::write(this->descriptor, data, length);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         throw std::runtime_error("Unable to write " + this->fileName + ": " + strerror(errno));
+      }
+      data += written;
+      length -= written;
+   }
+
+   if (!this->buffer.empty() && fdatasync(this->descriptor) != 0)
+      throw std::runtime_error("Unable to write " + this->fileName + ": " + strerror(errno));
+
+   this->buffer.clear();
+   this->bufferedRecords = 0;
+   this->lastSync = std::chrono::steady_clock::now();
+}
+
+/**
+  Method that sets how often the records are written to disk.
+  @param records is the max number of records kept in memory (at least 1).
+  @param seconds is the max time (s) a record is kept in memory.
+*/
+void Journal::setSyncInterval(size_t records, double seconds)
+{
+   this->syncRecords = std::max<size_t>(records, 1);
+   this->syncSeconds = seconds;
+}
@@ -0,0 +1,124 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+  Journal of a batch (checkpoint to resume it):
+     An append-only text file with a line per instance whose output files
+     have been written, with the size and the checksum (64-bit FNV-1a, see
+     binaryinstance.h) of each file and, within a pack, the offset of its
+     data. If the batch is interrupted, it is resumed by running it again
+     with the same journal: the instances it records are not generated
+     again (see BatchPipeline::setJournal).
+     Records are kept in memory and written in batches: sync() writes them
+     and flushes the file to disk (fdatasync), so a record never reaches
+     the disk before the files it describes, provided that these have been
+     flushed first. Every line ends with its own checksum; a torn or
+     corrupted line (e.g. the last one, if the machine went down while it
+     was written) and everything after it are discarded when the journal
+     is opened.
+     Errors are reported by throwing std::runtime_error.
+     Fields are separated by tabs (shown as <TAB>): the kind of line, the
+     instance, its number of files, the name, size, checksum and offset of
+     each file, and the checksum of the line. E.g.:
+   \code
+      instance<TAB>test100-0-0-0-0.d0.tw0<TAB>3<TAB>test100-0-0-0-0.d0.tw0DistanceMatrix.dat<TAB>81003<TAB>9f1c...<TAB>0<TAB>...<TAB>5ab2...
+   \endcode
+     A batch written to a pack also records its size when the journal was
+     created ("pack<TAB><size><TAB><checksum>").
+*/
+class Journal
+{
+   public:
+      //! Output file of an instance
+      struct tFile
+      {
+         std::string name;
+         uint64_t size;
+         uint64_t checksum;
+         uint64_t offset;      // Offset of the data within the pack (0 if it is not in a pack)
+      };
+
+      //! Instance whose files have been written
+      struct tRecord
+      {
+         std::string instance;
+         std::vector<tFile> files;
+      };
+
+   private:
+      //! File descriptor (-1 if it is not open) and name of the file
+      int descriptor;
+      std::string fileName;
+
+      //! Records read when the journal was opened
+      std::vector<tRecord> records;
+
+      //! Size of the pack the first time it was opened with this journal (0 if none)
+      uint64_t packSize;
+
+      //! Lines not written yet
+      std::string buffer;
+      size_t bufferedRecords;
+
+      //! Records and seconds between two writes to disk
+      size_t syncRecords;
+      double syncSeconds;
+      std::chrono::steady_clock::time_point lastSync;
+
+      //! Method that appends a line (followed by its checksum) to the buffer
+      void appendLine(std::string&);
+
+      //! Method that parses a line (false if it is not valid)
+      bool parseLine(const char*, const char*);
+
+      //! Non-copyable
+      Journal(const Journal&);
+      Journal& operator=(const Journal&);
+
+   public:
+
+      //! Default Ctor.
+      Journal();
+
+      //! Dtor. It writes the pending records (errors are ignored, call close() to detect them).
+      ~Journal();
+
+      //! Method that opens a journal (it is created if it does not exist, otherwise its records are read)
+      void open(const std::string& fileName);
+
+      //! Method that writes the pending records and closes the file
+      void close();
+
+      //! Returns the records read when the journal was opened
+      const std::vector<tRecord>& getRecords() const;
+
+      //! Returns the size of the pack when it was first opened with the journal (0 if none)
+      uint64_t getPackSize() const;
+
+      //! Sets the size of the pack when it is first opened with the journal
+      void setPackSize(uint64_t);
+
+      //! Method that adds a record (it is written by the next sync)
+      void append(const tRecord&);
+
+      //! Returns true if the records kept in memory should be written (see setSyncInterval)
+      bool isSyncDue() const;
+
+      //! Method that writes the records kept in memory and flushes the file to disk
+      void sync();
+
+      //! Sets how often the records are written (64 instances or 5 seconds by default)
+      /*!
+        \param records is the max number of records kept in memory.
+        \param seconds is the max time (s) a record is kept in memory.
+      */
+      void setSyncInterval(size_t records, double seconds);
+};
+
+#endif // JOURNAL_H
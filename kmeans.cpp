@@ -0,0 +1,331 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "kmeans.h"
+#include "MersenneTwister.h"
+
+namespace
+{
+   //! Number of positions processed at once by a thread
+   const size_t chunkSize = 4096;
+
+   /**
+     Distance kernel: for a block of positions, it updates the closest
+     centre found so far with respect to centre c. The loop has no branches
+     so that it can be vectorised.
+   */
+   void closestCentre(const double* __restrict xs, const double* __restrict ys, size_t n,
+                      double cx, double cy, unsigned c,
+                      double* __restrict best, unsigned* __restrict closest)
+   {
+      for (size_t i = 0; i < n; i++)
+      {
+         double dx = xs[i] - cx;
+         double dy = ys[i] - cy;
+         double d = dx * dx + dy * dy;
+         bool closer = d < best[i];
+         best[i] = closer? d : best[i];
+         closest[i] = closer? c : closest[i];
+      }
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that chooses the initial centres following k-means++: the first one
+  at random and the following ones with probability proportional to the
+  squared distance to the closest centre already chosen.
+*/
+void KMeans::initialise()
+{
+   MTRand randomGenerator(this->seed);
+   size_t n = this->xs.size();
+
+   this->centresX.clear();
+   this->centresY.clear();
+
+   size_t first = randomGenerator.randInt(n - 1);
+   this->centresX.push_back(this->xs[first]);
+   this->centresY.push_back(this->ys[first]);
+
+   std::vector<double> best(n, std::numeric_limits<double>::max());
+   std::vector<unsigned> closest(n, 0);
+   for (unsigned c = 1; c < this->k; c++)
+   {
+      closestCentre(&this->xs[0], &this->ys[0], n, this->centresX[c - 1], this->centresY[c - 1], c - 1, &best[0], &closest[0]);
+
+      double sum = 0;
+      for (size_t i = 0; i < n; i++)
+         sum += best[i];
+
+      // All positions are already centres, pick any
+      size_t chosen = n - 1;
+      double target = randomGenerator.randExc(sum);
+      for (size_t i = 0; i < n && sum > 0; i++)
+      {
+         target -= best[i];
+         if (target < 0)
+         {
+            chosen = i;
+            break;
+         }
+      }
+
+      this->centresX.push_back(this->xs[chosen]);
+      this->centresY.push_back(this->ys[chosen]);
+   }
+}
+
+/**
+  Method that assigns the positions in a chunk to their closest centre.
+  @param chunk is the index of the chunk.
+  @param sumX is the sum of the x coordinates for each cluster (k values).
+  @param sumY is the sum of the y coordinates for each cluster (k values).
+  @param count is the number of positions of each cluster (k values).
+  @param changed is the number of positions whose cluster has changed.
+*/
+void KMeans::assignChunk(size_t chunk, double* sumX, double* sumY, unsigned* count, unsigned* changed)
+{
+   size_t from = chunk * chunkSize;
+   size_t n = std::min(chunkSize, this->xs.size() - from);
+
+   double best[chunkSize];
+   unsigned closest[chunkSize];
+   std::fill(best, best + n, std::numeric_limits<double>::max());
+   std::fill(closest, closest + n, 0u);
+
+   for (unsigned c = 0; c < this->k; c++)
+      closestCentre(&this->xs[from], &this->ys[from], n, this->centresX[c], this->centresY[c], c, best, closest);
+
+   std::fill(sumX, sumX + this->k, 0.0);
+   std::fill(sumY, sumY + this->k, 0.0);
+   std::fill(count, count + this->k, 0u);
+   *changed = 0;
+   for (size_t i = 0; i < n; i++)
+   {
+      unsigned c = closest[i];
+      sumX[c] += this->xs[from + i];
+      sumY[c] += this->ys[from + i];
+      count[c]++;
+      if (this->assignment[from + i] != c)
+      {
+         this->assignment[from + i] = c;
+         (*changed)++;
+      }
+   }
+}
+
+// --- Public --- //
+
+/**
+  Ctor. It sets default values for data members.
+  @param k is the number of clusters.
+  @param seed is the seed of the k-means++ initialisation.
+*/
+KMeans::KMeans(unsigned k, unsigned seed)
+{
+   this->k = k;
+   this->seed = seed;
+   this->threads = 0;
+   this->maxIterations = 100;
+}
+
+/**
+  Method to set the number of threads.
+  @param threads is the number of threads (0 means as many as cores).
+*/
+void KMeans::setThreads(unsigned threads)
+{
+   this->threads = threads;
+}
+
+/**
+  Method to set the max number of iterations.
+  @param maxIterations is the max number of Lloyd steps.
+*/
+void KMeans::setMaxIterations(unsigned maxIterations)
+{
+   this->maxIterations = maxIterations;
+}
+
+/**
+  Method that computes the clusters. It stops when no position changes its
+  cluster or after the max number of iterations.
+  @param positions is the vector of positions to be clustered.
+*/
+void KMeans::run(const costumersPosType& positions)
+{
+   size_t n = positions.size();
+   this->assignment.assign(n, this->k);
+   if (n == 0 || this->k == 0)
+      return;
+   this->k = std::min<size_t>(this->k, n);
+
+   // Equirectangular projection around the mean latitude
+   double meanLat = 0;
+   for (size_t i = 0; i < n; i++)
+      meanLat += positions[i].lat;
+   double referenceCos = cos(meanLat / n * 3.14159265358979323846 / 180.0);
+
+   this->xs.resize(n);
+   this->ys.resize(n);
+   for (size_t i = 0; i < n; i++)
+   {
+      this->xs[i] = positions[i].lng * referenceCos;
+      this->ys[i] = positions[i].lat;
+   }
+
+   initialise();
+
+   size_t chunks = (n + chunkSize - 1) / chunkSize;
+   unsigned workers = this->threads? this->threads : std::thread::hardware_concurrency();
+   workers = std::max(1u, std::min<unsigned>(workers, chunks));
+
+   std::vector<double> sumX(chunks * this->k);
+   std::vector<double> sumY(chunks * this->k);
+   std::vector<unsigned> count(chunks * this->k);
+   std::vector<unsigned> changed(chunks);
+
+   // Chunks are statically interleaved among the workers, which are started
+   //   once and wait for each iteration (the calling thread is worker 0)
+   std::mutex stepMutex;
+   std::condition_variable stepStarted;
+   std::condition_variable stepFinished;
+   unsigned step = 0;
+   unsigned pending = 0;
+   bool finished = false;
+
+   auto assignChunks = [&](unsigned w)
+   {
+      for (size_t chunk = w; chunk < chunks; chunk += workers)
+         assignChunk(chunk, &sumX[chunk * this->k], &sumY[chunk * this->k], &count[chunk * this->k], &changed[chunk]);
+   };
+
+   std::vector<std::thread> pool;
+   for (unsigned w = 1; w < workers; w++)
+      pool.push_back(std::thread([&, w]()
+      {
+         unsigned done = 0;
+         while (true)
+         {
+            {
+               std::unique_lock<std::mutex> lock(stepMutex);
+               stepStarted.wait(lock, [&]() { return finished || step > done; });
+               if (finished)
+                  return;
+               done = step;
+            }
+
+            assignChunks(w);
+
+            std::lock_guard<std::mutex> lock(stepMutex);
+            if (--pending == 0)
+               stepFinished.notify_one();
+         }
+      }));
+
+   for (unsigned iteration = 0; iteration < this->maxIterations; iteration++)
+   {
+      {
+         std::lock_guard<std::mutex> lock(stepMutex);
+         step++;
+         pending = workers - 1;
+      }
+      stepStarted.notify_all();
+
+      assignChunks(0);
+      {
+         std::unique_lock<std::mutex> lock(stepMutex);
+         stepFinished.wait(lock, [&]() { return pending == 0; });
+      }
+
+      // Reduction in chunk order
+      unsigned totalChanged = 0;
+      for (unsigned c = 0; c < this->k; c++)
+      {
+         double x = 0, y = 0;
+         unsigned members = 0;
+         for (size_t chunk = 0; chunk < chunks; chunk++)
+         {
+            x += sumX[chunk * this->k + c];
+            y += sumY[chunk * this->k + c];
+            members += count[chunk * this->k + c];
+         }
+
+         // Empty clusters keep their centre
+         if (members > 0)
+         {
+            this->centresX[c] = x / members;
+            this->centresY[c] = y / members;
+         }
+      }
+      for (size_t chunk = 0; chunk < chunks; chunk++)
+         totalChanged += changed[chunk];
+
+      if (totalChanged == 0)
+         break;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(stepMutex);
+      finished = true;
+   }
+   stepStarted.notify_all();
+   for (size_t w = 0; w < pool.size(); w++)
+      pool[w].join();
+}
+
+/**
+  Method that returns the cluster of each position.
+  @return vector with the cluster (0..k-1) of each position.
+*/
+const std::vector<unsigned>& KMeans::getAssignment() const
+{
+   return this->assignment;
+}
+
+/**
+  Method that returns the number of clusters.
+  @return the number of clusters (it may be lower than requested if there are fewer positions).
+*/
+unsigned KMeans::getK() const
+{
+   return this->k;
+}
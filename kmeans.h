@@ -0,0 +1,75 @@
+#ifndef KMEANS_H
+#define KMEANS_H
+
+#include <cstddef>
+#include <vector>
+
+#include "dataTypes.h"
+
+/**
+  K-means clustering of the positions of the costumers:
+     Positions are projected to the plane and stored as two contiguous
+     arrays (x, y), so the distance kernel can be vectorised by the compiler.
+     Centres are initialised with k-means++ and the assignment step is
+     split in fixed-size chunks processed by several threads, started once
+     and reused by every iteration. Partial sums are reduced in chunk
+     order, hence the result does not depend on the number of threads.
+*/
+class KMeans
+{
+   private:
+      //! Number of clusters
+      unsigned k;
+
+      //! Seed of the k-means++ initialisation
+      unsigned seed;
+
+      //! Number of threads employed in the assignment step
+      unsigned threads;
+
+      //! Max number of iterations (Lloyd steps)
+      unsigned maxIterations;
+
+      //! Projected coordinates of the positions
+      std::vector<double> xs;
+      std::vector<double> ys;
+
+      //! Coordinates of the centres
+      std::vector<double> centresX;
+      std::vector<double> centresY;
+
+      //! Cluster of each position
+      std::vector<unsigned> assignment;
+
+      //! Method that chooses the initial centres (k-means++)
+      void initialise();
+
+      //! Method that assigns a chunk of positions to their closest centre and accumulates their coordinates
+      void assignChunk(size_t chunk, double* sumX, double* sumY, unsigned* count, unsigned* changed);
+
+   public:
+
+      //! Ctor.
+      /*!
+        \param k is the number of clusters.
+        \param seed is the seed of the initialisation.
+      */
+      KMeans(unsigned k, unsigned seed);
+
+      //! Sets the number of threads (0 means as many as cores)
+      void setThreads(unsigned);
+
+      //! Sets the max number of iterations
+      void setMaxIterations(unsigned);
+
+      //! Method that computes the clusters of the given positions
+      void run(const costumersPosType& positions);
+
+      //! Returns the cluster of each position
+      const std::vector<unsigned>& getAssignment() const;
+
+      //! Returns the number of clusters
+      unsigned getK() const;
+};
+
+#endif // KMEANS_H
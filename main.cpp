@@ -31,17 +31,253 @@
  */
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
+#include "batchpipeline.h"
+#include "conversions.h"
 #include "dataTypes.h"
+#include "journal.h"
+#include "manifestfile.h"
+#include "network.h"
+#include "packwriter.h"
+#include "scenariofile.h"
+#include "specregistry.h"
 #include "vrptwinstancegenerator.h"
 
 
+/**
+  Function that converts a command line parameter, exiting if it is not valid.
+  @param name is the name of the parameter (for the error message).
+  @param value is the value given in the command line.
+  @return the value converted to T.
+*/
+template <typename T>
+T parameter(const char* name, const char* value)
+{
+    try
+    {
+        return fromStringTo<T>(value);
+    }
+    catch (const std::invalid_argument& exception)
+    {
+        std::cout << "[ERROR] - Invalid parameter " << name << ": " << exception.what() << std::endl;
+        exit(1);
+    }
+}
+
+/**
+  Function that takes an option (--name, optionally followed by a value)
+  out of the command line, so that the remaining parameters keep their
+  positions.
+  @param argc is the number of parameters (updated).
+  @param argv is the parameters (updated).
+  @param name is the name of the option, e.g. "--journal".
+  @param value is where its value is stored (NULL if the option has no value).
+  @return true if the option is given.
+*/
+bool option(int& argc, char** argv, const char* name, const char** value)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) != name)
+            continue;
+
+        int taken = 1;
+        if (value != NULL)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cout << "[ERROR] - Missing value of " << name << std::endl;
+                exit(1);
+            }
+            *value = argv[i + 1];
+            taken = 2;
+        }
+
+        for (int j = i; j + taken <= argc; j++)
+            argv[j] = argv[j + taken];
+        argc -= taken;
+        return true;
+    }
+    return false;
+}
+
+/**
+  Function that converts the --shard option ("i/N", the i-th of N shards),
+  exiting if it is not valid.
+  @param value is the value given in the command line.
+  @param shard is where the shard is stored (from 0 to shards - 1).
+  @param shards is where the number of shards is stored.
+*/
+void shardParameter(const char* value, unsigned& shard, unsigned& shards)
+{
+    std::string text(value);
+    size_t slash = text.find('/');
+    if (slash != std::string::npos)
+    {
+        shard = parameter<unsigned>("--shard", text.substr(0, slash).c_str());
+        shards = parameter<unsigned>("--shard", text.substr(slash + 1).c_str());
+    }
+    if (slash == std::string::npos || shard < 1 || shard > shards)
+    {
+        std::cout << "[ERROR] - Invalid parameter --shard: " << text << " (expected i/N, with 1 <= i <= N)" << std::endl;
+        exit(1);
+    }
+    shard--;
+}
+
+/**
+  Function that returns the name of the file (pack or journal) of a shard:
+  the number of the shard is inserted before the extension, e.g. the 2nd
+  of 8 shards of "batch.pack" writes "batch.2-of-8.pack".
+  @param fileName is the name of the file of the whole batch.
+  @param shard is the shard (from 0 to shards - 1).
+  @param shards is the number of shards.
+  @return the name of the file of the shard.
+*/
+std::string shardFileName(const std::string& fileName, unsigned shard, unsigned shards)
+{
+    std::string suffix = "." + somethingToString(shard + 1) + "-of-" + somethingToString(shards);
+    size_t dot = fileName.rfind('.');
+    size_t slash = fileName.rfind('/');
+    if (dot == std::string::npos || dot == 0 || (slash != std::string::npos && dot < slash + 2))
+        return fileName + suffix;
+    return fileName.substr(0, dot) + suffix + fileName.substr(dot);
+}
+
+/**
+  Function that merges the packs written by the shards of a batch into a
+  single pack (see shardFileName), which replaces any previous one once
+  all the shards have been merged.
+  @param packFileName is the path to the pack of the whole batch.
+  @param shards is the number of shards.
+*/
+void mergeShards(const char* packFileName, unsigned shards)
+{
+    std::string mergedFile = std::string(packFileName) + ".merge";
+    try
+    {
+        remove(mergedFile.c_str());
+        PackWriter pack;
+        pack.open(mergedFile);
+        for (unsigned shard = 0; shard < shards; shard++)
+        {
+            std::string shardFile = shardFileName(packFileName, shard, shards);
+            size_t entries = pack.merge(shardFile);
+            std::cout << "Merged " << shardFile << " (" << entries << " entries)" << std::endl;
+        }
+        size_t entries = pack.size();
+        pack.close();
+
+        if (rename(mergedFile.c_str(), packFileName) != 0)
+            throw std::runtime_error("Unable to write " + std::string(packFileName));
+        std::cout << "Pack " << packFileName << ": " << entries << " entries" << std::endl;
+    }
+    catch (const std::runtime_error& exception)
+    {
+        remove(mergedFile.c_str());
+        std::cout << "[ERROR] - " << exception.what() << std::endl;
+        exit(1);
+    }
+}
+
+/**
+  Function that generates the instances of all the scenarios of a file
+  (a scenario file or a manifest, see ManifestFile). The network has been
+  read only once and every specification file is parsed only once,
+  whatever the number of scenarios referencing it.
+  @param scenarioFileName is the path to the scenario file or manifest.
+  @param packFileName is the path to the pack where the output files are
+         added (NULL to write them as separate files).
+  @param network is the network (already read).
+  @param journalFileName is the path to the journal of the batch, which
+         is resumed if it has been interrupted (NULL for none).
+  @param verify is true to verify the checksums of the files written
+         before the batch was interrupted.
+  @param shard is the shard of the batch generated (from 0 to shards - 1).
+  @param shards is the number of shards the batch is split into (1 means
+         the whole batch). Each shard has its own pack and journal.
+*/
+void generateScenarios(const char* scenarioFileName, const char* packFileName, std::shared_ptr<const Network> network,
+                       const char* journalFileName, bool verify, unsigned shard, unsigned shards)
+{
+    SpecRegistry registry;
+    std::vector<tScenario> scenarios;
+    try
+    {
+        if (ManifestFile::isManifest(scenarioFileName))
+            ManifestFile::read(scenarioFileName, registry, scenarios);
+        else
+            ScenarioFile::read(scenarioFileName, registry, scenarios);
+    }
+    catch (const std::runtime_error& exception)
+    {
+        std::cout << "[ERROR] - " << exception.what() << std::endl;
+        exit(1);
+    }
+
+    // Every shard reads the whole batch and keeps its own scenarios
+    std::string shardPackFile;
+    std::string shardJournalFile;
+    if (shards > 1)
+    {
+        std::vector<tScenario> batch;
+        batch.swap(scenarios);
+        BatchPipeline::shard(batch, shard, shards, scenarios);
+        std::cout << "Shard " << shard + 1 << " of " << shards << ": " << scenarios.size() << " of " << batch.size() << " instances" << std::endl;
+
+        if (packFileName != NULL)
+        {
+            shardPackFile = shardFileName(packFileName, shard, shards);
+            packFileName = shardPackFile.c_str();
+        }
+        if (journalFileName != NULL)
+        {
+            shardJournalFile = shardFileName(journalFileName, shard, shards);
+            journalFileName = shardJournalFile.c_str();
+        }
+    }
+
+    PackWriter pack;
+    Journal journal;
+    try
+    {
+        if (journalFileName != NULL)
+            journal.open(journalFileName);
+
+        // The pack of a batch that is resumed is the one the journal was started with
+        if (packFileName != NULL && journal.getPackSize() > 0)
+            pack.open(packFileName, journal.getPackSize());
+        else if (packFileName != NULL)
+        {
+            pack.open(packFileName);
+            if (journalFileName != NULL)
+                journal.setPackSize(pack.bytes());
+        }
+
+        // Each instance is written while the next ones are being generated
+        BatchPipeline pipeline(network);
+        if (journalFileName != NULL)
+            pipeline.setJournal(&journal, verify);
+        pipeline.run(scenarios, packFileName != NULL ? &pack : NULL);
+
+        pack.close();
+        journal.close();
+    }
+    catch (const std::runtime_error& exception)
+    {
+        std::cout << "[ERROR] - " << exception.what() << std::endl;
+        exit(1);
+    }
+}
+
 /**
   @todo
 
@@ -51,15 +287,32 @@
 
 int main(int argc, char** argv)
 {
-    if (argc < 8)
+    // Options of the scenario files and manifests
+    const char* journalFileName = NULL;
+    option(argc, argv, "--journal", &journalFileName);
+    bool verify = option(argc, argv, "--verify", NULL);
+    const char* shardValue = NULL;
+    unsigned shard = 0;
+    unsigned shards = 1;
+    if (option(argc, argv, "--shard", &shardValue))
+        shardParameter(shardValue, shard, shards);
+    const char* mergeValue = NULL;
+    bool merge = option(argc, argv, "--merge", &mergeValue);
+    const char* cacheFileName = NULL;
+    option(argc, argv, "--network-cache", &cacheFileName);
+
+    if ((argc < 2 || argc > 3) && argc < 10)
     {
         std::cout << "[ERROR] - Insuffiient parameters." << std::endl;
-        std::cout << "Sintax: "<< argv[0] << "<size> <fileTW> <fileD> <fileTS> <seedM> <seedTW> <seedD> <seedST> <outPref>" << std::endl;
+        std::cout << "Sintax: "<< argv[0] << "<size> <fileTW> <fileD> <fileTS> <seedM> <seedTW> <seedD> <seedST> <outPref> [<mode> [<radius> [<clusters> [<reachable> [<scenarios> [<binary> [<compression>]]]]]]]" << std::endl;
+        std::cout << "    or: "<< argv[0] << "<scenarioFile>|<manifest> [<packFile>] [--journal <journalFile> [--verify]] [--shard <i>/<N>] [--network-cache <cacheFile>]" << std::endl;
+        std::cout << "    or: "<< argv[0] << "<packFile> --merge <N>" << std::endl;
         std::cout << "- <size>" << "\t" << "Size of the problem (Number of costumers the problem will have" << std::endl;
         std::cout << "---------------------------------------------------------------------------------------------" << std::endl;
         std::cout << "- <fileTW>" << "\t" << "File that contains the specification of time windows." << std::endl;
         std::cout << "- <fileD>" << "\t" << "File that contains the specification of demands." << std::endl;
         std::cout << "- <fileTS>" << "\t" << "File that contains the specification of time services." << std::endl;
+        std::cout << "           " << "\t" << "If there is no such file, a standard preset: tw0-equal to tw4-equal, d0-equal, d1-equal and st0-equal." << std::endl;
         std::cout << "---------------------------------------------------------------------------------------------" << std::endl;
         std::cout << "- <seedM>" << "\t" << "Seed to generate the matrices." << std::endl;
         std::cout << "- <seedTW>" << "\t" << "Seed to generate the time windows." << std::endl;
@@ -67,36 +320,85 @@ int main(int argc, char** argv)
         std::cout << "- <seedD>" << "\t" << "Seed to generate the demands." << std::endl;
         std::cout << "- <outPref>" << "\t" << "Prefix for output files." << std::endl;
         std::cout << "---------------------------------------------------------------------------------------------" << std::endl;
+        std::cout << "Optional:" << std::endl;
+        std::cout << "- <mode>" << "\t" << "Selection of costumers: Random (default), Clustered, Mixed or KMeans." << std::endl;
+        std::cout << "- <radius>" << "\t" << "Max distance (km) between the depot and the costumers (0 means no limit)." << std::endl;
+        std::cout << "- <clusters>" << "\t" << "Number of geographic clusters in KMeans mode." << std::endl;
+        std::cout << "- <reachable>" << "\t" << "1 to adjust the time windows to the travel times from/to the depot." << std::endl;
+        std::cout << "- <scenarios>" << "\t" << "Number of stochastic demand scenarios (written to <outPref>Scenarios.dat)." << std::endl;
+        std::cout << "- <binary>" << "\t" << "1 to also write the instance in binary (<outPref>Instance.bin)." << std::endl;
+        std::cout << "- <compression>" << "\t" << "None (default), Gzip or Zstd: compression of the text files." << std::endl;
+        std::cout << "---------------------------------------------------------------------------------------------" << std::endl;
+        std::cout << "- <scenarioFile>" << "\t" << "File with one or more scenarios (specifications, seeds, size and output) or sweeps (grids of them)." << std::endl;
+        std::cout << "- <manifest>" << "\t" << "Text file with the parameters above (<size> to <compression>) of an instance per line." << std::endl;
+        std::cout << "- <packFile>" << "\t" << "Single file where all the output files are stored (see packfile.h)." << std::endl;
+        std::cout << "- <journalFile>" << "\t" << "Record of the instances written: if the batch is interrupted, run it again to resume it." << std::endl;
+        std::cout << "- --verify" << "\t" << "Verify the checksums (not only the sizes) of the files written before resuming." << std::endl;
+        std::cout << "- <i>/<N>" << "\t" << "Generate only the i-th of N shards of the batch, with its own pack and journal (e.g. batch.2-of-8.pack)." << std::endl;
+        std::cout << "- <N>" << "\t" << "Merge the packs of the N shards into <packFile>." << std::endl;
+        std::cout << "- <cacheFile>" << "\t" << "Binary copy of the network, written once and mapped by every process." << std::endl;
+        std::cout << "---------------------------------------------------------------------------------------------" << std::endl;
 
         exit(1);
     }
 
+    // Packs of the shards of a batch
+    if (merge)
+    {
+        mergeShards(argv[1], parameter<unsigned>("--merge", mergeValue));
+        return 0;
+    }
+
     // Fixed file names
     std::string distanceFileName  = "rawDistance.txt";
     std::string timeFileName      = "rawTime.txt";
     std::string idsFileName       = "idRid.txt";
     std::string idslatlngFileName = "idLatLng.dat";
 
+    // Generator object
+    VRPTWInstanceGenerator generator;
+
+    // Read data of the problem (mapped from the cache, if any)
+    if (cacheFileName != NULL)
+    {
+        std::shared_ptr<Network> network(new Network());
+        try
+        {
+            network->readCached(cacheFileName, distanceFileName.c_str(), timeFileName.c_str(), idsFileName.c_str(), idslatlngFileName.c_str());
+        }
+        catch (const std::runtime_error& exception)
+        {
+            std::cout << "[ERROR] - " << exception.what() << std::endl;
+            exit(1);
+        }
+        generator.setNetwork(network);
+    }
+    else
+    {
+        generator.readDistancesFile(distanceFileName.c_str());
+        generator.readTimesFile(timeFileName.c_str());
+        generator.readIds(idsFileName.c_str());
+        generator.readPositions(idslatlngFileName.c_str());
+    }
+
+    // Scenario file or manifest: every instance is generated from the data read above
+    if (argc < 10)
+    {
+        generateScenarios(argv[1], argc > 2 ? argv[2] : NULL, generator.getNetwork(), journalFileName, verify, shard, shards);
+        return 0;
+    }
+
     // Params
-    unsigned matrixSize     = (unsigned)atoi(argv[1]);
+    unsigned matrixSize     = parameter<unsigned>("<size>", argv[1]);
     char* timeWindowsFile  = argv[2];
     char* demandsFile      = argv[3];
     char* timeServicesFile = argv[4];
-    unsigned seedM         = atoi(argv[5]);
-    unsigned seedTW        = atoi(argv[6]);
-    unsigned seedD         = atoi(argv[7]);
-    unsigned seedST        = atoi(argv[8]);
+    unsigned seedM         = parameter<unsigned>("<seedM>", argv[5]);
+    unsigned seedTW        = parameter<unsigned>("<seedTW>", argv[6]);
+    unsigned seedD         = parameter<unsigned>("<seedD>", argv[7]);
+    unsigned seedST        = parameter<unsigned>("<seedST>", argv[8]);
     char* outputFileName   = argv[9];
 
-    // Generator object
-    VRPTWInstanceGenerator generator;
-
-    // Read data of the problem
-    generator.readDistancesFile(distanceFileName.c_str());
-    generator.readTimesFile(timeFileName.c_str());
-    generator.readIds(idsFileName.c_str());
-    generator.readPositions(idslatlngFileName.c_str());
-
     // Params
     generator.setSize(matrixSize);
 
@@ -110,6 +412,22 @@ int main(int argc, char** argv)
     if (outputFileName != NULL)
         generator.setPrefix(std::string(outputFileName));
 
+    // Selection of costumers
+    if (argc > 10)
+        generator.setSamplingMode(std::string(argv[10]));
+    if (argc > 11)
+        generator.setSamplingRadius(parameter<double>("<radius>", argv[11]));
+    if (argc > 12)
+        generator.setNumberOfClusters(parameter<unsigned>("<clusters>", argv[12]));
+    if (argc > 13)
+        generator.setReachableTimeWindows(parameter<unsigned>("<reachable>", argv[13]) != 0);
+    if (argc > 14)
+        generator.setDemandScenarios(parameter<unsigned>("<scenarios>", argv[14]));
+    if (argc > 15)
+        generator.setBinaryOutput(parameter<unsigned>("<binary>", argv[15]) != 0);
+    if (argc > 16)
+        generator.setCompression(std::string(argv[16]));
+
 
     // Read specification to build up this instance
     generator.readTimeWindowsFile(timeWindowsFile);
@@ -117,24 +435,26 @@ int main(int argc, char** argv)
     generator.readServiceTimesFile(timeServicesFile);
 
     // Actual generation of the instance
-    generator.generateMatrices();
-
-    generator.generateTimeWindows();
-    generator.generateDemands();
-    generator.generateServiceTimes();
+    generator.generateAll();
 
     /**
-     You could also use:
-     g.generateAll();
+     That is:
+     g.generateMatrices();
+     g.generateTimeWindows();
+     g.generateDemands();
+     g.generateServiceTimes();
+     g.makeTimeWindowsReachable(); // Only if setReachableTimeWindows(true)
      */
 
-    generator.writeDistanceMatrix();
-    generator.writeTimeMatrix();
-    generator.writeSpecifications();
+    generator.writeAllAsync();
 
     /**
-      You could also use:
-      g.writeAll();
+      Files are written in parallel, otherwise the same as writeAll(), that is:
+      g.writeDistanceMatrix();
+      g.writeTimeMatrix();
+      g.writeSpecifications();
+      g.writeDemandScenarios(); // Only if setDemandScenarios(K > 0)
+      g.writeBinaryInstance();  // Only if setBinaryOutput(true)
       */
 
     return 0;
@@ -0,0 +1,157 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "conversions.h"
+#include "manifestfile.h"
+#include "scenariofile.h"
+
+namespace
+{
+   /**
+     Function that converts a field of a line.
+     @param name is the name of the parameter (for error messages).
+     @param field is the text of the field.
+     @return the value.
+   */
+   template <typename T>
+   T field(const char* name, const std::string& field)
+   {
+      try
+      {
+         return fromStringTo<T>(field);
+      }
+      catch (const std::invalid_argument& exception)
+      {
+         throw std::runtime_error("Invalid parameter " + std::string(name) + ": " + exception.what());
+      }
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that reads an instance from the fields of a line of a manifest.
+  @param fields are the fields of the line (at least 9).
+  @param registry is where the specifications are kept.
+  @param scenario is where the instance is stored.
+*/
+void ManifestFile::readLine(const std::vector<std::string>& fields, SpecRegistry& registry, tScenario& scenario)
+{
+   scenario = ScenarioFile::defaultScenario();
+   scenario.size            = field<unsigned>("<size>", fields[0]);
+   scenario.timeWindows     = registry.loadTimeWindows(fields[1], fields[1].c_str());
+   scenario.demands         = registry.loadDemands(fields[2], fields[2].c_str());
+   scenario.serviceTimes    = registry.loadServiceTimes(fields[3], fields[3].c_str());
+   scenario.matrixSeed      = field<unsigned>("<seedM>", fields[4]);
+   scenario.timeWindowSeed  = field<unsigned>("<seedTW>", fields[5]);
+   scenario.demandSeed      = field<unsigned>("<seedD>", fields[6]);
+   scenario.serviceTimeSeed = field<unsigned>("<seedST>", fields[7]);
+   scenario.prefix          = fields[8];
+   scenario.name            = fields[8];
+
+   if (fields.size() > 9)
+      scenario.samplingMode = fields[9];
+   if (fields.size() > 10)
+      scenario.samplingRadius = field<double>("<radius>", fields[10]);
+   if (fields.size() > 11)
+      scenario.numberOfClusters = field<unsigned>("<clusters>", fields[11]);
+   if (fields.size() > 12)
+      scenario.reachableTimeWindows = field<unsigned>("<reachable>", fields[12]) != 0;
+   if (fields.size() > 13)
+      scenario.demandScenarios = field<unsigned>("<scenarios>", fields[13]);
+   if (fields.size() > 14)
+      scenario.binaryOutput = field<unsigned>("<binary>", fields[14]) != 0;
+   if (fields.size() > 15)
+      scenario.compression = fields[15];
+}
+
+// --- Public --- //
+
+/**
+  Method that reads all the instances of a manifest.
+  @param fileName is the path to the manifest.
+  @param registry is where the specifications are kept.
+  @param scenarios is the vector where the instances are appended.
+  @throw std::runtime_error if the file is not valid.
+*/
+void ManifestFile::read(const char* fileName, SpecRegistry& registry, std::vector<tScenario>& scenarios)
+{
+   std::ifstream input(fileName);
+   if (!input)
+      throw std::runtime_error("Unable to open " + std::string(fileName));
+
+   std::string line;
+   std::vector<std::string> fields;
+   for (unsigned lineNumber = 1; std::getline(input, line); lineNumber++)
+   {
+      fields.clear();
+      std::istringstream lineStream(line);
+      std::string text;
+      while (lineStream >> text)
+         fields.push_back(text);
+
+      if (fields.empty() || fields[0][0] == '#')
+         continue;
+
+      std::string where = std::string(fileName) + ", line " + somethingToString(lineNumber);
+      if (fields.size() < 9 || fields.size() > 16)
+         throw std::runtime_error(where + ": expected from 9 to 16 parameters");
+
+      try
+      {
+         scenarios.push_back(tScenario());
+         readLine(fields, registry, scenarios.back());
+      }
+      catch (const std::runtime_error& exception)
+      {
+         throw std::runtime_error(where + ": " + exception.what());
+      }
+   }
+}
+
+/**
+  Method that tells a manifest from a scenario file: the first character
+  of a scenario file (other than spaces) is '<'.
+  @param fileName is the path to the file.
+  @return true if the file is not XML.
+*/
+bool ManifestFile::isManifest(const char* fileName)
+{
+   std::ifstream input(fileName);
+   char character = 0;
+   input >> character;
+   return input && character != '<';
+}
@@ -0,0 +1,45 @@
+#ifndef MANIFESTFILE_H
+#define MANIFESTFILE_H
+
+#include <string>
+#include <vector>
+
+#include "dataTypes.h"
+#include "specregistry.h"
+
+/**
+  Manifest files:
+     A plain-text list of instances, one per line, with the same
+     parameters as the command line (the optional ones may be omitted):
+   \code
+      # size fileTW fileD fileST seedM seedTW seedD seedST outPref [mode [radius [clusters [reachable [scenarios [binary [compression]]]]]]]
+      100 tw0-equal d0-equal st0-equal 0 0 0 0 test100-0-0-0-0.d0.tw0
+      100 tw1-equal d0-equal st0-equal 0 0 0 0 test100-0-0-0-0.d0.tw1
+      150 dataset/tw/tw.xml d1-equal st0-equal 1 0 0 0 test150-1-0-0-0.d1.tw Clustered 20
+   \endcode
+     Empty lines and lines starting with # are ignored. Specifications
+     are files, each one parsed only once for the whole manifest, or
+     standard presets when there is no file with that name (see
+     specpresets.h).
+*/
+class ManifestFile
+{
+   private:
+      //! Method that reads an instance from the fields of a line
+      static void readLine(const std::vector<std::string>&, SpecRegistry&, tScenario&);
+
+   public:
+
+      //! Method that reads all the instances of a manifest
+      /*!
+        \param fileName is the name of the manifest.
+        \param registry is where the specifications are kept.
+        \param scenarios is the vector where the instances are appended.
+      */
+      static void read(const char* fileName, SpecRegistry& registry, std::vector<tScenario>& scenarios);
+
+      //! Returns true if a file looks like a manifest (rather than a scenario file, which is XML)
+      static bool isManifest(const char* fileName);
+};
+
+#endif // MANIFESTFILE_H
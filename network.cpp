@@ -0,0 +1,652 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binaryinstance.h"
+#include "conversions.h"
+#include "kmeans.h"
+#include "network.h"
+
+namespace
+{
+   /**
+     Cache of a network:
+        - Header (tNetworkCacheHeader, 192 bytes).
+        - Distances: the keys, then the lengths, of the sorted table.
+        - Times: the keys, then the lengths, of the sorted table.
+        - Ids: uint32 each.
+        - Positions: tNetworkCachePosition each.
+     Every section starts at an offset multiple of 64. The sizes and the
+     modification times of the raw files it was written from are recorded,
+     so that it is rewritten when any of them changes. Values are stored
+     in the byte order of the machine that wrote the file.
+   */
+   struct tNetworkCacheHeader
+   {
+      char magic[8];               // "MVRPTWNC"
+      uint32_t version;            // 1
+      uint32_t byteOrder;          // 0x01020304 written in the byte order of the file
+      uint64_t distances;          // Number of elements of each section
+      uint64_t times;
+      uint64_t ids;
+      uint64_t positions;
+      uint64_t distanceOffset;     // Offsets (from the start of the file) of each section
+      uint64_t timeOffset;
+      uint64_t idsOffset;
+      uint64_t positionsOffset;
+      uint64_t fileSize;
+      uint64_t sourceSizes[4];     // Raw files: distances, times, ids and positions
+      int64_t sourceTimes[4];      // Modification times (ns)
+      char reserved[40];
+   };
+
+   struct tNetworkCachePosition
+   {
+      uint32_t id;
+      uint32_t reserved;
+      double lat;
+      double lng;
+   };
+
+   static_assert(sizeof(tNetworkCacheHeader) == 192, "Unexpected size of tNetworkCacheHeader");
+   static_assert(sizeof(tNetworkCachePosition) == 24, "Unexpected size of tNetworkCachePosition");
+
+   const char networkCacheMagic[8] = {'M', 'V', 'R', 'P', 'T', 'W', 'N', 'C'};
+   const uint32_t networkCacheVersion = 1;
+
+   //! Mapped cache file, unmapped when the last table that points to it is destroyed
+   struct tMapping
+   {
+      void* address;
+      size_t length;
+
+      tMapping(void* address, size_t length) : address(address), length(length) {}
+      ~tMapping() { munmap(this->address, this->length); }
+   };
+
+   //! Tables read from a raw file
+   struct tTableStorage
+   {
+      std::vector<uint64_t> keys;
+      std::vector<double> lengths;
+   };
+
+   //! Returns the size and the modification time of a file (false if it does not exist)
+   bool stamp(const std::string& fileName, uint64_t& size, int64_t& time)
+   {
+      struct stat status;
+      if (stat(fileName.c_str(), &status) != 0)
+         return false;
+      size = status.st_size;
+      time = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+      return true;
+   }
+
+   //! Writes bytes to a file
+   void writeBytes(int descriptor, const std::string& fileName, const void* data, size_t length)
+   {
+      const char* bytes = static_cast<const char*>(data);
+      while (length > 0)
+      {
+         ssize_t written = ::write(descriptor, bytes, length);
+         if (written < 0 && errno == EINTR)
+            continue;
+         if (written < 0)
+            throw std::runtime_error("Unable to write " + fileName + ": " + strerror(errno));
+         bytes += written;
+         length -= written;
+      }
+   }
+
+   //! Writes zeros to a file up to the start of the next section (offset is the size written so far)
+   void writePadding(int descriptor, const std::string& fileName, uint64_t offset)
+   {
+      static const char zeros[binaryInstanceAlignment] = {};
+      writeBytes(descriptor, fileName, zeros, binaryInstanceAlign(offset) - offset);
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that reads a table of lengths (lines "from to length") and sorts
+  it by (from, to). If a pair appears more than once, the first length
+  read is the one found.
+  @param fileName is the path to the file.
+  @param table is where the table is stored.
+  @throw std::runtime_error if the file cannot be opened.
+*/
+void Network::readTable(const char* fileName, tTable& table)
+{
+   std::ifstream file(fileName);
+   if (!file)
+      throw std::runtime_error("Unable to open " + std::string(fileName));
+
+   std::vector<uint64_t> keys;
+   std::vector<double> lengths;
+   unsigned from = 0;
+   unsigned to = 0;
+   double length = 0;
+   while (file >> from >> to >> length)
+   {
+      keys.push_back((uint64_t)from << 32 | to);
+      lengths.push_back(length);
+   }
+
+   std::vector<size_t> order(keys.size());
+   std::iota(order.begin(), order.end(), 0);
+   std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+   std::shared_ptr<tTableStorage> storage(new tTableStorage());
+   storage->keys.resize(keys.size());
+   storage->lengths.resize(keys.size());
+   for (size_t i = 0; i < order.size(); i++)
+   {
+      storage->keys[i] = keys[order[i]];
+      storage->lengths[i] = lengths[order[i]];
+   }
+
+   table.keys = storage->keys.data();
+   table.lengths = storage->lengths.data();
+   table.size = keys.size();
+   table.storage = storage;
+}
+
+/**
+  Method that looks up the length between two costumers in a table.
+  @param table is the table (sorted).
+  @param from is the real id of the first costumer.
+  @param to is the real id of the second costumer.
+  @return the length (0 from a costumer to itself).
+  @throw std::runtime_error if the pair is not in the table.
+*/
+double Network::lookUp(const tTable& table, unsigned from, unsigned to)
+{
+   if (from == to)
+      return 0;
+
+   uint64_t key = (uint64_t)from << 32 | to;
+   const uint64_t* found = std::lower_bound(table.keys, table.keys + table.size, key);
+   if (found == table.keys + table.size || *found != key)
+      throw std::runtime_error("Unexpected error looking for length from " + somethingToString(from) + " to " + somethingToString(to));
+   return table.lengths[found - table.keys];
+}
+
+/**
+  Method that relates the ids and the positions (both ways) and builds the
+  spatial index over the positions. It is invoked whenever the ids or the
+  positions are read.
+*/
+void Network::indexPositions()
+{
+   this->positionsById.clear();
+   for (size_t i = 0; i < this->positions.size(); i++)
+      this->positionsById.insert(std::make_pair(this->positions[i].id, (unsigned)i));
+
+   std::unordered_map<unsigned, unsigned> idIndexes;
+   for (size_t i = 0; i < this->ids.size(); i++)
+      idIndexes.insert(std::make_pair(this->ids[i], (unsigned)i));
+
+   this->positionIdIndexes.resize(this->positions.size());
+   for (size_t i = 0; i < this->positions.size(); i++)
+   {
+      std::unordered_map<unsigned, unsigned>::const_iterator found = idIndexes.find(this->positions[i].id);
+      this->positionIdIndexes[i] = (found == idIndexes.end())? this->ids.size() : found->second;
+   }
+
+   if (!this->positions.empty())
+      this->spatialIndex.build(this->positions);
+
+   std::lock_guard<std::mutex> lock(this->clusteringMutex);
+   this->clusterings.clear();
+}
+
+/**
+  Method that maps a cache file written by writeCache. The tables point to
+  the mapping (they are not copied), the ids and the positions are copied.
+  @param fileName is the path to the cache.
+  @param sources is the paths to the raw files (distances, times, ids and
+         positions) the cache must have been written from.
+  @return false if the cache does not exist, it is not valid or any of the
+          raw files has changed since it was written (nothing is read).
+  @throw std::runtime_error if it cannot be mapped.
+*/
+bool Network::readCache(const char* fileName, const std::vector<std::string>& sources)
+{
+   int descriptor = ::open(fileName, O_RDONLY);
+   if (descriptor < 0)
+      return false;
+
+   struct stat status;
+   if (fstat(descriptor, &status) != 0 || (size_t)status.st_size < sizeof(tNetworkCacheHeader))
+   {
+      ::close(descriptor);
+      return false;
+   }
+
+   void* address = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+   ::close(descriptor);
+   if (address == MAP_FAILED)
+      throw std::runtime_error("Unable to map " + std::string(fileName) + ": " + strerror(errno));
+   std::shared_ptr<tMapping> mapping(new tMapping(address, status.st_size));
+
+   const char* data = static_cast<const char*>(address);
+   const tNetworkCacheHeader* header = static_cast<const tNetworkCacheHeader*>(address);
+   if (memcmp(header->magic, networkCacheMagic, sizeof(networkCacheMagic)) != 0 ||
+       header->version != networkCacheVersion || header->byteOrder != binaryInstanceByteOrder ||
+       header->fileSize != (uint64_t)status.st_size)
+      return false;
+
+   for (size_t i = 0; i < 4; i++)
+   {
+      uint64_t size = 0;
+      int64_t time = 0;
+      if (!stamp(sources[i], size, time) || size != header->sourceSizes[i] || time != header->sourceTimes[i])
+         return false;
+   }
+
+   uint64_t length = status.st_size;
+   auto fits = [length](uint64_t offset, uint64_t count, uint64_t size)
+   {
+      return offset % binaryInstanceAlignment == 0 && offset <= length && count <= (length - offset) / size;
+   };
+   if (!fits(header->distanceOffset, header->distances, 2 * sizeof(uint64_t)) ||
+       !fits(header->timeOffset, header->times, 2 * sizeof(uint64_t)) ||
+       !fits(header->idsOffset, header->ids, sizeof(uint32_t)) ||
+       !fits(header->positionsOffset, header->positions, sizeof(tNetworkCachePosition)))
+      return false;
+
+   this->distances.storage = mapping;
+   this->distances.keys = reinterpret_cast<const uint64_t*>(data + header->distanceOffset);
+   this->distances.lengths = reinterpret_cast<const double*>(this->distances.keys + header->distances);
+   this->distances.size = header->distances;
+
+   this->times.storage = mapping;
+   this->times.keys = reinterpret_cast<const uint64_t*>(data + header->timeOffset);
+   this->times.lengths = reinterpret_cast<const double*>(this->times.keys + header->times);
+   this->times.size = header->times;
+
+   const uint32_t* ids = reinterpret_cast<const uint32_t*>(data + header->idsOffset);
+   this->ids.assign(ids, ids + header->ids);
+
+   const tNetworkCachePosition* positions = reinterpret_cast<const tNetworkCachePosition*>(data + header->positionsOffset);
+   this->positions.resize(header->positions);
+   for (size_t i = 0; i < this->positions.size(); i++)
+   {
+      this->positions[i].id = positions[i].id;
+      this->positions[i].lat = positions[i].lat;
+      this->positions[i].lng = positions[i].lng;
+   }
+
+   indexPositions();
+   return true;
+}
+
+/**
+  Method that writes the network to a cache file. It is written to a
+  temporary file that then replaces the cache, so that a process that
+  has mapped the previous one is not affected.
+  @param fileName is the path to the cache.
+  @param sources is the paths to the raw files (distances, times, ids and
+         positions) the network was read from.
+  @throw std::runtime_error if it cannot be written.
+*/
+void Network::writeCache(const char* fileName, const std::vector<std::string>& sources) const
+{
+   tNetworkCacheHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, networkCacheMagic, sizeof(header.magic));
+   header.version = networkCacheVersion;
+   header.byteOrder = binaryInstanceByteOrder;
+   header.distances = this->distances.size;
+   header.times = this->times.size;
+   header.ids = this->ids.size();
+   header.positions = this->positions.size();
+   header.distanceOffset = sizeof(header);
+   header.timeOffset = header.distanceOffset + binaryInstanceAlign(2 * header.distances * sizeof(uint64_t));
+   header.idsOffset = header.timeOffset + binaryInstanceAlign(2 * header.times * sizeof(uint64_t));
+   header.positionsOffset = header.idsOffset + binaryInstanceAlign(header.ids * sizeof(uint32_t));
+   header.fileSize = header.positionsOffset + binaryInstanceAlign(header.positions * sizeof(tNetworkCachePosition));
+   for (size_t i = 0; i < 4; i++)
+      if (!stamp(sources[i], header.sourceSizes[i], header.sourceTimes[i]))
+         throw std::runtime_error("Unable to open " + sources[i]);
+
+   std::vector<uint32_t> ids(this->ids.begin(), this->ids.end());
+   std::vector<tNetworkCachePosition> positions(this->positions.size());
+   for (size_t i = 0; i < positions.size(); i++)
+   {
+      memset(&positions[i], 0, sizeof(positions[i]));
+      positions[i].id = this->positions[i].id;
+      positions[i].lat = this->positions[i].lat;
+      positions[i].lng = this->positions[i].lng;
+   }
+
+   std::string temporary = std::string(fileName) + "." + somethingToString(getpid());
+   int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (descriptor < 0)
+      throw std::runtime_error("Unable to open " + temporary + ": " + strerror(errno));
+
+   try
+   {
+      writeBytes(descriptor, temporary, &header, sizeof(header));
+      writeBytes(descriptor, temporary, this->distances.keys, header.distances * sizeof(uint64_t));
+      writeBytes(descriptor, temporary, this->distances.lengths, header.distances * sizeof(double));
+      writePadding(descriptor, temporary, header.distanceOffset + 2 * header.distances * sizeof(uint64_t));
+      writeBytes(descriptor, temporary, this->times.keys, header.times * sizeof(uint64_t));
+      writeBytes(descriptor, temporary, this->times.lengths, header.times * sizeof(double));
+      writePadding(descriptor, temporary, header.timeOffset + 2 * header.times * sizeof(uint64_t));
+      writeBytes(descriptor, temporary, ids.data(), ids.size() * sizeof(uint32_t));
+      writePadding(descriptor, temporary, header.idsOffset + ids.size() * sizeof(uint32_t));
+      writeBytes(descriptor, temporary, positions.data(), positions.size() * sizeof(tNetworkCachePosition));
+      writePadding(descriptor, temporary, header.positionsOffset + positions.size() * sizeof(tNetworkCachePosition));
+      if (fsync(descriptor) != 0)
+         throw std::runtime_error("Unable to write " + temporary + ": " + strerror(errno));
+   }
+   catch (const std::runtime_error&)
+   {
+      ::close(descriptor);
+      unlink(temporary.c_str());
+      throw;
+   }
+
+   ::close(descriptor);
+   if (rename(temporary.c_str(), fileName) != 0)
+   {
+      unlink(temporary.c_str());
+      throw std::runtime_error("Unable to write " + std::string(fileName) + ": " + strerror(errno));
+   }
+}
+
+// --- Public --- //
+
+/**
+  Default Ctor.
+*/
+Network::Network()
+{
+}
+
+/**
+  Copy Ctor.
+  @param other is the network copied.
+*/
+Network::Network(const Network& other) : distances(other.distances), times(other.times), ids(other.ids), positions(other.positions),
+                                         positionsById(other.positionsById), positionIdIndexes(other.positionIdIndexes),
+                                         spatialIndex(other.spatialIndex)
+{
+   std::lock_guard<std::mutex> lock(other.clusteringMutex);
+   this->clusterings = other.clusterings;
+}
+
+/**
+  Method that reads the distances between pairs of costumers.
+  @param fileName is the path to the file (lines "from to distance").
+  @throw std::runtime_error if the file cannot be opened.
+*/
+void Network::readDistances(const char* fileName)
+{
+   readTable(fileName, this->distances);
+}
+
+/**
+  Method that reads the travel times between pairs of costumers.
+  @param fileName is the path to the file (lines "from to time").
+  @throw std::runtime_error if the file cannot be opened.
+*/
+void Network::readTimes(const char* fileName)
+{
+   readTable(fileName, this->times);
+}
+
+/**
+  Method that reads the real ids of the costumers.
+  @param fileName is the path to the file (lines "index id").
+  @throw std::runtime_error if the file cannot be opened.
+*/
+void Network::readIds(const char* fileName)
+{
+   std::ifstream file(fileName);
+   if (!file)
+      throw std::runtime_error("Unable to open " + std::string(fileName));
+
+   unsigned trash = 0;
+   unsigned id = 0;
+   while (file >> trash >> id)
+      this->ids.push_back(id);
+   indexPositions();
+}
+
+/**
+  Method that reads the positions of the costumers.
+  @param fileName is the path to the file (lines "id lat lng").
+  @throw std::runtime_error if the file cannot be opened.
+*/
+void Network::readPositions(const char* fileName)
+{
+   std::ifstream file(fileName);
+   if (!file)
+      throw std::runtime_error("Unable to open " + std::string(fileName));
+
+   tPos row;
+   while (file >> row.id >> row.lat >> row.lng)
+      this->positions.push_back(row);
+   indexPositions();
+}
+
+/**
+  Method that reads the network from a cache file. If it does not exist or
+  any of the raw files has changed since it was written, the raw files are
+  read and the cache is written first. Processes that read the same cache
+  at the same time wait for the one that writes it, and all of them map
+  the same file, so its tables are in memory only once.
+  @param cacheFileName is the path to the cache.
+  @param distanceFileName is the path to the distances (lines "from to distance").
+  @param timeFileName is the path to the travel times (lines "from to time").
+  @param idsFileName is the path to the ids (lines "index id").
+  @param positionsFileName is the path to the positions (lines "id lat lng").
+  @throw std::runtime_error if any file cannot be read or the cache cannot be written.
+*/
+void Network::readCached(const char* cacheFileName, const char* distanceFileName, const char* timeFileName,
+                         const char* idsFileName, const char* positionsFileName)
+{
+   std::vector<std::string> sources;
+   sources.push_back(distanceFileName);
+   sources.push_back(timeFileName);
+   sources.push_back(idsFileName);
+   sources.push_back(positionsFileName);
+
+   std::string lockFileName = std::string(cacheFileName) + ".lock";
+   int lock = ::open(lockFileName.c_str(), O_RDWR | O_CREAT, 0644);
+   if (lock < 0)
+      throw std::runtime_error("Unable to open " + lockFileName + ": " + strerror(errno));
+   while (flock(lock, LOCK_EX) != 0 && errno == EINTR)
+      ;
+
+   try
+   {
+      if (!readCache(cacheFileName, sources))
+      {
+         std::cout << "Writing the network cache " << cacheFileName << std::endl;
+         Network network;
+         network.readDistances(distanceFileName);
+         network.readTimes(timeFileName);
+         network.readIds(idsFileName);
+         network.readPositions(positionsFileName);
+         network.writeCache(cacheFileName, sources);
+
+         if (!readCache(cacheFileName, sources))
+            throw std::runtime_error("Unable to read " + std::string(cacheFileName));
+      }
+   }
+   catch (const std::runtime_error&)
+   {
+      ::close(lock);
+      throw;
+   }
+   ::close(lock);
+}
+
+/**
+  Method that returns the distance between two costumers.
+  @param from is the real id of the first costumer.
+  @param to is the real id of the second costumer.
+  @return the distance (0 from a costumer to itself).
+  @throw std::runtime_error if the pair is unknown.
+*/
+double Network::getDistance(unsigned from, unsigned to) const
+{
+   return lookUp(this->distances, from, to);
+}
+
+/**
+  Method that returns the travel time between two costumers.
+  @param from is the real id of the first costumer.
+  @param to is the real id of the second costumer.
+  @return the time (0 from a costumer to itself).
+  @throw std::runtime_error if the pair is unknown.
+*/
+double Network::getTime(unsigned from, unsigned to) const
+{
+   return lookUp(this->times, from, to);
+}
+
+/**
+  Method that returns the real ids of the costumers.
+  @return the ids (the depot first).
+*/
+const std::vector<unsigned>& Network::getIds() const
+{
+   return this->ids;
+}
+
+/**
+  Method that returns the positions of the costumers.
+  @return the positions.
+*/
+const costumersPosType& Network::getPositions() const
+{
+   return this->positions;
+}
+
+/**
+  Method that returns the index within the positions of a costumer.
+  @param id is the real id of the costumer.
+  @return the index of its position.
+  @throw std::runtime_error if it has no position.
+*/
+unsigned Network::getPosition(unsigned id) const
+{
+   std::unordered_map<unsigned, unsigned>::const_iterator found = this->positionsById.find(id);
+   if (found == this->positionsById.end())
+      throw std::runtime_error("getPosition(). Id not found");
+   return found->second;
+}
+
+/**
+  Method that returns the index within the ids of a position.
+  @param position is the index of the position.
+  @return the index of its id (getIds().size() if it does not appear).
+*/
+unsigned Network::getIdIndex(unsigned position) const
+{
+   return this->positionIdIndexes[position];
+}
+
+/**
+  Method that returns the spatial index over the positions.
+  @return the index (empty if the positions have not been read).
+*/
+const SpatialIndex& Network::getSpatialIndex() const
+{
+   return this->spatialIndex;
+}
+
+/**
+  Method that returns the k-means clusters of the whole network. As they only
+  depend on the network and k (the initial centres are seeded with k), they
+  are computed once and cached. Several threads may ask for them at the same
+  time: the first one computes them outside the lock and the others wait
+  only for the same k.
+  @param k is the number of clusters.
+  @param threads is the number of threads employed to compute them (0 means as many as cores).
+  @return vector with the positions indexes of each cluster.
+*/
+std::shared_ptr<const std::vector<idsType> > Network::getClusters(unsigned k, unsigned threads) const
+{
+   std::promise<std::shared_ptr<const std::vector<idsType> > > promise;
+   std::shared_future<std::shared_ptr<const std::vector<idsType> > > clustering;
+   bool cached;
+   {
+      std::lock_guard<std::mutex> lock(this->clusteringMutex);
+      std::map<unsigned, std::shared_future<std::shared_ptr<const std::vector<idsType> > > >::const_iterator found = this->clusterings.find(k);
+      cached = (found != this->clusterings.end());
+      if (cached)
+         clustering = found->second;
+      else
+         clustering = this->clusterings[k] = promise.get_future().share();
+   }
+   if (cached)
+      return clustering.get();
+
+   try
+   {
+      std::cout << "Clustering the network (k = " << k << ")" << std::endl;
+      KMeans kMeans(k, k);
+      kMeans.setThreads(threads);
+      kMeans.run(this->positions);
+
+      std::shared_ptr<std::vector<idsType> > clusters(new std::vector<idsType>(kMeans.getK()));
+      const std::vector<unsigned>& assignment = kMeans.getAssignment();
+      for (size_t i = 0; i < assignment.size(); i++)
+         (*clusters)[assignment[i]].push_back(i);
+      promise.set_value(clusters);
+   }
+   catch (...)
+   {
+      promise.set_exception(std::current_exception());
+   }
+   return clustering.get();
+}
@@ -0,0 +1,143 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dataTypes.h"
+#include "spatialindex.h"
+
+/**
+  Road network from which instances are drawn:
+     The distances and travel times between pairs of costumers, their real
+     ids and their positions, read once from the raw files. The tables are
+     sorted by (from, to) when they are read, so the length between two
+     costumers is found by binary search rather than by scanning the whole
+     table. The spatial index over the positions is also built once.
+     After loading, a network is not modified (the k-means clusterings are
+     computed on demand and cached, guarded by a mutex), so a single
+     network can be shared by any number of generators, in any number of
+     threads, without copying it (see VRPTWInstanceGenerator::setNetwork).
+     A network can also be stored in a binary cache file (see readCached):
+     its tables are then mapped in memory rather than parsed and sorted,
+     so several processes (e.g. the shards of a batch) share a single
+     copy of them and start at once.
+     Errors are reported by throwing std::runtime_error.
+*/
+class Network
+{
+   private:
+      //! Table of lengths sorted by (from, to): keys (from << 32 | to) and lengths, read or mapped (kept alive by storage)
+      struct tTable
+      {
+         std::shared_ptr<const void> storage;
+         const uint64_t* keys;
+         const double* lengths;
+         size_t size;
+
+         tTable() : keys(NULL), lengths(NULL), size(0) {}
+      };
+
+      //! Distances and travel times
+      tTable distances;
+      tTable times;
+
+      //! Real ids of the costumers (the depot first)
+      std::vector<unsigned> ids;
+
+      //! Positions of the costumers
+      costumersPosType positions;
+
+      //! Index within positions of each id
+      std::unordered_map<unsigned, unsigned> positionsById;
+
+      //! Index within ids of each position (ids.size() if it does not appear)
+      std::vector<unsigned> positionIdIndexes;
+
+      //! Spatial index over the positions
+      SpatialIndex spatialIndex;
+
+      //! Clusters of the network (k-means) for each number of clusters, computed once (outside the lock)
+      mutable std::map<unsigned, std::shared_future<std::shared_ptr<const std::vector<idsType> > > > clusterings;
+      mutable std::mutex clusteringMutex;
+
+      //! Method that reads and sorts a table of lengths
+      static void readTable(const char*, tTable&);
+
+      //! Method that looks up the length between two costumers in a table
+      static double lookUp(const tTable&, unsigned, unsigned);
+
+      //! Method that relates the ids and the positions and builds the spatial index
+      void indexPositions();
+
+      //! Method that maps a cache file (false if it does not exist or it is not up to date)
+      bool readCache(const char*, const std::vector<std::string>&);
+
+      //! Method that writes a cache file
+      void writeCache(const char*, const std::vector<std::string>&) const;
+
+      //! Non-assignable
+      Network& operator=(const Network&);
+
+   public:
+
+      //! Default Ctor. The network is empty.
+      Network();
+
+      //! Copy Ctor. The clusterings already computed are copied too.
+      Network(const Network&);
+
+      //! Methods that read each raw file (they are not thread-safe: read the network before sharing it)
+      void readDistances(const char* fileName);
+      void readTimes(const char* fileName);
+      void readIds(const char* fileName);
+      void readPositions(const char* fileName);
+
+      //! Method that reads the network from a cache file, which is written first from the raw files if needed
+      /*!
+        \param cacheFileName is the path to the cache (it is rewritten if any raw file has changed).
+        \param distanceFileName is the path to the distances (see readDistances).
+        \param timeFileName is the path to the travel times (see readTimes).
+        \param idsFileName is the path to the ids (see readIds).
+        \param positionsFileName is the path to the positions (see readPositions).
+      */
+      void readCached(const char* cacheFileName, const char* distanceFileName, const char* timeFileName,
+                      const char* idsFileName, const char* positionsFileName);
+
+      //! Returns the distance between two costumers given their real ids
+      double getDistance(unsigned from, unsigned to) const;
+
+      //! Returns the travel time between two costumers given their real ids
+      double getTime(unsigned from, unsigned to) const;
+
+      //! Returns the real ids of the costumers (the depot first)
+      const std::vector<unsigned>& getIds() const;
+
+      //! Returns the positions of the costumers
+      const costumersPosType& getPositions() const;
+
+      //! Returns the index within the positions of a costumer given its real id
+      unsigned getPosition(unsigned id) const;
+
+      //! Returns the index within the ids of a position (getIds().size() if it does not appear)
+      unsigned getIdIndex(unsigned position) const;
+
+      //! Returns the spatial index over the positions (empty if they have not been read)
+      const SpatialIndex& getSpatialIndex() const;
+
+      //! Returns the k-means clusters (indexes of positions) of the network, computing them only once
+      /*!
+        \param k is the number of clusters.
+        \param threads is the number of threads employed to compute them (0 means as many as cores).
+      */
+      std::shared_ptr<const std::vector<idsType> > getClusters(unsigned k, unsigned threads) const;
+};
+
+#endif // NETWORK_H
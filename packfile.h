@@ -0,0 +1,319 @@
+#ifndef PACKFILE_H
+#define PACKFILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binaryinstance.h"
+
+/**
+  Pack files (.pack):
+     Many output files (of many instances) stored in a single file, so a
+     batch does not create tens of thousands of small files:
+        - Header (tPackHeader, 64 bytes).
+        - The entries, one after the other. Each one starts at an offset
+          multiple of 64 and holds the bytes of one output file, exactly as
+          it would have been written to disk (possibly compressed).
+        - Index: the entries (tPackEntry) followed by their names (a table
+          of characters, names are not null-terminated).
+        - Trailer (tPackTrailer, 48 bytes), at the very end of the file.
+     The name of each entry is the name the file would have had, e.g.
+     "test100-0-0-0-0.d0.tw0DistanceMatrix.dat". The checksums are 64-bit
+     FNV-1a hashes (see binaryinstance.h) of the data of each entry and of
+     the index. Values are stored in the byte order of the machine that
+     wrote the file.
+     A pack is extended by writing new entries, a new index and a new
+     trailer after the previous trailer. Until the new trailer is written
+     (e.g. if the batch is killed before), the file does not end with a
+     trailer: readers then scan back to the last valid trailer, so it is
+     still a valid pack with the previous entries (those written after it
+     are only recovered with a journal, see PackWriter). If an entry
+     is added twice, the last one is the one found by name. Several entries
+     may share the same data (e.g. identical matrices of instances that
+     only differ in their specifications).
+     This file is header-only so that solvers only need to include it.
+   \code
+      PackReader pack("batch.pack");
+      const PackReader::tEntry* specs = pack.find("test100-0-0-0-0.d0.tw0Specs.dat");
+      if (specs != NULL)
+         parse(specs->data, specs->size);
+   \endcode
+*/
+
+//! Header of a pack
+struct tPackHeader
+{
+    char magic[8];            // "MVRPTWPK"
+    uint32_t version;         // 1
+    uint32_t byteOrder;       // 0x01020304 written in the byte order of the file
+    char reserved[48];
+};
+
+//! Entry of the index of a pack
+struct tPackEntry
+{
+    uint64_t offset;          // Offset (from the start of the file) of the data
+    uint64_t size;            // Size in bytes of the data
+    uint64_t checksum;        // FNV-1a of the data
+    uint32_t nameOffset;      // Offset of the name within the names of the index
+    uint32_t nameLength;
+};
+
+//! Trailer of a pack (the last bytes of the file)
+struct tPackTrailer
+{
+    char magic[8];            // "MVRPTWIX"
+    uint64_t indexOffset;     // Offset (from the start of the file) of the index
+    uint64_t entries;         // Number of entries of the index
+    uint64_t indexSize;       // Size in bytes of the index (entries and names)
+    uint64_t indexChecksum;   // FNV-1a of the index
+    uint64_t reserved;
+};
+
+static_assert(sizeof(tPackHeader) == 64, "Unexpected size of tPackHeader");
+static_assert(sizeof(tPackEntry) == 32, "Unexpected size of tPackEntry");
+static_assert(sizeof(tPackTrailer) == 48, "Unexpected size of tPackTrailer");
+
+//! Constants of the format
+const char packMagic[8] = {'M', 'V', 'R', 'P', 'T', 'W', 'P', 'K'};
+const char packIndexMagic[8] = {'M', 'V', 'R', 'P', 'T', 'W', 'I', 'X'};
+const uint32_t packVersion = 1;
+
+/**
+  Function that checks whether there is a trailer at a given position of a
+  pack, right after its index, and whether the checksum of the index matches.
+  @param position is the offset of the trailer.
+  @param read is a function read(offset, buffer, length) that copies bytes of
+         the pack and returns false if they are not in the file.
+  @param trailer is where the trailer is read.
+  @return true if the trailer and its index are valid.
+*/
+template <class tRead>
+bool packTrailerAt(uint64_t position, const tRead& read, tPackTrailer& trailer)
+{
+    if (position < sizeof(tPackHeader) || !read(position, &trailer, sizeof(trailer)) ||
+        memcmp(trailer.magic, packIndexMagic, sizeof(packIndexMagic)) != 0 ||
+        trailer.entries > trailer.indexSize / sizeof(tPackEntry) ||
+        trailer.indexOffset < sizeof(tPackHeader) || trailer.indexOffset > position ||
+        trailer.indexSize != position - trailer.indexOffset)
+        return false;
+
+    char block[16384];
+    uint64_t checksum = binaryInstanceHashSeed;
+    for (uint64_t done = 0; done < trailer.indexSize; )
+    {
+        size_t length = std::min<uint64_t>(sizeof(block), trailer.indexSize - done);
+        if (!read(trailer.indexOffset + done, block, length))
+            return false;
+        checksum = binaryInstanceHash(checksum, block, length);
+        done += length;
+    }
+    return checksum == trailer.indexChecksum;
+}
+
+/**
+  Function that finds the last valid trailer of a pack: the one at the end of
+  the file or, if the pack was not closed after adding entries (or it was
+  truncated), the last one found scanning back from the end.
+  @param size is the size of the pack.
+  @param read is a function read(offset, buffer, length) (see packTrailerAt).
+  @param trailer is where the trailer is read.
+  @return false if the pack has no valid trailer.
+*/
+template <class tRead>
+bool findPackTrailer(uint64_t size, const tRead& read, tPackTrailer& trailer)
+{
+    if (size < sizeof(tPackHeader) + sizeof(tPackTrailer))
+        return false;
+    if (packTrailerAt(size - sizeof(tPackTrailer), read, trailer))
+        return true;
+
+    // Positions below limit where the magic of a trailer starts, from the last one
+    char block[16384 + sizeof(packIndexMagic) - 1];
+    uint64_t limit = size - sizeof(tPackTrailer);
+    while (limit > sizeof(tPackHeader))
+    {
+        uint64_t start = std::max<uint64_t>(sizeof(tPackHeader), limit - std::min<uint64_t>(limit, 16384));
+        if (!read(start, block, limit - start + sizeof(packIndexMagic) - 1))
+            return false;
+        for (size_t i = limit - start; i-- > 0; )
+            if (memcmp(block + i, packIndexMagic, sizeof(packIndexMagic)) == 0 && packTrailerAt(start + i, read, trailer))
+                return true;
+        limit = start;
+    }
+    return false;
+}
+
+/**
+  Reader of pack files:
+     The file is mapped in memory (read only) and the entries are accessed
+     in place, without copying them. The index is checked when the file is
+     opened (the last valid one, see findPackTrailer), the data of each
+     entry only when verify() is invoked.
+     Errors are reported by throwing std::runtime_error.
+*/
+class PackReader
+{
+   public:
+      //! Entry of the pack (within the mapping)
+      struct tEntry
+      {
+         std::string_view name;
+         const char* data;
+         size_t size;
+         uint64_t checksum;
+      };
+
+   private:
+      //! Mapped file
+      const char* data;
+      size_t length;
+
+      //! Entries in the order of the index and their positions by name
+      std::vector<tEntry> entries;
+      std::unordered_map<std::string_view, size_t> names;
+
+      //! Method that throws an error about the file
+      void fail(const std::string& fileName, const std::string& message)
+      {
+         close();
+         throw std::runtime_error(fileName + ": " + message);
+      }
+
+      //! Method that checks that a block lies within the file
+      bool fits(uint64_t offset, uint64_t size) const
+      {
+         return offset <= this->length && size <= this->length - offset;
+      }
+
+      //! Non-copyable
+      PackReader(const PackReader&);
+      PackReader& operator=(const PackReader&);
+
+   public:
+
+      //! Default Ctor. Nothing is mapped until open() is invoked.
+      PackReader() : data(NULL), length(0) {}
+
+      //! Ctor. It maps the given file.
+      explicit PackReader(const char* fileName) : data(NULL), length(0)
+      {
+         open(fileName);
+      }
+
+      //! Dtor. It unmaps the file.
+      ~PackReader()
+      {
+         close();
+      }
+
+      //! Method that maps a pack and reads its index
+      void open(const char* fileName)
+      {
+         close();
+
+         int descriptor = ::open(fileName, O_RDONLY);
+         if (descriptor < 0)
+            throw std::runtime_error("Unable to open " + std::string(fileName));
+
+         struct stat status;
+         if (fstat(descriptor, &status) != 0 || (size_t)status.st_size < sizeof(tPackHeader) + sizeof(tPackTrailer))
+         {
+            ::close(descriptor);
+            throw std::runtime_error(std::string(fileName) + ": not a pack file");
+         }
+
+         void* address = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+         ::close(descriptor);
+         if (address == MAP_FAILED)
+            throw std::runtime_error("Unable to map " + std::string(fileName));
+
+         this->data = static_cast<const char*>(address);
+         this->length = status.st_size;
+
+         const tPackHeader* header = reinterpret_cast<const tPackHeader*>(this->data);
+         if (memcmp(header->magic, packMagic, sizeof(packMagic)) != 0)
+            fail(fileName, "not a pack file");
+         if (header->byteOrder != binaryInstanceByteOrder)
+            fail(fileName, "written with a different byte order");
+         if (header->version != packVersion)
+            fail(fileName, "unsupported version " + std::to_string(header->version));
+
+         tPackTrailer trailer;
+         auto read = [this](uint64_t offset, void* buffer, size_t size)
+         {
+            if (!fits(offset, size))
+               return false;
+            memcpy(buffer, this->data + offset, size);
+            return true;
+         };
+         if (!findPackTrailer(this->length, read, trailer))
+            fail(fileName, "truncated pack file (no index)");
+
+         const char* index = this->data + trailer.indexOffset;
+
+         // Names follow the entries
+         const char* names = index + trailer.entries * sizeof(tPackEntry);
+         uint64_t namesSize = trailer.indexSize - trailer.entries * sizeof(tPackEntry);
+
+         this->entries.resize(trailer.entries);
+         this->names.reserve(trailer.entries);
+         for (size_t i = 0; i < this->entries.size(); i++)
+         {
+            tPackEntry entry;
+            memcpy(&entry, index + i * sizeof(tPackEntry), sizeof(entry));
+            if (!fits(entry.offset, entry.size) || entry.nameOffset > namesSize || entry.nameLength > namesSize - entry.nameOffset)
+               fail(fileName, "corrupted index");
+
+            this->entries[i].name = std::string_view(names + entry.nameOffset, entry.nameLength);
+            this->entries[i].data = this->data + entry.offset;
+            this->entries[i].size = entry.size;
+            this->entries[i].checksum = entry.checksum;
+            this->names[this->entries[i].name] = i;
+         }
+      }
+
+      //! Method that unmaps the file
+      void close()
+      {
+         if (this->data)
+            munmap(const_cast<char*>(this->data), this->length);
+         this->data = NULL;
+         this->length = 0;
+         this->entries.clear();
+         this->names.clear();
+      }
+
+      //! Returns the number of entries
+      size_t size() const { return this->entries.size(); }
+
+      //! Returns the i-th entry (in the order they were added)
+      const tEntry& entry(size_t i) const { return this->entries[i]; }
+
+      //! Returns the entry with a given name (NULL if there is none)
+      const tEntry* find(std::string_view name) const
+      {
+         std::unordered_map<std::string_view, size_t>::const_iterator position = this->names.find(name);
+         return position == this->names.end() ? NULL : &this->entries[position->second];
+      }
+
+      //! Method that checks the checksum of an entry (it reads all its data)
+      static bool verify(const tEntry& entry)
+      {
+         return binaryInstanceHash(binaryInstanceHashSeed, entry.data, entry.size) == entry.checksum;
+      }
+};
+
+#endif // PACKFILE_H
@@ -0,0 +1,538 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "packwriter.h"
+
+// --- Private --- //
+
+/**
+  Method that writes bytes at the end of the pack.
+  @param data is the bytes to write.
+  @param length is the number of bytes.
+  @throw std::runtime_error if they cannot be written.
+*/
+void PackWriter::writeToFile(const void* data, size_t length)
+{
+   const char* bytes = static_cast<const char*>(data);
+   while (length > 0)
+   {
+      ssize_t written = ::pwrite(this->descriptor, bytes, length, this->end);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         throw std::runtime_error("Unable to write " + this->fileName + ": " + strerror(errno));
+      }
+      bytes += written;
+      length -= written;
+      this->end += written;
+   }
+}
+
+/**
+  Method that writes zeros up to the next offset multiple of 64.
+*/
+void PackWriter::align()
+{
+   static const char zeros[binaryInstanceAlignment] = {};
+   writeToFile(zeros, binaryInstanceAlign(this->end) - this->end);
+}
+
+/**
+  Method that reads the index of an existing pack, so that new entries are
+  added to it.
+  @param size is the size of the file (or the offset where the index ends).
+         A pack with only the header (size of the header) has no index yet.
+  @param scan is true to take the last valid index if there is none at the
+         end (the pack was not closed after adding entries, see
+         findPackTrailer; with no valid index, it has no entries), false to
+         require the index that ends at size.
+  @throw std::runtime_error if the file is not a valid pack.
+*/
+void PackWriter::readIndex(uint64_t size, bool scan)
+{
+   tPackHeader header;
+   if (size < sizeof(header) ||
+       ::pread(this->descriptor, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+       memcmp(header.magic, packMagic, sizeof(packMagic)) != 0)
+      throw std::runtime_error(this->fileName + ": not a pack file");
+   if (header.byteOrder != binaryInstanceByteOrder || header.version != packVersion)
+      throw std::runtime_error(this->fileName + ": pack written by a different version or machine");
+   if (size == sizeof(header))
+      return;
+
+   auto read = [this](uint64_t offset, void* buffer, size_t length)
+   {
+      return ::pread(this->descriptor, buffer, length, offset) == (ssize_t)length;
+   };
+   tPackTrailer trailer;
+   if (scan)
+   {
+      if (!findPackTrailer(size, read, trailer))
+         return;
+   }
+   else if (size < sizeof(header) + sizeof(trailer) || !packTrailerAt(size - sizeof(trailer), read, trailer))
+      throw std::runtime_error(this->fileName + ": truncated pack file (no index)");
+
+   std::vector<char> index(trailer.indexSize);
+   if (!read(trailer.indexOffset, index.data(), index.size()))
+      throw std::runtime_error(this->fileName + ": corrupted index");
+
+   size_t entriesSize = trailer.entries * sizeof(tPackEntry);
+   this->entries.resize(trailer.entries);
+   memcpy(this->entries.data(), index.data(), entriesSize);
+   this->names.assign(index.begin() + entriesSize, index.end());
+}
+
+/**
+  Method that compares data of the file with bytes in memory (the mutex
+  must be locked).
+  @param offset is the offset of the data within the file.
+  @param data is the content it is compared with.
+  @param size is its size in bytes.
+  @return true if the file has those bytes at that offset.
+  @throw std::runtime_error if the file cannot be read.
+*/
+bool PackWriter::sameData(uint64_t offset, const void* data, size_t size) const
+{
+   if (offset > this->end || size > this->end - offset)
+      return false;
+
+   char block[65536];
+   for (size_t done = 0; done < size; )
+   {
+      ssize_t length = ::pread(this->descriptor, block, std::min<size_t>(sizeof(block), size - done), offset + done);
+      if (length < 0 && errno == EINTR)
+         continue;
+      if (length <= 0)
+         throw std::runtime_error("Unable to read " + this->fileName + ": " + strerror(errno));
+      if (memcmp(block, static_cast<const char*>(data) + done, length) != 0)
+         return false;
+      done += length;
+   }
+   return true;
+}
+
+// --- Public --- //
+
+/**
+  Default Ctor.
+*/
+PackWriter::PackWriter() : descriptor(-1), end(0)
+{
+}
+
+/**
+  Dtor. It writes the index (errors are ignored, call close() to detect them).
+*/
+PackWriter::~PackWriter()
+{
+   try
+   {
+      close();
+   }
+   catch (const std::exception&)
+   {
+   }
+}
+
+/**
+  Method that opens a pack. If the file exists, its entries are kept and
+  the new ones are added after them; otherwise, it is created. If the pack
+  was not closed the last time entries were added to it, the entries of its
+  last valid index are kept (the others are only recovered with a journal).
+  @param fileName is the path to the pack.
+  @throw std::runtime_error if it cannot be opened or it is not a pack.
+*/
+void PackWriter::open(const std::string& fileName)
+{
+   open(fileName, 0);
+}
+
+/**
+  Method that opens a pack whose valid index is not necessarily at the end
+  of the file, but the one written when the pack had a given size (e.g.
+  the pack of a batch that was interrupted, see Journal). The data after
+  it is kept, so that entries can be recovered, and new entries are added
+  after the end of the file.
+  @param fileName is the path to the pack.
+  @param validSize is the size of the pack when its index was written (0
+         means the whole file; the size of the header, a pack without index).
+  @throw std::runtime_error if it cannot be opened or it is not a pack.
+*/
+void PackWriter::open(const std::string& fileName, uint64_t validSize)
+{
+   close();
+   this->fileName = fileName;
+   this->descriptor = ::open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+   if (this->descriptor < 0)
+      throw std::runtime_error("Unable to open " + fileName + ": " + strerror(errno));
+
+   try
+   {
+      struct stat status;
+      if (fstat(this->descriptor, &status) != 0)
+         throw std::runtime_error("Unable to open " + fileName + ": " + strerror(errno));
+
+      if (validSize > (uint64_t)status.st_size)
+         throw std::runtime_error(fileName + ": truncated pack file");
+
+      if (status.st_size > 0)
+      {
+         // New entries go after the end of the file; until close() writes a new trailer, readers find the previous one
+         readIndex(validSize > 0 ? validSize : status.st_size, validSize == 0);
+         this->end = status.st_size;
+      }
+      else
+      {
+         tPackHeader header;
+         memset(&header, 0, sizeof(header));
+         memcpy(header.magic, packMagic, sizeof(header.magic));
+         header.version = packVersion;
+         header.byteOrder = binaryInstanceByteOrder;
+         writeToFile(&header, sizeof(header));
+      }
+   }
+   catch (const std::runtime_error&)
+   {
+      ::close(this->descriptor);
+      this->descriptor = -1;
+      this->entries.clear();
+      this->names.clear();
+      this->end = 0;
+      throw;
+   }
+}
+
+/**
+  Method that writes the index and the trailer and closes the pack.
+  @throw std::runtime_error if they cannot be written.
+*/
+void PackWriter::close()
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      return;
+
+   std::string message;
+   try
+   {
+      align();
+
+      tPackTrailer trailer;
+      memset(&trailer, 0, sizeof(trailer));
+      memcpy(trailer.magic, packIndexMagic, sizeof(trailer.magic));
+      trailer.indexOffset = this->end;
+      trailer.entries = this->entries.size();
+      trailer.indexSize = this->entries.size() * sizeof(tPackEntry) + this->names.size();
+
+      uint64_t checksum = binaryInstanceHash(binaryInstanceHashSeed, this->entries.data(), this->entries.size() * sizeof(tPackEntry));
+      trailer.indexChecksum = binaryInstanceHash(checksum, this->names.data(), this->names.size());
+
+      writeToFile(this->entries.data(), this->entries.size() * sizeof(tPackEntry));
+      writeToFile(this->names.data(), this->names.size());
+      writeToFile(&trailer, sizeof(trailer));
+   }
+   catch (const std::runtime_error& exception)
+   {
+      message = exception.what();
+   }
+
+   ::close(this->descriptor);
+   this->descriptor = -1;
+   this->entries.clear();
+   this->names.clear();
+   this->end = 0;
+   if (!message.empty())
+      throw std::runtime_error(message);
+}
+
+/**
+  Method that adds an entry to the pack. It may be invoked by several
+  threads at the same time.
+  @param name is the name of the entry (e.g. the name of the file).
+  @param data is the content of the entry.
+  @param size is the size in bytes of the content.
+  @return the position of the entry within the index.
+  @throw std::runtime_error if it cannot be written.
+*/
+size_t PackWriter::append(const std::string& name, const void* data, size_t size)
+{
+   // The checksum is computed before taking the lock
+   tPackEntry entry;
+   memset(&entry, 0, sizeof(entry));
+   entry.size = size;
+   entry.checksum = binaryInstanceHash(binaryInstanceHashSeed, data, size);
+   entry.nameLength = name.size();
+
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+
+   align();
+   entry.offset = this->end;
+   entry.nameOffset = this->names.size();
+   writeToFile(data, size);
+
+   this->names.insert(this->names.end(), name.begin(), name.end());
+   this->entries.push_back(entry);
+   return this->entries.size() - 1;
+}
+
+/**
+  Method that adds an entry with the same content as a previous one: the
+  new entry of the index points to the data of the previous one, so it is
+  not written again. It may be invoked by several threads at the same time.
+  @param name is the name of the entry.
+  @param entry is the position of the previous entry (as returned by append).
+  @throw std::runtime_error if the pack is not open or the entry does not exist.
+*/
+void PackWriter::link(const std::string& name, size_t entry)
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+   if (entry >= this->entries.size())
+      throw std::runtime_error("Unknown entry of " + this->fileName);
+
+   tPackEntry copy = this->entries[entry];
+   copy.nameOffset = this->names.size();
+   copy.nameLength = name.size();
+   this->names.insert(this->names.end(), name.begin(), name.end());
+   this->entries.push_back(copy);
+}
+
+/**
+  Method that tells whether an entry has a given content. The data is read
+  back and compared byte by byte, e.g. to confirm that a matrix with the
+  same hash as the entry is the same matrix before linking to it. It may
+  be invoked by several threads at the same time.
+  @param entry is the position of the entry (as returned by append).
+  @param data is the content.
+  @param size is its size in bytes.
+  @return true if the entry has that size and those bytes.
+  @throw std::runtime_error if the pack is not open, the entry does not exist or it cannot be read.
+*/
+bool PackWriter::equals(size_t entry, const void* data, size_t size) const
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+   if (entry >= this->entries.size())
+      throw std::runtime_error("Unknown entry of " + this->fileName);
+
+   return this->entries[entry].size == size && sameData(this->entries[entry].offset, data, size);
+}
+
+/**
+  Method that adds all the entries of another pack, in the order of its
+  index. Their checksums are not computed again. The data of an entry is
+  only copied if this pack has no data with the same content (same size
+  and checksum, and the same bytes), e.g. a matrix shared by instances
+  of different shards is stored once in the merged pack.
+  @param fileName is the path to the other pack.
+  @return the number of entries added.
+  @throw std::runtime_error if the other pack cannot be read or the entries cannot be written.
+*/
+size_t PackWriter::merge(const std::string& fileName)
+{
+   PackReader other(fileName.c_str());
+
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+
+   // Offsets of the data of this pack by its size and checksum
+   std::multimap<std::pair<uint64_t, uint64_t>, uint64_t> stored;
+   for (size_t i = 0; i < this->entries.size(); i++)
+      stored.insert(std::make_pair(std::make_pair(this->entries[i].size, this->entries[i].checksum), this->entries[i].offset));
+
+   for (size_t i = 0; i < other.size(); i++)
+   {
+      const PackReader::tEntry& source = other.entry(i);
+
+      tPackEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.size = source.size;
+      entry.checksum = source.checksum;
+      entry.nameOffset = this->names.size();
+      entry.nameLength = source.name.size();
+
+      // Same content as data already stored (compared byte by byte, as checksums may collide)
+      bool found = false;
+      std::pair<uint64_t, uint64_t> key(entry.size, entry.checksum);
+      typedef std::multimap<std::pair<uint64_t, uint64_t>, uint64_t>::const_iterator tIterator;
+      std::pair<tIterator, tIterator> candidates = stored.equal_range(key);
+      for (tIterator candidate = candidates.first; candidate != candidates.second && !found; candidate++)
+      {
+         found = sameData(candidate->second, source.data, source.size);
+         entry.offset = candidate->second;
+      }
+
+      if (!found)
+      {
+         align();
+         entry.offset = this->end;
+         writeToFile(source.data, source.size);
+         stored.insert(std::make_pair(key, entry.offset));
+      }
+
+      this->names.insert(this->names.end(), source.name.begin(), source.name.end());
+      this->entries.push_back(entry);
+   }
+   return other.size();
+}
+
+/**
+  Method that returns the number of entries of the pack.
+  @return the number of entries, including those of a previous pack.
+*/
+size_t PackWriter::size() const
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   return this->entries.size();
+}
+
+/**
+  Method that checks that data written to the file before, but that is not
+  in its index (e.g. the entries of a batch that was interrupted, recorded
+  in a journal), is still in the file.
+  @param offset is the offset of the data within the file.
+  @param size is the size in bytes of the data.
+  @param checksum is the checksum (FNV-1a) of the data.
+  @param verify is true to read the data and check its checksum.
+  @return false if the data does not lie within the file or, if verified,
+          its checksum does not match.
+  @throw std::runtime_error if the pack is not open or it cannot be read.
+*/
+bool PackWriter::contains(uint64_t offset, uint64_t size, uint64_t checksum, bool verify) const
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+   if (offset < sizeof(tPackHeader) || offset > this->end || size > this->end - offset)
+      return false;
+
+   if (verify)
+   {
+      char block[65536];
+      uint64_t hash = binaryInstanceHashSeed;
+      for (uint64_t done = 0; done < size; )
+      {
+         ssize_t length = ::pread(this->descriptor, block, std::min<uint64_t>(sizeof(block), size - done), offset + done);
+         if (length < 0 && errno == EINTR)
+            continue;
+         if (length <= 0)
+            throw std::runtime_error("Unable to read " + this->fileName + ": " + strerror(errno));
+         hash = binaryInstanceHash(hash, block, length);
+         done += length;
+      }
+      if (hash != checksum)
+         return false;
+   }
+   return true;
+}
+
+/**
+  Method that adds to the index an entry whose data is already in the file
+  (see contains).
+  @param name is the name of the entry.
+  @param offset is the offset of the data within the file.
+  @param size is the size in bytes of the data.
+  @param checksum is the checksum (FNV-1a) of the data.
+  @throw std::runtime_error if the pack is not open.
+*/
+void PackWriter::recover(const std::string& name, uint64_t offset, uint64_t size, uint64_t checksum)
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+
+   tPackEntry entry;
+   memset(&entry, 0, sizeof(entry));
+   entry.offset = offset;
+   entry.size = size;
+   entry.checksum = checksum;
+   entry.nameOffset = this->names.size();
+   entry.nameLength = name.size();
+   this->names.insert(this->names.end(), name.begin(), name.end());
+   this->entries.push_back(entry);
+}
+
+/**
+  Method that flushes the data written so far to disk (not the index, which
+  is written by close()). It may be invoked by several threads at the same time.
+  @throw std::runtime_error if the pack is not open or it cannot be flushed.
+*/
+void PackWriter::sync()
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (this->descriptor < 0)
+      throw std::runtime_error("The pack is not open");
+   if (fdatasync(this->descriptor) != 0)
+      throw std::runtime_error("Unable to write " + this->fileName + ": " + strerror(errno));
+}
+
+/**
+  Method that returns an entry of the index.
+  @param i is the position of the entry (as returned by append).
+  @return the entry.
+  @throw std::runtime_error if it does not exist.
+*/
+tPackEntry PackWriter::entry(size_t i) const
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   if (i >= this->entries.size())
+      throw std::runtime_error("Unknown entry of " + this->fileName);
+   return this->entries[i];
+}
+
+/**
+  Method that returns the size of the file written so far, which is the
+  size of the pack when it is opened (see open with a valid size).
+  @return the size in bytes (0 if it is not open).
+*/
+uint64_t PackWriter::bytes() const
+{
+   std::lock_guard<std::mutex> lock(this->packMutex);
+   return this->end;
+}
@@ -0,0 +1,145 @@
+#ifndef PACKWRITER_H
+#define PACKWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "packfile.h"
+
+/**
+  Writer of pack files (see packfile.h):
+     Entries are written as they are added and the index is kept in memory
+     until close() writes it at the end of the file. Adding entries is
+     thread-safe, so the output files of several instances can be packed
+     at the same time. Entries with the same content as a previous one
+     may share its data (see link), so it is stored only once.
+     If the batch is interrupted before close(), the entries written since
+     the pack was opened are not in any index (readers and open find the
+     previous one); they can be recovered with the information of a
+     journal (see open with a valid size, and recover).
+     The entries of other packs (e.g. those of the shards of a batch) can
+     be added to a pack, so that a single index finds all of them (see
+     merge).
+     Errors are reported by throwing std::runtime_error.
+   \code
+      PackWriter pack;
+      pack.open("batch.pack");
+      pack.append("test100Specs.dat", contents.data(), contents.size());
+      pack.close();
+   \endcode
+*/
+class PackWriter
+{
+   private:
+      //! File descriptor (-1 if it is not open) and offset of its end
+      int descriptor;
+      uint64_t end;
+
+      //! Name of the file (for error messages)
+      std::string fileName;
+
+      //! Index: entries and the characters of their names
+      std::vector<tPackEntry> entries;
+      std::vector<char> names;
+
+      //! Mutex that guards the file and the index
+      mutable std::mutex packMutex;
+
+      //! Method that writes bytes at the end of the file
+      void writeToFile(const void*, size_t);
+
+      //! Method that pads the file up to the start of the next entry
+      void align();
+
+      //! Method that reads the index of an existing pack
+      void readIndex(uint64_t, bool);
+
+      //! Method that compares data of the file with bytes in memory
+      bool sameData(uint64_t, const void*, size_t) const;
+
+      //! Non-copyable
+      PackWriter(const PackWriter&);
+      PackWriter& operator=(const PackWriter&);
+
+   public:
+
+      //! Default Ctor.
+      PackWriter();
+
+      //! Dtor. It writes the index (errors are ignored, call close() to detect them).
+      ~PackWriter();
+
+      //! Method that opens a pack (it is created if it does not exist, otherwise entries are added to it)
+      void open(const std::string& fileName);
+
+      //! Method that opens a pack whose index is the one that ends at a given offset (the data after it is kept)
+      /*!
+        \param fileName is the path to the pack.
+        \param validSize is the size of the pack when that index was written (see bytes()).
+      */
+      void open(const std::string& fileName, uint64_t validSize);
+
+      //! Method that writes the index and closes the file
+      void close();
+
+      //! Method that adds an entry (thread-safe)
+      /*!
+        \param name is the name of the entry.
+        \param data is the content of the entry.
+        \param size is the size in bytes of the content.
+        \return the position of the entry within the index.
+      */
+      size_t append(const std::string& name, const void* data, size_t size);
+
+      //! Method that adds an entry with the same content as a previous one, without copying it (thread-safe)
+      /*!
+        \param name is the name of the entry.
+        \param entry is the position of the previous entry (as returned by append).
+      */
+      void link(const std::string& name, size_t entry);
+
+      //! Method that tells whether an entry has the given content, compared byte by byte (thread-safe)
+      /*!
+        \param entry is the position of the entry (as returned by append).
+        \param data is the content.
+        \param size is its size in bytes.
+      */
+      bool equals(size_t entry, const void* data, size_t size) const;
+
+      //! Method that checks that data written before (e.g. recorded in a journal) is in the file
+      /*!
+        \param offset is the offset of the data.
+        \param size is the size in bytes of the data.
+        \param checksum is the checksum of the data.
+        \param verify is true to read the data and check the checksum.
+        \return false if the data is not in the file (or its checksum does not match).
+      */
+      bool contains(uint64_t offset, uint64_t size, uint64_t checksum, bool verify) const;
+
+      //! Method that adds to the index an entry whose data is already in the file (see contains)
+      void recover(const std::string& name, uint64_t offset, uint64_t size, uint64_t checksum);
+
+      //! Method that adds all the entries of another pack (thread-safe)
+      /*!
+        \param fileName is the path to the other pack.
+        \return the number of entries added.
+      */
+      size_t merge(const std::string& fileName);
+
+      //! Method that flushes the entries written so far to disk (thread-safe)
+      void sync();
+
+      //! Returns the number of entries
+      size_t size() const;
+
+      //! Returns the i-th entry of the index
+      tPackEntry entry(size_t) const;
+
+      //! Returns the size in bytes of the file written so far
+      uint64_t bytes() const;
+};
+
+#endif // PACKWRITER_H
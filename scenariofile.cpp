@@ -0,0 +1,614 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "conversions.h"
+#include "scenariofile.h"
+#include "xmlpullparser.h"
+
+namespace
+{
+   //! Max number of instances of a sweep (a mistyped range must not exhaust the memory)
+   const size_t maxSweepInstances = 1000000;
+
+   /**
+     Function that reads an optional attribute of the current element.
+     @param parser is the parser positioned at the start of the element.
+     @param name is the name of the attribute.
+     @param value is where the value is stored (unchanged if it is missing).
+   */
+   template <typename T>
+   void optionalAttribute(const XmlPullParser& parser, const char* name, T& value)
+   {
+      const std::string_view* attribute = parser.attribute(name);
+      if (!attribute)
+         return;
+
+      try
+      {
+         value = fromStringTo<T>(attribute->data(), attribute->data() + attribute->size());
+      }
+      catch (const std::invalid_argument& exception)
+      {
+         throw std::runtime_error("Invalid attribute '" + std::string(name) + "' in <" + std::string(parser.name()) + ">: " + exception.what());
+      }
+   }
+
+   template <>
+   void optionalAttribute(const XmlPullParser& parser, const char* name, std::string& value)
+   {
+      const std::string_view* attribute = parser.attribute(name);
+      if (attribute)
+         value = std::string(*attribute);
+   }
+
+   //! A list of values separated by spaces or commas (e.g. the proportions of the clusters)
+   template <>
+   void optionalAttribute(const XmlPullParser& parser, const char* name, std::vector<double>& values)
+   {
+      const std::string_view* attribute = parser.attribute(name);
+      if (!attribute)
+         return;
+
+      values.clear();
+      std::string text(*attribute);
+      std::replace(text.begin(), text.end(), ',', ' ');
+      std::istringstream tokens(text);
+      std::string token;
+      while (tokens >> token)
+      {
+         try
+         {
+            values.push_back(fromStringTo<double>(token));
+         }
+         catch (const std::invalid_argument& exception)
+         {
+            throw std::runtime_error("Invalid attribute '" + std::string(name) + "' in <" + std::string(parser.name()) + ">: " + exception.what());
+         }
+      }
+   }
+
+   /**
+     Function that reads an optional attribute with a list of values of a
+     sweep, separated by spaces or commas. A value may be a range
+     "first..last" (both included). Values may not be repeated (they would
+     give instances with the same name) and there may be at most
+     maxSweepInstances of them.
+     @param parser is the parser positioned at the start of the element.
+     @param name is the name of the attribute.
+     @param values is where the values are stored (unchanged if it is missing).
+   */
+   void optionalList(const XmlPullParser& parser, const char* name, std::vector<unsigned>& values)
+   {
+      const std::string_view* attribute = parser.attribute(name);
+      if (!attribute)
+         return;
+
+      std::string invalid = "Invalid attribute '" + std::string(name) + "' in <" + std::string(parser.name()) + ">: ";
+      values.clear();
+      const char* current = attribute->data();
+      const char* end = current + attribute->size();
+      while (current < end)
+      {
+         if (*current == ' ' || *current == ',' || *current == '\t' || *current == '\n' || *current == '\r')
+         {
+            current++;
+            continue;
+         }
+
+         const char* last = current;
+         while (last < end && *last != ' ' && *last != ',' && *last != '\t' && *last != '\n' && *last != '\r')
+            last++;
+         std::string_view token(current, last - current);
+         current = last;
+
+         try
+         {
+            size_t dots = token.find("..");
+            if (dots == std::string_view::npos)
+            {
+               if (values.size() == maxSweepInstances)
+                  throw std::invalid_argument("more than " + somethingToString(maxSweepInstances) + " values");
+               values.push_back(fromStringTo<unsigned>(token.data(), token.data() + token.size()));
+               continue;
+            }
+
+            unsigned first = fromStringTo<unsigned>(token.data(), token.data() + dots);
+            unsigned lastValue = fromStringTo<unsigned>(token.data() + dots + 2, token.data() + token.size());
+            if (lastValue < first)
+               throw std::invalid_argument("empty range " + std::string(token));
+            if (lastValue - first >= maxSweepInstances - values.size())
+               throw std::invalid_argument("more than " + somethingToString(maxSweepInstances) + " values");
+            for (unsigned value = first; ; value++)
+            {
+               values.push_back(value);
+               if (value == lastValue)
+                  break;
+            }
+         }
+         catch (const std::invalid_argument& exception)
+         {
+            throw std::runtime_error(invalid + exception.what());
+         }
+      }
+
+      if (values.empty())
+         throw std::runtime_error(invalid + "no values");
+
+      std::vector<unsigned> sorted(values);
+      std::sort(sorted.begin(), sorted.end());
+      std::vector<unsigned>::const_iterator repeated = std::adjacent_find(sorted.begin(), sorted.end());
+      if (repeated != sorted.end())
+         throw std::runtime_error(invalid + "repeated value " + somethingToString(*repeated));
+   }
+
+   /**
+     Function that checks that the labels of the specifications of a sweep
+     are not repeated (they would give instances with the same name).
+     @param specifications is the list of specifications with their labels.
+     @param where is the description of the sweep (for the messages).
+   */
+   template <typename Spec>
+   void checkLabels(const std::vector<std::pair<std::string, Spec> >& specifications, const std::string& where)
+   {
+      for (size_t i = 1; i < specifications.size(); i++)
+         for (size_t j = 0; j < i; j++)
+            if (specifications[i].first == specifications[j].first)
+               throw std::runtime_error("Repeated specification '" + specifications[i].first + "' in " + where);
+   }
+
+   /**
+     Function that returns the label of a specification section within the
+     names of a sweep: its name, its reference or the name of its file
+     without directories nor extension (e.g. "tw0" for "dataset/tw0.xml").
+     @param parser is the parser positioned at the start of the section.
+     @return the label.
+   */
+   std::string sectionLabel(const XmlPullParser& parser)
+   {
+      std::string name, reference, fileName;
+      optionalAttribute(parser, "name", name);
+      optionalAttribute(parser, "ref", reference);
+      optionalAttribute(parser, "file", fileName);
+      if (!name.empty())
+         return name;
+      if (!reference.empty())
+         return reference;
+
+      size_t slash = fileName.find_last_of("/\\");
+      if (slash != std::string::npos)
+         fileName.erase(0, slash + 1);
+      size_t dot = fileName.find('.');
+      if (dot != std::string::npos)
+         fileName.erase(dot);
+      if (fileName.empty())
+         throw std::runtime_error("Unnamed <" + std::string(parser.name()) + "> in a sweep of " + parser.getFileName());
+      return fileName;
+   }
+
+   /**
+     Function that skips the rest of the current element.
+     @param parser is the parser positioned at the start of the element.
+   */
+   void skipElement(XmlPullParser& parser)
+   {
+      unsigned depth = parser.getDepth();
+      while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+         ;
+   }
+
+   /**
+     Function that reads a specification section of a scenario: it either
+     references a file (file="..."), references a section named before
+     (ref="...") or contains the specification itself (optionally named).
+     @param parser is the parser positioned at the start of the section.
+     @param registry is where the specifications are kept.
+     @param load, get, add and read are the SpecRegistry methods for this kind of specification.
+     @return the compiled specification.
+   */
+   template <typename Spec>
+   std::shared_ptr<const Spec> readSection(XmlPullParser& parser, SpecRegistry& registry,
+                                           std::shared_ptr<const Spec> (SpecRegistry::*load)(const std::string&, const char*),
+                                           std::shared_ptr<const Spec> (SpecRegistry::*get)(const std::string&) const,
+                                           void (SpecRegistry::*add)(const std::string&, std::shared_ptr<const Spec>),
+                                           std::shared_ptr<const Spec> (*read)(XmlPullParser&))
+   {
+      std::string fileName, reference, name;
+      optionalAttribute(parser, "file", fileName);
+      optionalAttribute(parser, "ref", reference);
+      optionalAttribute(parser, "name", name);
+
+      std::shared_ptr<const Spec> spec;
+      if (!fileName.empty())
+      {
+         spec = (registry.*load)(fileName, fileName.c_str());
+         skipElement(parser);
+      }
+      else if (!reference.empty())
+      {
+         spec = (registry.*get)(reference);
+         if (!spec)
+            throw std::runtime_error("Unknown specification '" + reference + "' in " + parser.getFileName());
+         skipElement(parser);
+      }
+      else
+      {
+         spec = read(parser);
+         if (!name.empty())
+            (registry.*add)(name, spec);
+      }
+
+      return spec;
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that reads an element of a scenario that a variant may also
+  contain: the seeds of the specifications, the output options and the
+  specification sections.
+  @param parser is the parser positioned at the start of the element.
+  @param registry is where the specifications are kept.
+  @param scenario is where the values read are stored.
+  @return false if the element is not one of them.
+*/
+bool ScenarioFile::readVariantElement(XmlPullParser& parser, SpecRegistry& registry, tScenario& scenario)
+{
+   if (parser.name() == "seeds")
+   {
+      optionalAttribute(parser, "time-windows", scenario.timeWindowSeed);
+      optionalAttribute(parser, "demands", scenario.demandSeed);
+      optionalAttribute(parser, "service-times", scenario.serviceTimeSeed);
+   }
+   else if (parser.name() == "output")
+   {
+      optionalAttribute(parser, "prefix", scenario.prefix);
+      optionalAttribute(parser, "format", scenario.matrixFormat);
+      optionalAttribute(parser, "precision", scenario.matrixPrecision);
+      unsigned binary = scenario.binaryOutput;
+      optionalAttribute(parser, "binary", binary);
+      scenario.binaryOutput = (binary != 0);
+      optionalAttribute(parser, "compression", scenario.compression);
+   }
+   else if (parser.name() == "time-windows-specification")
+      scenario.timeWindows = readSection(parser, registry, &SpecRegistry::loadTimeWindows, &SpecRegistry::getTimeWindows,
+                                         &SpecRegistry::addTimeWindows, &SpecRegistry::readTimeWindows);
+   else if (parser.name() == "demands-specifications")
+      scenario.demands = readSection(parser, registry, &SpecRegistry::loadDemands, &SpecRegistry::getDemands,
+                                     &SpecRegistry::addDemands, &SpecRegistry::readDemands);
+   else if (parser.name() == "service-times-specifications")
+      scenario.serviceTimes = readSection(parser, registry, &SpecRegistry::loadServiceTimes, &SpecRegistry::getServiceTimes,
+                                          &SpecRegistry::addServiceTimes, &SpecRegistry::readServiceTimes);
+   else
+      return false;
+
+   return true;
+}
+
+/**
+  Method that reads a variant of a scenario.
+  @param parser is the parser positioned at the start of the <variant> element (it is left at its end).
+  @param registry is where the specifications are kept.
+  @param scenario is the scenario (as read up to the variant).
+  @param variant is where the variant is stored.
+*/
+void ScenarioFile::readVariant(XmlPullParser& parser, SpecRegistry& registry, const tScenario& scenario, tScenario& variant)
+{
+   variant = scenario;
+   std::string name;
+   optionalAttribute(parser, "name", name);
+   if (name.empty())
+      throw std::runtime_error("Missing name of a variant of scenario '" + scenario.name + "' in " + parser.getFileName());
+   variant.name = scenario.name + "." + name;
+   variant.prefix = scenario.prefix + "." + name;
+
+   unsigned depth = parser.getDepth();
+   while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+   {
+      // Only the elements directly within it (those of the specifications are read by readSection)
+      if (!parser.isStartElement() || parser.getDepth() != depth + 1)
+         continue;
+
+      if (parser.name() == "seeds" && parser.attribute("matrices"))
+         throw std::runtime_error("The seed of the matrices is shared by the variants of scenario '" + scenario.name + "' in " + parser.getFileName());
+      if (!readVariantElement(parser, registry, variant))
+         throw std::runtime_error("Unexpected <" + std::string(parser.name()) + "> in a variant of scenario '" + scenario.name + "' in " + parser.getFileName());
+   }
+}
+
+/**
+  Method that checks that a scenario is complete.
+  @param scenario is the scenario.
+  @param fileName is the name of the scenario file (for error messages).
+  @throw std::runtime_error if something is missing.
+*/
+void ScenarioFile::check(const tScenario& scenario, const std::string& fileName)
+{
+   std::string where = "scenario '" + scenario.name + "' of " + fileName;
+   if (scenario.size == 0)
+      throw std::runtime_error("Missing size in " + where);
+   if (!scenario.timeWindows)
+      throw std::runtime_error("Missing <time-windows-specification> in " + where);
+   if (!scenario.demands)
+      throw std::runtime_error("Missing <demands-specifications> in " + where);
+   if (!scenario.serviceTimes)
+      throw std::runtime_error("Missing <service-times-specifications> in " + where);
+   if (scenario.prefix.empty())
+      throw std::runtime_error("Missing output prefix in " + where);
+}
+
+/**
+  Method that reads a scenario. If it has variants, they are appended
+  instead of the scenario itself.
+  @param parser is the parser positioned at the start of the <scenario> element (it is left at its end).
+  @param registry is where the specifications are kept.
+  @param scenarios is the vector where the scenario (or its variants) is appended.
+*/
+void ScenarioFile::readScenario(XmlPullParser& parser, SpecRegistry& registry, std::vector<tScenario>& scenarios)
+{
+   tScenario scenario = defaultScenario();
+   optionalAttribute(parser, "name", scenario.name);
+   optionalAttribute(parser, "size", scenario.size);
+   unsigned reachable = 0;
+   optionalAttribute(parser, "reachable", reachable);
+   scenario.reachableTimeWindows = (reachable != 0);
+   optionalAttribute(parser, "demand-scenarios", scenario.demandScenarios);
+   scenario.prefix = scenario.name;
+
+   std::vector<tScenario> variants;
+   unsigned depth = parser.getDepth();
+   while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+   {
+      if (!parser.isStartElement() || parser.getDepth() != depth + 1)
+         continue;
+
+      // The other seeds are read with the elements of the variants
+      if (parser.name() == "seeds")
+         optionalAttribute(parser, "matrices", scenario.matrixSeed);
+
+      if (parser.name() == "selection")
+      {
+         optionalAttribute(parser, "mode", scenario.samplingMode);
+         optionalAttribute(parser, "radius", scenario.samplingRadius);
+         optionalAttribute(parser, "clusters", scenario.numberOfClusters);
+         optionalAttribute(parser, "proportions", scenario.clusterProportions);
+      }
+      else if (parser.name() == "variant")
+      {
+         variants.push_back(tScenario());
+         readVariant(parser, registry, scenario, variants.back());
+      }
+      else
+         readVariantElement(parser, registry, scenario);
+   }
+
+   if (variants.empty())
+      variants.push_back(scenario);
+
+   for (size_t i = 0; i < variants.size(); i++)
+   {
+      check(variants[i], parser.getFileName());
+      scenarios.push_back(variants[i]);
+   }
+}
+
+/**
+  Method that reads a sweep and appends its instances: the Cartesian
+  product of its sizes, seeds and specifications. They are appended size
+  by size and seed of the matrices by seed of the matrices, so those that
+  share a sample of costumers (hence its matrices) are consecutive and
+  the sample is drawn only once (see BatchPipeline).
+  @param parser is the parser positioned at the start of the <sweep> element (it is left at its end).
+  @param registry is where the specifications are kept.
+  @param scenarios is the vector where the instances are appended.
+*/
+void ScenarioFile::readSweep(XmlPullParser& parser, SpecRegistry& registry, std::vector<tScenario>& scenarios)
+{
+   tScenario scenario = defaultScenario();
+   std::string name = "test";
+   optionalAttribute(parser, "name", name);
+   unsigned reachable = 0;
+   optionalAttribute(parser, "reachable", reachable);
+   scenario.reachableTimeWindows = (reachable != 0);
+   optionalAttribute(parser, "demand-scenarios", scenario.demandScenarios);
+
+   std::vector<unsigned> sizes;
+   std::vector<unsigned> matrixSeeds(1, 0);
+   std::vector<unsigned> timeWindowSeeds(1, 0);
+   std::vector<unsigned> demandSeeds(1, 0);
+   std::vector<unsigned> serviceTimeSeeds(1, 0);
+   optionalList(parser, "sizes", sizes);
+   optionalList(parser, "matrices", matrixSeeds);
+   optionalList(parser, "time-windows", timeWindowSeeds);
+   optionalList(parser, "demands", demandSeeds);
+   optionalList(parser, "service-times", serviceTimeSeeds);
+
+   std::string where = "sweep '" + name + "' of " + parser.getFileName();
+   if (sizes.empty())
+      throw std::runtime_error("Missing sizes in " + where);
+
+   // Specifications with their labels (the service times are not part of the names)
+   std::vector<std::pair<std::string, std::shared_ptr<const tTimeWindowSpec> > > timeWindows;
+   std::vector<std::pair<std::string, std::shared_ptr<const tDemandSpec> > > demands;
+   std::string outputPrefix;
+
+   unsigned depth = parser.getDepth();
+   while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+   {
+      if (!parser.isStartElement() || parser.getDepth() != depth + 1)
+         continue;
+
+      if (parser.name() == "selection")
+      {
+         optionalAttribute(parser, "mode", scenario.samplingMode);
+         optionalAttribute(parser, "radius", scenario.samplingRadius);
+         optionalAttribute(parser, "clusters", scenario.numberOfClusters);
+         optionalAttribute(parser, "proportions", scenario.clusterProportions);
+      }
+      else if (parser.name() == "output")
+      {
+         // The prefix is prepended to the names (e.g. a directory)
+         readVariantElement(parser, registry, scenario);
+         outputPrefix = scenario.prefix;
+      }
+      else if (parser.name() == "time-windows-specification")
+      {
+         std::string label = sectionLabel(parser);
+         readVariantElement(parser, registry, scenario);
+         timeWindows.push_back(std::make_pair(label, scenario.timeWindows));
+      }
+      else if (parser.name() == "demands-specifications")
+      {
+         std::string label = sectionLabel(parser);
+         readVariantElement(parser, registry, scenario);
+         demands.push_back(std::make_pair(label, scenario.demands));
+      }
+      else if (parser.name() == "service-times-specifications")
+      {
+         if (scenario.serviceTimes)
+            throw std::runtime_error("More than one <service-times-specifications> in " + where);
+         readVariantElement(parser, registry, scenario);
+      }
+      else
+         throw std::runtime_error("Unexpected <" + std::string(parser.name()) + "> in " + where);
+   }
+
+   if (timeWindows.empty())
+      throw std::runtime_error("Missing <time-windows-specification> in " + where);
+   if (demands.empty())
+      throw std::runtime_error("Missing <demands-specifications> in " + where);
+   checkLabels(timeWindows, where);
+   checkLabels(demands, where);
+
+   // Size of the grid, checked before expanding it
+   const size_t lengths[] = { sizes.size(), matrixSeeds.size(), timeWindowSeeds.size(), demandSeeds.size(),
+                              serviceTimeSeeds.size(), demands.size(), timeWindows.size() };
+   size_t instances = 1;
+   for (size_t length : lengths)
+   {
+      if (length > maxSweepInstances / instances)
+         throw std::runtime_error("More than " + somethingToString(maxSweepInstances) + " instances in " + where);
+      instances *= length;
+   }
+   scenarios.reserve(scenarios.size() + instances);
+
+   for (size_t n = 0; n < sizes.size(); n++)
+      for (size_t m = 0; m < matrixSeeds.size(); m++)
+         for (size_t tw = 0; tw < timeWindowSeeds.size(); tw++)
+            for (size_t d = 0; d < demandSeeds.size(); d++)
+               for (size_t st = 0; st < serviceTimeSeeds.size(); st++)
+                  for (size_t i = 0; i < demands.size(); i++)
+                     for (size_t j = 0; j < timeWindows.size(); j++)
+                     {
+                        scenario.size = sizes[n];
+                        scenario.matrixSeed = matrixSeeds[m];
+                        scenario.timeWindowSeed = timeWindowSeeds[tw];
+                        scenario.demandSeed = demandSeeds[d];
+                        scenario.serviceTimeSeed = serviceTimeSeeds[st];
+                        scenario.demands = demands[i].second;
+                        scenario.timeWindows = timeWindows[j].second;
+
+                        // testN-sM-sTW-sD-sST.dX.twY
+                        scenario.name = name + somethingToString(scenario.size) + "-" + somethingToString(scenario.matrixSeed) + "-" +
+                                        somethingToString(scenario.timeWindowSeed) + "-" + somethingToString(scenario.demandSeed) + "-" +
+                                        somethingToString(scenario.serviceTimeSeed) + "." + demands[i].first + "." + timeWindows[j].first;
+                        scenario.prefix = outputPrefix + scenario.name;
+                        check(scenario, parser.getFileName());
+                        scenarios.push_back(scenario);
+                     }
+}
+
+// --- Public --- //
+
+/**
+  Method that returns a scenario with the default options (those of the
+  generator) and no specifications.
+  @return the scenario.
+*/
+tScenario ScenarioFile::defaultScenario()
+{
+   tScenario scenario;
+   scenario.size = 0;
+   scenario.matrixSeed = 0;
+   scenario.timeWindowSeed = 0;
+   scenario.demandSeed = 0;
+   scenario.serviceTimeSeed = 0;
+   scenario.samplingMode = "Random";
+   scenario.samplingRadius = 0;
+   scenario.numberOfClusters = 8;
+   scenario.reachableTimeWindows = false;
+   scenario.demandScenarios = 0;
+   scenario.matrixFormat = "General";
+   scenario.matrixPrecision = 6;
+   scenario.binaryOutput = false;
+   scenario.compression = "None";
+   return scenario;
+}
+
+/**
+  Method that reads all the scenarios of a file in one pass.
+  @param fileName is the path to the scenario file.
+  @param registry is where referenced and named specifications are kept.
+  @param scenarios is the vector where the scenarios are appended.
+  @throw std::runtime_error if the file is not valid.
+*/
+void ScenarioFile::read(const char* fileName, SpecRegistry& registry, std::vector<tScenario>& scenarios)
+{
+   XmlPullParser parser;
+   parser.open(fileName);
+   if (!parser.next() || (parser.name() != "scenarios" && parser.name() != "scenario" && parser.name() != "sweep"))
+      throw std::runtime_error("Missing <scenarios> in " + std::string(fileName));
+
+   if (parser.name() == "scenario")
+   {
+      readScenario(parser, registry, scenarios);
+      return;
+   }
+   if (parser.name() == "sweep")
+   {
+      readSweep(parser, registry, scenarios);
+      return;
+   }
+
+   while (parser.next())
+      if (parser.isStartElement() && parser.getDepth() == 2 && parser.name() == "scenario")
+         readScenario(parser, registry, scenarios);
+      else if (parser.isStartElement() && parser.getDepth() == 2 && parser.name() == "sweep")
+         readSweep(parser, registry, scenarios);
+}
@@ -0,0 +1,117 @@
+#ifndef SCENARIOFILE_H
+#define SCENARIOFILE_H
+
+#include <string>
+#include <vector>
+
+#include "dataTypes.h"
+#include "specregistry.h"
+
+class XmlPullParser;
+
+/**
+  Scenario files:
+     A single document with everything needed to generate one or more
+     instances, read in one pass. E.g.:
+   \code
+   <scenarios>
+      <scenario name="test100-0-0-0-0.d0.tw0" size="100" reachable="0" demand-scenarios="0">
+         <seeds matrices="0" time-windows="0" demands="0" service-times="0"/>
+         <selection mode="Random" radius="0" clusters="8"/>
+         <time-windows-specification name="tw0"> ... </time-windows-specification>
+         <demands-specifications file="dataset/demands/d0.xml"/>
+         <service-times-specifications file="dataset/service-times/st.xml"/>
+         <output prefix="test100-0-0-0-0.d0.tw0" format="General" precision="6" binary="0" compression="None"/>
+      </scenario>
+      <scenario name="test100-1-0-0-0.d0.tw0" size="100">
+         <seeds matrices="1"/>
+         <time-windows-specification ref="tw0"/>
+         ...
+      </scenario>
+   </scenarios>
+   \endcode
+     The specification sections have the same content as the specification
+     files. Instead, they may reference a file (parsed only once for the
+     whole batch) or a section named in a previous scenario (or one of the
+     standard presets, e.g. ref="tw0-equal", see specpresets.h). A document
+     with a single <scenario> as root is also valid. Omitted seeds and
+     options take their default values and the prefix defaults to the name.
+     In KMeans mode, <selection> may also weight the costumers drawn from
+     each cluster, e.g. proportions="2 1 1 1 1 1 1 1" (one per cluster).
+     A scenario may fan out into variants that share its sample of
+     costumers (hence its matrices, generated only once) and differ in
+     their specifications, their seeds or their output:
+   \code
+      <scenario name="test150-0-0-0-0" size="150">
+         <service-times-specifications ref="st0-equal"/>
+         <variant name="d0.tw0">
+            <demands-specifications ref="d0-equal"/>
+            <time-windows-specification ref="tw0-equal"/>
+         </variant>
+         <variant name="d1.tw0">
+            <seeds demands="1"/>
+            <demands-specifications ref="d1-equal"/>
+            <time-windows-specification ref="tw0-equal"/>
+         </variant>
+      </scenario>
+   \endcode
+     Each variant takes what precedes it within the scenario and is named
+     (and prefixed) "<scenario>.<variant>". Variants replace the scenario:
+     they are the instances generated.
+     A sweep stands for the Cartesian product of lists of sizes, seeds and
+     specifications (a list may hold ranges, e.g. "0..9"):
+   \code
+      <sweep name="test" sizes="50 150 250 1000" matrices="0..4" time-windows="0" demands="0" service-times="0">
+         <selection mode="Random"/>
+         <output prefix="movrptw/" binary="1"/>
+         <service-times-specifications ref="st0-equal"/>
+         <demands-specifications ref="d0-equal"/>
+         <demands-specifications file="dataset/demands/d2.xml"/>
+         <time-windows-specification ref="tw0-equal"/>
+         <time-windows-specification ref="tw1-equal"/>
+      </sweep>
+   \endcode
+     Its instances are named as those of the dataset,
+     "<name><size>-<seed matrices>-<seed time windows>-<seed demands>-<seed service times>.<demands>.<time windows>"
+     (e.g. "test50-0-0-0-0.d2.tw1-equal"), the specifications by their name,
+     reference or file (without extension), and prefixed with the output
+     prefix followed by the name. Those with the same size and seed of the
+     matrices are consecutive, so each sample is drawn only once. Seeds
+     default to 0 and there is a single specification of service times.
+     Names must be unique, so repeated values (e.g. sizes="50,50" or
+     overlapping ranges) and specifications with the same label are
+     rejected, and so is a grid of more than a million instances.
+*/
+class ScenarioFile
+{
+   private:
+      //! Method that reads a scenario (or its variants) from the current element
+      static void readScenario(XmlPullParser&, SpecRegistry&, std::vector<tScenario>&);
+
+      //! Method that reads a variant of a scenario from the current element
+      static void readVariant(XmlPullParser&, SpecRegistry&, const tScenario&, tScenario&);
+
+      //! Method that reads an element that both scenarios and variants may contain
+      static bool readVariantElement(XmlPullParser&, SpecRegistry&, tScenario&);
+
+      //! Method that reads a sweep (the instances of a grid of parameters) from the current element
+      static void readSweep(XmlPullParser&, SpecRegistry&, std::vector<tScenario>&);
+
+      //! Method that checks that a scenario is complete
+      static void check(const tScenario&, const std::string&);
+
+   public:
+
+      //! Method that reads all the scenarios of a file
+      /*!
+        \param fileName is the name of the scenario file.
+        \param registry is where referenced and named specifications are kept.
+        \param scenarios is the vector where the scenarios are appended.
+      */
+      static void read(const char* fileName, SpecRegistry& registry, std::vector<tScenario>& scenarios);
+
+      //! Returns a scenario with the default options and no specifications
+      static tScenario defaultScenario();
+};
+
+#endif // SCENARIOFILE_H
@@ -0,0 +1,266 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "spatialindex.h"
+
+namespace
+{
+   //! Mean radius of the Earth in km
+   const double earthRadius = 6371.0;
+
+   //! Degrees to radians
+   const double degreesToRadians = 3.14159265358979323846 / 180.0;
+
+   //! Comparators to split a range of nodes by one of the coordinates
+   template <typename Node>
+   bool lessX(const Node& a, const Node& b) { return a.x < b.x; }
+
+   template <typename Node>
+   bool lessY(const Node& a, const Node& b) { return a.y < b.y; }
+}
+
+// --- Private --- //
+
+/**
+  Method that projects a position to the plane (km).
+  @param lat is the latitude of the position.
+  @param lng is the longitude of the position.
+  @param x is the projected horizontal coordinate.
+  @param y is the projected vertical coordinate.
+*/
+void SpatialIndex::project(double lat, double lng, double& x, double& y) const
+{
+   x = earthRadius * lng * degreesToRadians * this->referenceCos;
+   y = earthRadius * lat * degreesToRadians;
+}
+
+/**
+  Method that builds the implicit tree over the range [from, to) by placing
+  the median (according to the splitting axis) in the middle of the range.
+  @param from is the first node of the range.
+  @param to is the end of the range.
+  @param depth is the depth of the range in the tree (selects the axis).
+*/
+void SpatialIndex::build(size_t from, size_t to, unsigned depth)
+{
+   if (to - from < 2)
+      return;
+
+   size_t middle = from + (to - from) / 2;
+   if (depth % 2 == 0)
+      std::nth_element(this->nodes.begin() + from, this->nodes.begin() + middle, this->nodes.begin() + to, lessX<tNode>);
+   else
+      std::nth_element(this->nodes.begin() + from, this->nodes.begin() + middle, this->nodes.begin() + to, lessY<tNode>);
+
+   build(from, middle, depth + 1);
+   build(middle + 1, to, depth + 1);
+}
+
+/**
+  Method that collects the nodes within a (squared) radius of a point.
+  @param from is the first node of the range.
+  @param to is the end of the range.
+  @param depth is the depth of the range in the tree.
+  @param x is the horizontal coordinate of the point.
+  @param y is the vertical coordinate of the point.
+  @param radius2 is the squared radius.
+  @param result is the vector where the indexes found are appended.
+*/
+void SpatialIndex::radiusSearch(size_t from, size_t to, unsigned depth, double x, double y, double radius2, std::vector<unsigned>& result) const
+{
+   if (from >= to)
+      return;
+
+   size_t middle = from + (to - from) / 2;
+   const tNode& node = this->nodes[middle];
+
+   double dx = node.x - x;
+   double dy = node.y - y;
+   if (dx * dx + dy * dy <= radius2)
+      result.push_back(node.index);
+
+   double delta = (depth % 2 == 0)? x - node.x : y - node.y;
+   if (delta <= 0 || delta * delta <= radius2)
+      radiusSearch(from, middle, depth + 1, x, y, radius2, result);
+   if (delta >= 0 || delta * delta <= radius2)
+      radiusSearch(middle + 1, to, depth + 1, x, y, radius2, result);
+}
+
+/**
+  Method that keeps, in a max-heap, the k nodes closest to a point.
+  @param from is the first node of the range.
+  @param to is the end of the range.
+  @param depth is the depth of the range in the tree.
+  @param x is the horizontal coordinate of the point.
+  @param y is the vertical coordinate of the point.
+  @param k is the number of nodes wanted.
+  @param heap is the max-heap of (squared distance, index) found so far.
+*/
+void SpatialIndex::nearestSearch(size_t from, size_t to, unsigned depth, double x, double y, unsigned k, std::vector<std::pair<double, unsigned> >& heap) const
+{
+   if (from >= to)
+      return;
+
+   size_t middle = from + (to - from) / 2;
+   const tNode& node = this->nodes[middle];
+
+   double dx = node.x - x;
+   double dy = node.y - y;
+   double distance2 = dx * dx + dy * dy;
+   if (heap.size() < k)
+   {
+      heap.push_back(std::make_pair(distance2, node.index));
+      std::push_heap(heap.begin(), heap.end());
+   }
+   else if (distance2 < heap.front().first)
+   {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = std::make_pair(distance2, node.index);
+      std::push_heap(heap.begin(), heap.end());
+   }
+
+   // Closest side first, the other one only if it can still improve the heap
+   double delta = (depth % 2 == 0)? x - node.x : y - node.y;
+   if (delta <= 0)
+   {
+      nearestSearch(from, middle, depth + 1, x, y, k, heap);
+      if (heap.size() < k || delta * delta < heap.front().first)
+         nearestSearch(middle + 1, to, depth + 1, x, y, k, heap);
+   }
+   else
+   {
+      nearestSearch(middle + 1, to, depth + 1, x, y, k, heap);
+      if (heap.size() < k || delta * delta < heap.front().first)
+         nearestSearch(from, middle, depth + 1, x, y, k, heap);
+   }
+}
+
+// --- Public --- //
+
+/**
+  Ctor. The index is empty until build() is invoked.
+*/
+SpatialIndex::SpatialIndex()
+{
+   this->referenceCos = 1;
+}
+
+/**
+  Method that builds the index. It takes O(N log N) time.
+  @param positions is the vector of positions to be indexed.
+*/
+void SpatialIndex::build(const costumersPosType& positions)
+{
+   this->nodes.clear();
+   if (positions.empty())
+      return;
+
+   double meanLat = 0;
+   for (size_t i = 0; i < positions.size(); i++)
+      meanLat += positions[i].lat;
+   meanLat /= positions.size();
+   this->referenceCos = cos(meanLat * degreesToRadians);
+
+   this->nodes.resize(positions.size());
+   for (size_t i = 0; i < positions.size(); i++)
+   {
+      project(positions[i].lat, positions[i].lng, this->nodes[i].x, this->nodes[i].y);
+      this->nodes[i].index = i;
+   }
+
+   build(0, this->nodes.size(), 0);
+}
+
+/**
+  Method that tells whether the index has been built.
+  @return true if there are no positions indexed.
+*/
+bool SpatialIndex::empty() const
+{
+   return this->nodes.empty();
+}
+
+/**
+  Method that returns the positions within a radius of a given point.
+  @param lat is the latitude of the point.
+  @param lng is the longitude of the point.
+  @param radius is the radius in km.
+  @param result is the vector (cleared first) with the indexes found.
+*/
+void SpatialIndex::withinRadius(double lat, double lng, double radius, std::vector<unsigned>& result) const
+{
+   result.clear();
+   double x, y;
+   project(lat, lng, x, y);
+   radiusSearch(0, this->nodes.size(), 0, x, y, radius * radius, result);
+}
+
+/**
+  Method that returns the k nearest positions to a given point.
+  @param lat is the latitude of the point.
+  @param lng is the longitude of the point.
+  @param k is the number of positions wanted.
+  @param result is the vector (cleared first) with the indexes found, closest first.
+*/
+void SpatialIndex::nearest(double lat, double lng, unsigned k, std::vector<unsigned>& result) const
+{
+   result.clear();
+   if (k == 0)
+      return;
+
+   double x, y;
+   project(lat, lng, x, y);
+
+   std::vector<std::pair<double, unsigned> > heap;
+   heap.reserve(k);
+   nearestSearch(0, this->nodes.size(), 0, x, y, k, heap);
+
+   std::sort_heap(heap.begin(), heap.end());
+   for (size_t i = 0; i < heap.size(); i++)
+      result.push_back(heap[i].second);
+}
+
+/**
+  Method that returns the distance between two points using the same
+  projection as the index.
+  @return the distance in km.
+*/
+double SpatialIndex::distance(double lat1, double lng1, double lat2, double lng2) const
+{
+   double x1, y1, x2, y2;
+   project(lat1, lng1, x1, y1);
+   project(lat2, lng2, x2, y2);
+   return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+}
@@ -0,0 +1,69 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "dataTypes.h"
+
+/**
+  Spatial index over the positions of the costumers:
+     Implicit 2d-tree built once over the (lat, lng) positions. Coordinates
+     are projected to kilometres (equirectangular projection around the mean
+     latitude), which is accurate enough at the scale of a road network.
+     Queries return indexes within the positions vector used to build it.
+*/
+class SpatialIndex
+{
+   private:
+      //! Node of the implicit tree (median of each range is the splitting node)
+      struct tNode
+      {
+         double x;
+         double y;
+         unsigned index;
+      };
+
+      //! Nodes sorted as an implicit 2d-tree
+      std::vector<tNode> nodes;
+
+      //! Cosine of the reference latitude used in the projection
+      double referenceCos;
+
+      //! Recursive construction over [from, to)
+      void build(size_t from, size_t to, unsigned depth);
+
+      //! Recursive radius search over [from, to)
+      void radiusSearch(size_t from, size_t to, unsigned depth, double x, double y, double radius2, std::vector<unsigned>& result) const;
+
+      //! Recursive k-nearest search over [from, to)
+      void nearestSearch(size_t from, size_t to, unsigned depth, double x, double y, unsigned k, std::vector<std::pair<double, unsigned> >& heap) const;
+
+      //! Projection of a (lat, lng) position to the plane
+      void project(double lat, double lng, double& x, double& y) const;
+
+   public:
+
+      //! Default Ctor.
+      SpatialIndex();
+
+      //! Method that builds the index over a set of positions
+      /*!
+        \param positions is the vector of positions to be indexed.
+      */
+      void build(const costumersPosType& positions);
+
+      //! Returns true if the index has not been built yet
+      bool empty() const;
+
+      //! Method that returns the positions within a radius (km) of a point
+      void withinRadius(double lat, double lng, double radius, std::vector<unsigned>& result) const;
+
+      //! Method that returns the k nearest positions to a point, closest first
+      void nearest(double lat, double lng, unsigned k, std::vector<unsigned>& result) const;
+
+      //! Method that returns the (projected) distance in km between two points
+      double distance(double lat1, double lng1, double lat2, double lng2) const;
+};
+
+#endif // SPATIALINDEX_H
@@ -0,0 +1,235 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include "distributions.h"
+#include "specpresets.h"
+
+namespace
+{
+   /**
+     Cumulative probabilities of time windows and demands (compile time).
+     The first category is reserved, exactly as in SpecRegistry::compile.
+     @param categories is the array of categories.
+     @return the cumulative probabilities (one per category plus the final 1).
+   */
+   template <typename Category, size_t N>
+   constexpr std::array<double, N + 1> accumulate(const Category (&categories)[N])
+   {
+      unsigned sum = 0;
+      for (size_t i = 0; i < N; i++)
+         sum += categories[i].probability;
+
+      std::array<double, N + 1> accProbability = {};
+      for (size_t i = 1; i < N; i++)
+         accProbability[i] = accProbability[i - 1] + (categories[i].probability / (double)sum);
+      accProbability[N] = 1;
+      return accProbability;
+   }
+
+   /**
+     Cumulative probabilities of service times (compile time), exactly as in
+     SpecRegistry::compile.
+     @param categories is the array of categories.
+     @return the cumulative probabilities (one per category plus 0 and the final 1).
+   */
+   template <size_t N>
+   constexpr std::array<double, N + 2> accumulateServiceTimes(const tServiceTimeCostumer (&categories)[N])
+   {
+      unsigned sum = 0;
+      for (size_t i = 0; i < N; i++)
+         sum += categories[i].probability;
+
+      std::array<double, N + 2> accProbability = {};
+      for (size_t i = 1; i <= N; i++)
+         accProbability[i] = accProbability[i - 1] + (categories[i - 1].probability / (double)sum);
+      accProbability[N + 1] = 1;
+      return accProbability;
+   }
+
+   // Working day of 8 hours (seconds)
+   constexpr tTimeWindowDepot workingDay = {0, 28800};
+
+   // - Time windows
+   constexpr tTimeWindowCostumer tw0[] = {{0, 28800, 100}};
+   constexpr tTimeWindowCostumer tw1[] = {{0, 9600, 33}, {9600, 19200, 33}, {19200, 28800, 34}};
+   constexpr tTimeWindowCostumer tw2[] = {{0, 7200, 33}, {10500, 18300, 33}, {21000, 28800, 34}};
+   constexpr tTimeWindowCostumer tw3[] = {{0, 6000, 33}, {11400, 17400, 33}, {22800, 28800, 34}};
+   constexpr tTimeWindowCostumer tw4[] = {{0, 28800, 10},
+                                          {0, 9600, 10}, {9600, 19200, 10}, {19200, 28800, 10},
+                                          {0, 7200, 10}, {10500, 18300, 10}, {21000, 28800, 10},
+                                          {0, 6000, 10}, {11400, 17400, 10}, {22800, 28800, 10}};
+
+   constexpr std::array<double, 2> tw0Acc = accumulate(tw0);
+   constexpr std::array<double, 4> tw1Acc = accumulate(tw1);
+   constexpr std::array<double, 4> tw2Acc = accumulate(tw2);
+   constexpr std::array<double, 4> tw3Acc = accumulate(tw3);
+   constexpr std::array<double, 11> tw4Acc = accumulate(tw4);
+
+   // - Demands (the looseness of the fleet is what distinguishes d0-equal from d1-equal)
+   constexpr tDemandCostumer demands[] = {{10, 33}, {20, 33}, {30, 34}};
+   constexpr std::array<double, 4> demandsAcc = accumulate(demands);
+
+   // - Service times
+   constexpr tServiceTimeCostumer st0[] = {{600, 33}, {1200, 33}, {1800, 34}};
+   constexpr std::array<double, 5> st0Acc = accumulateServiceTimes(st0);
+
+   static_assert(tw1Acc[3] == 1 && tw4Acc[0] == 0 && st0Acc[4] == 1, "Wrong cumulative probabilities");
+
+   //! Preset of any kind: its categories and cumulative probabilities
+   template <typename Category>
+   struct tPreset
+   {
+      const char* name;
+      const Category* categories;
+      size_t size;
+      const double* accProbability;
+      size_t accSize;
+   };
+
+   template <typename Category, size_t N, size_t M>
+   constexpr tPreset<Category> preset(const char* name, const Category (&categories)[N], const std::array<double, M>& accProbability)
+   {
+      return tPreset<Category>{name, categories, N, accProbability.data(), M};
+   }
+
+   constexpr tPreset<tTimeWindowCostumer> timeWindowsPresets[] = {preset("tw0-equal", tw0, tw0Acc),
+                                                                  preset("tw1-equal", tw1, tw1Acc),
+                                                                  preset("tw2-equal", tw2, tw2Acc),
+                                                                  preset("tw3-equal", tw3, tw3Acc),
+                                                                  preset("tw4-equal", tw4, tw4Acc)};
+
+   constexpr tPreset<tDemandCostumer> demandsPresets[] = {preset("d0-equal", demands, demandsAcc),
+                                                          preset("d1-equal", demands, demandsAcc)};
+
+   // Looseness of each demands preset
+   constexpr unsigned demandsDelta[] = {60, 20};
+
+   constexpr tPreset<tServiceTimeCostumer> serviceTimesPresets[] = {preset("st0-equal", st0, st0Acc)};
+
+   /**
+     Function that looks up a preset by name.
+     @param presets is the table of presets.
+     @param name is the name of the preset.
+     @return its index within the table (N if there is none).
+   */
+   template <typename Category, size_t N>
+   size_t findPreset(const tPreset<Category> (&presets)[N], const std::string& name)
+   {
+      size_t i = 0;
+      while (i < N && name != presets[i].name)
+         i++;
+      return i;
+   }
+}
+
+/**
+  Function that returns a time windows preset.
+  @param name is the name of the preset (tw0-equal to tw4-equal).
+  @return the compiled specification (NULL if there is no preset with that name).
+*/
+std::shared_ptr<const tTimeWindowSpec> timeWindowsPreset(const std::string& name)
+{
+   size_t index = findPreset(timeWindowsPresets, name);
+   if (index == std::size(timeWindowsPresets))
+      return std::shared_ptr<const tTimeWindowSpec>();
+
+   const tPreset<tTimeWindowCostumer>& preset = timeWindowsPresets[index];
+   std::shared_ptr<tTimeWindowSpec> spec(new tTimeWindowSpec);
+   spec->timeWindows.timeWindowDepot = workingDay;
+   spec->timeWindows.timeWindowsCostumers.assign(preset.categories, preset.categories + preset.size);
+   spec->timeWindows.opensDistribution = noDistribution();
+   spec->timeWindows.widthDistribution = noDistribution();
+   spec->accProbability.assign(preset.accProbability, preset.accProbability + preset.accSize);
+   return spec;
+}
+
+/**
+  Function that returns a demands preset.
+  @param name is the name of the preset (d0-equal or d1-equal).
+  @return the compiled specification (NULL if there is no preset with that name).
+*/
+std::shared_ptr<const tDemandSpec> demandsPreset(const std::string& name)
+{
+   size_t index = findPreset(demandsPresets, name);
+   if (index == std::size(demandsPresets))
+      return std::shared_ptr<const tDemandSpec>();
+
+   const tPreset<tDemandCostumer>& preset = demandsPresets[index];
+   std::shared_ptr<tDemandSpec> spec(new tDemandSpec);
+   spec->demands.delta = demandsDelta[index];
+   spec->demands.demandsCostumers.assign(preset.categories, preset.categories + preset.size);
+   spec->demands.distribution = noDistribution();
+   spec->accProbability.assign(preset.accProbability, preset.accProbability + preset.accSize);
+   return spec;
+}
+
+/**
+  Function that returns a service times preset.
+  @param name is the name of the preset (st0-equal).
+  @return the compiled specification (NULL if there is no preset with that name).
+*/
+std::shared_ptr<const tServiceTimeSpec> serviceTimesPreset(const std::string& name)
+{
+   size_t index = findPreset(serviceTimesPresets, name);
+   if (index == std::size(serviceTimesPresets))
+      return std::shared_ptr<const tServiceTimeSpec>();
+
+   const tPreset<tServiceTimeCostumer>& preset = serviceTimesPresets[index];
+   std::shared_ptr<tServiceTimeSpec> spec(new tServiceTimeSpec);
+   spec->serviceTimes.serviceTimesCostumers.assign(preset.categories, preset.categories + preset.size);
+   spec->serviceTimes.distribution = noDistribution();
+   spec->accProbability.assign(preset.accProbability, preset.accProbability + preset.accSize);
+   return spec;
+}
+
+/**
+  Function that returns the names of the presets.
+  @param timeWindows, demands and serviceTimes are the vectors where the names of each kind are stored.
+*/
+void presetNames(std::vector<std::string>& timeWindows, std::vector<std::string>& demands, std::vector<std::string>& serviceTimes)
+{
+   timeWindows.clear();
+   for (size_t i = 0; i < std::size(timeWindowsPresets); i++)
+      timeWindows.push_back(timeWindowsPresets[i].name);
+
+   demands.clear();
+   for (size_t i = 0; i < std::size(demandsPresets); i++)
+      demands.push_back(demandsPresets[i].name);
+
+   serviceTimes.clear();
+   for (size_t i = 0; i < std::size(serviceTimesPresets); i++)
+      serviceTimes.push_back(serviceTimesPresets[i].name);
+}
@@ -0,0 +1,33 @@
+#ifndef SPECPRESETS_H
+#define SPECPRESETS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dataTypes.h"
+
+/**
+  Standard specifications embedded in the binary:
+     Time windows (tw0-equal to tw4-equal), demands (d0-equal and d1-equal)
+     and service times (st0-equal) shaped after those of the published
+     dataset (same working day, windows and looseness), but with their
+     categories equally likely: they are not the dataset's tables, hence
+     the suffix. Their cumulative probabilities are computed at compile
+     time, so selecting one of them involves no file nor parsing. A preset
+     is only used when there is no file with its name.
+*/
+
+//! Returns the time windows preset with the given name (NULL if there is none)
+std::shared_ptr<const tTimeWindowSpec> timeWindowsPreset(const std::string& name);
+
+//! Returns the demands preset with the given name (NULL if there is none)
+std::shared_ptr<const tDemandSpec> demandsPreset(const std::string& name);
+
+//! Returns the service times preset with the given name (NULL if there is none)
+std::shared_ptr<const tServiceTimeSpec> serviceTimesPreset(const std::string& name);
+
+//! Returns the names of all the presets of each kind
+void presetNames(std::vector<std::string>& timeWindows, std::vector<std::string>& demands, std::vector<std::string>& serviceTimes);
+
+#endif // SPECPRESETS_H
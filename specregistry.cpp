@@ -0,0 +1,581 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+#include "conversions.h"
+#include "distributions.h"
+#include "specpresets.h"
+#include "specregistry.h"
+#include "xmlpullparser.h"
+
+namespace
+{
+   /**
+     Function that tells whether a file exists.
+     @param fileName is the path to the file.
+     @return true if there is a file with that name.
+   */
+   bool fileExists(const char* fileName)
+   {
+      struct stat status;
+      return stat(fileName, &status) == 0;
+   }
+
+   /**
+     Function that outputs a warning message (same format as the generator).
+     @param warningMessage is the message to be output.
+   */
+   void warning(const std::string& warningMessage)
+   {
+      std::cout << "[WARNING]: " << warningMessage << std::endl;
+   }
+
+   /**
+     Function that checks that the bounds of a distribution make sense: min
+     not greater than max (for a uniform, also its own min and max), a
+     non-negative deviation and, for values that cannot be negative (e.g.
+     demands), a non-negative min.
+     @param distribution is the distribution (nothing is checked if there is none).
+     @param what is the attribute it draws (for the messages).
+     @param nonNegative is true if the values cannot be negative.
+   */
+   void checkDistribution(const tDistribution& distribution, const std::string& what, bool nonNegative)
+   {
+      if (distribution.type == NO_DISTRIBUTION)
+         return;
+
+      if (distribution.type == UNIFORM_DISTRIBUTION && distribution.first > distribution.second)
+         throw std::runtime_error("The min of the " + what + " distribution is greater than its max");
+      if (distribution.type != UNIFORM_DISTRIBUTION && distribution.second < 0)
+         throw std::runtime_error("The deviation of the " + what + " distribution is negative");
+      if (distribution.min > distribution.max)
+         throw std::runtime_error("The min of the " + what + " distribution is greater than its max");
+      if (nonNegative && (distribution.min < 0 || (distribution.type == UNIFORM_DISTRIBUTION && distribution.first < 0)))
+         throw std::runtime_error("The min of the " + what + " distribution is negative");
+   }
+
+   /**
+     Function that returns the sum of the probabilities of a set of categories,
+     warning if it is not 100 and failing if there are no categories.
+     @param categories is the vector of categories.
+     @param what is the kind of specification (for the messages).
+     @return the sum of the probabilities.
+   */
+   template <typename Category>
+   unsigned sumOfProbabilities(const std::vector<Category>& categories, const std::string& what)
+   {
+      if (categories.empty())
+         throw std::runtime_error("There are no categories nor distribution in the " + what + " specification");
+
+      unsigned sum = 0;
+      for (size_t i = 0; i < categories.size(); i++)
+         sum += categories[i].probability;
+
+      if (sum != 100)
+         warning("Error - The sum of probabilities in the " + what + " specification file is not 100.");
+      if (sum == 0)
+         throw std::runtime_error("The sum of probabilities in the " + what + " specification is 0");
+
+      return sum;
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that reads the value of an attribute of the current element.
+  @param parser is the parser positioned at the start of the element.
+  @param name is the name of the attribute.
+  @return the value converted to T.
+  @throw std::runtime_error if it is missing or not valid.
+*/
+template <typename T>
+T SpecRegistry::getAttribute(const XmlPullParser& parser, const char* name)
+{
+   const std::string_view* value = parser.attribute(name);
+   if (!value)
+      throw std::runtime_error("Missing attribute '" + std::string(name) + "' in <" + std::string(parser.name()) + ">");
+
+   try
+   {
+      return fromStringTo<T>(value->data(), value->data() + value->size());
+   }
+   catch (const std::invalid_argument& exception)
+   {
+      throw std::runtime_error("Invalid attribute '" + std::string(name) + "' in <" + std::string(parser.name()) + ">: " + exception.what());
+   }
+}
+
+/**
+  Method that reads a continuous distribution from the current element. E.g.:
+     <distribution type="uniform" min="10" max="30"/>
+     <distribution type="normal" mean="20" stddev="5" min="1"/>
+     <distribution type="lognormal" mu="2.9" sigma="0.4" max="100"/>
+  min and max are optional for normal and lognormal (0 and no limit by default).
+  The bounds are checked when the specification is compiled (see compile).
+  @param parser is the parser positioned at the start of the element.
+  @return the distribution.
+*/
+tDistribution SpecRegistry::readDistribution(const XmlPullParser& parser)
+{
+   tDistribution distribution = noDistribution();
+
+   const std::string_view* type = parser.attribute("type");
+   if (!type || !distributionTypeFromString(std::string(*type), distribution.type))
+      throw std::runtime_error("Unknown type of distribution in <" + std::string(parser.name()) + ">");
+
+   if (distribution.type == UNIFORM_DISTRIBUTION)
+   {
+      distribution.first = getAttribute<double>(parser, "min");
+      distribution.second = getAttribute<double>(parser, "max");
+   }
+   else if (distribution.type == NORMAL_DISTRIBUTION)
+   {
+      distribution.first = getAttribute<double>(parser, "mean");
+      distribution.second = getAttribute<double>(parser, "stddev");
+   }
+   else
+   {
+      distribution.first = getAttribute<double>(parser, "mu");
+      distribution.second = getAttribute<double>(parser, "sigma");
+   }
+   if (parser.attribute("min"))
+      distribution.min = getAttribute<double>(parser, "min");
+   if (parser.attribute("max"))
+      distribution.max = getAttribute<double>(parser, "max");
+
+   return distribution;
+}
+
+/**
+  Method that opens a specification file and checks its root element.
+  @param parser is the parser employed.
+  @param fileName is the path to the file.
+  @param root is the name of the expected root element.
+*/
+void SpecRegistry::openSpecification(XmlPullParser& parser, const char* fileName, const char* root)
+{
+   parser.open(fileName);
+   if (!parser.next() || parser.name() != root)
+      throw std::runtime_error("Missing <" + std::string(root) + "> in " + std::string(fileName));
+}
+
+// --- Public --- //
+
+/**
+  Method that parses the time windows specification. The file is read as a
+  stream of elements, hence the memory employed does not depend on its size.
+  If there is no such file but there is a standard preset with that name,
+  the preset is returned instead.
+  @param fileName is the path to the file containing the time windows specification.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tTimeWindowSpec> SpecRegistry::parseTimeWindows(const char* fileName)
+{
+    std::shared_ptr<const tTimeWindowSpec> preset = timeWindowsPreset(fileName);
+    if (preset && !fileExists(fileName))
+        return preset;
+
+    XmlPullParser parser;
+    openSpecification(parser, fileName, "time-windows-specification");
+    return readTimeWindows(parser);
+}
+
+/**
+  Method that parses the demand specifications (streaming), falling back to
+  the standard preset with that name if there is no such file.
+  @param fileName is the path to the file containing the demands specifications.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tDemandSpec> SpecRegistry::parseDemands(const char* fileName)
+{
+    std::shared_ptr<const tDemandSpec> preset = demandsPreset(fileName);
+    if (preset && !fileExists(fileName))
+        return preset;
+
+    XmlPullParser parser;
+    openSpecification(parser, fileName, "demands-specifications");
+    return readDemands(parser);
+}
+
+/**
+  Method that parses the service times specifications (streaming), falling
+  back to the standard preset with that name if there is no such file.
+  @param fileName is the path to the file containing the specifications.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tServiceTimeSpec> SpecRegistry::parseServiceTimes(const char* fileName)
+{
+    std::shared_ptr<const tServiceTimeSpec> preset = serviceTimesPreset(fileName);
+    if (preset && !fileExists(fileName))
+        return preset;
+
+    XmlPullParser parser;
+    openSpecification(parser, fileName, "service-times-specifications");
+    return readServiceTimes(parser);
+}
+
+/**
+  Method that reads a time windows specification. The parser must be
+  positioned at the start of the element that contains it (the root of a
+  file or a section of a scenario file) and it is left at its end.
+  @param parser is the parser.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tTimeWindowSpec> SpecRegistry::readTimeWindows(XmlPullParser& parser)
+{
+    unsigned depth = parser.getDepth();
+    tTimeWindow timeWindows;
+    timeWindows.opensDistribution = noDistribution();
+    timeWindows.widthDistribution = noDistribution();
+    bool depot = false;
+    std::string_view section;
+    while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+    {
+        if (!parser.isStartElement())
+            continue;
+
+        // As in the original files: <depot> and <time-windows> within the root, <time-window> within <time-windows>
+        unsigned level = parser.getDepth() - depth;
+        if (level == 1)
+            section = parser.name();
+
+        if (level == 1 && parser.name() == "depot")
+        {
+            timeWindows.timeWindowDepot.opens = getAttribute<double>(parser, "opens");
+            timeWindows.timeWindowDepot.closes = getAttribute<double>(parser, "closes");
+            depot = true;
+        }
+        else if (level == 2 && section == "time-windows" && parser.name() == "time-window")
+        {
+            tTimeWindowCostumer timeWindowCostumer;
+            timeWindowCostumer.opens = getAttribute<double>(parser, "opens");
+            timeWindowCostumer.closes = getAttribute<double>(parser, "closes");
+            timeWindowCostumer.probability = getAttribute<unsigned>(parser, "probability");
+            timeWindows.timeWindowsCostumers.push_back(timeWindowCostumer);
+        }
+        // Continuous time windows: opening time and width
+        else if (level == 1 && parser.name() == "opens-distribution")
+            timeWindows.opensDistribution = readDistribution(parser);
+        else if (level == 1 && parser.name() == "width-distribution")
+            timeWindows.widthDistribution = readDistribution(parser);
+    }
+
+    if (!depot)
+        throw std::runtime_error("Missing <depot> in " + parser.getFileName());
+
+    return compile(timeWindows);
+}
+
+/**
+  Method that reads a demands specification (see readTimeWindows).
+  @param parser is the parser.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tDemandSpec> SpecRegistry::readDemands(XmlPullParser& parser)
+{
+    unsigned depth = parser.getDepth();
+    tDemand demands;
+    demands.distribution = noDistribution();
+    bool delta = false;
+    std::string_view section;
+    while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+    {
+        if (!parser.isStartElement())
+            continue;
+
+        unsigned level = parser.getDepth() - depth;
+        if (level == 1)
+            section = parser.name();
+
+        // Parse looseness
+        if (level == 1 && parser.name() == "delta")
+        {
+            demands.delta = getAttribute<unsigned>(parser, "value");
+            delta = true;
+        }
+        else if (level == 2 && section == "demands" && parser.name() == "demand")
+        {
+            tDemandCostumer demandCostumer;
+            demandCostumer.type = getAttribute<unsigned>(parser, "type");
+            demandCostumer.probability = getAttribute<double>(parser, "probability");
+            demands.demandsCostumers.push_back(demandCostumer);
+        }
+        // Continuous demands
+        else if (level == 1 && parser.name() == "distribution")
+            demands.distribution = readDistribution(parser);
+    }
+
+    if (!delta)
+        throw std::runtime_error("Missing <delta> in " + parser.getFileName());
+
+    return compile(demands);
+}
+
+/**
+  Method that reads a service times specification (see readTimeWindows).
+  @param parser is the parser.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tServiceTimeSpec> SpecRegistry::readServiceTimes(XmlPullParser& parser)
+{
+    unsigned depth = parser.getDepth();
+    tServiceTime serviceTimes;
+    serviceTimes.distribution = noDistribution();
+    std::string_view section;
+    while (parser.next() && !(parser.isEndElement() && parser.getDepth() == depth))
+    {
+        if (!parser.isStartElement())
+            continue;
+
+        unsigned level = parser.getDepth() - depth;
+        if (level == 1)
+            section = parser.name();
+
+        if (level == 2 && section == "service-times" && parser.name() == "service-time")
+        {
+            tServiceTimeCostumer serviceTime;
+            serviceTime.type = getAttribute<double>(parser, "type");
+            serviceTime.probability = getAttribute<unsigned>(parser, "probability");
+            serviceTimes.serviceTimesCostumers.push_back(serviceTime);
+        }
+        else if (level == 1 && parser.name() == "distribution")
+            serviceTimes.distribution = readDistribution(parser);
+    }
+
+    return compile(serviceTimes);
+}
+
+/**
+  Method that compiles a time windows specification. The first category is
+  reserved, as it has always been done by the generator. The bounds of its
+  distributions are checked (widths cannot be negative).
+  @param timeWindows is the specification.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tTimeWindowSpec> SpecRegistry::compile(const tTimeWindow& timeWindows)
+{
+    std::shared_ptr<tTimeWindowSpec> spec(new tTimeWindowSpec);
+    spec->timeWindows = timeWindows;
+
+    if ((timeWindows.opensDistribution.type == NO_DISTRIBUTION) != (timeWindows.widthDistribution.type == NO_DISTRIBUTION))
+        throw std::runtime_error("Both opens-distribution and width-distribution must be specified");
+    checkDistribution(timeWindows.opensDistribution, "opens", false);
+    checkDistribution(timeWindows.widthDistribution, "width", true);
+    if (timeWindows.opensDistribution.type != NO_DISTRIBUTION)
+        return spec;
+
+    unsigned sum = sumOfProbabilities(timeWindows.timeWindowsCostumers, "time windows");
+
+    // - Segment for the creation of time windows
+    accProbabilityType& accProbability = spec->accProbability;
+    accProbability.resize(timeWindows.timeWindowsCostumers.size());
+    accProbability[0] = 0;
+    for (size_t i = 1; i < accProbability.size(); i++)
+       accProbability[i] = accProbability[i - 1] + (timeWindows.timeWindowsCostumers[i].probability / (double)sum);
+    accProbability.push_back(1);
+
+    return spec;
+}
+
+/**
+  Method that compiles a demands specification. The first category is
+  reserved, as it has always been done by the generator. The bounds of its
+  distribution are checked (demands cannot be negative).
+  @param demands is the specification.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tDemandSpec> SpecRegistry::compile(const tDemand& demands)
+{
+    std::shared_ptr<tDemandSpec> spec(new tDemandSpec);
+    spec->demands = demands;
+    checkDistribution(demands.distribution, "demand", true);
+    if (demands.distribution.type != NO_DISTRIBUTION)
+        return spec;
+
+    unsigned sum = sumOfProbabilities(demands.demandsCostumers, "demand");
+
+    // - Segment for the creation of demands
+    accProbabilityType& accProbability = spec->accProbability;
+    accProbability.resize(demands.demandsCostumers.size());
+    accProbability[0] = 0;
+    for (size_t i = 1; i < accProbability.size(); i++)
+       accProbability[i] = accProbability[i - 1] + (demands.demandsCostumers[i].probability / (double)sum);
+    accProbability.push_back(1);
+
+    return spec;
+}
+
+/**
+  Method that compiles a service times specification. The bounds of its
+  distribution are checked (service times cannot be negative).
+  @param serviceTimes is the specification.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tServiceTimeSpec> SpecRegistry::compile(const tServiceTime& serviceTimes)
+{
+    std::shared_ptr<tServiceTimeSpec> spec(new tServiceTimeSpec);
+    spec->serviceTimes = serviceTimes;
+    checkDistribution(serviceTimes.distribution, "service time", true);
+    if (serviceTimes.distribution.type != NO_DISTRIBUTION)
+        return spec;
+
+    unsigned sum = sumOfProbabilities(serviceTimes.serviceTimesCostumers, "service time");
+
+    // - Segment for the creation of service times.
+    accProbabilityType& accProbability = spec->accProbability;
+    accProbability.resize(serviceTimes.serviceTimesCostumers.size() + 1);
+    accProbability[0] = 0;
+    for (size_t i = 1; i < accProbability.size(); i++)
+       accProbability[i] = accProbability[i - 1] + (serviceTimes.serviceTimesCostumers[i - 1].probability / (double)sum);
+    accProbability.push_back(1);
+
+    return spec;
+}
+
+/**
+  Method that loads a time windows specification. If the name is already
+  registered, the file is not parsed again.
+  @param name is the name given to the specification.
+  @param fileName is the path to the file.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tTimeWindowSpec> SpecRegistry::loadTimeWindows(const std::string& name, const char* fileName)
+{
+   {
+      std::lock_guard<std::mutex> lock(this->registryMutex);
+      std::map<std::string, std::shared_ptr<const tTimeWindowSpec> >::const_iterator found = this->timeWindows.find(name);
+      if (found != this->timeWindows.end())
+         return found->second;
+   }
+
+   std::shared_ptr<const tTimeWindowSpec> spec = parseTimeWindows(fileName);
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   return this->timeWindows.insert(std::make_pair(name, spec)).first->second;
+}
+
+/**
+  Method that loads a demands specification. If the name is already
+  registered, the file is not parsed again.
+  @param name is the name given to the specification.
+  @param fileName is the path to the file.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tDemandSpec> SpecRegistry::loadDemands(const std::string& name, const char* fileName)
+{
+   {
+      std::lock_guard<std::mutex> lock(this->registryMutex);
+      std::map<std::string, std::shared_ptr<const tDemandSpec> >::const_iterator found = this->demands.find(name);
+      if (found != this->demands.end())
+         return found->second;
+   }
+
+   std::shared_ptr<const tDemandSpec> spec = parseDemands(fileName);
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   return this->demands.insert(std::make_pair(name, spec)).first->second;
+}
+
+/**
+  Method that loads a service times specification. If the name is already
+  registered, the file is not parsed again.
+  @param name is the name given to the specification.
+  @param fileName is the path to the file.
+  @return the compiled specification.
+*/
+std::shared_ptr<const tServiceTimeSpec> SpecRegistry::loadServiceTimes(const std::string& name, const char* fileName)
+{
+   {
+      std::lock_guard<std::mutex> lock(this->registryMutex);
+      std::map<std::string, std::shared_ptr<const tServiceTimeSpec> >::const_iterator found = this->serviceTimes.find(name);
+      if (found != this->serviceTimes.end())
+         return found->second;
+   }
+
+   std::shared_ptr<const tServiceTimeSpec> spec = parseServiceTimes(fileName);
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   return this->serviceTimes.insert(std::make_pair(name, spec)).first->second;
+}
+
+/**
+  Methods that register an already compiled specification (replacing any
+  other with the same name).
+  @param name is the name given to the specification.
+  @param spec is the compiled specification.
+*/
+void SpecRegistry::addTimeWindows(const std::string& name, std::shared_ptr<const tTimeWindowSpec> spec)
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   this->timeWindows[name] = spec;
+}
+
+void SpecRegistry::addDemands(const std::string& name, std::shared_ptr<const tDemandSpec> spec)
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   this->demands[name] = spec;
+}
+
+void SpecRegistry::addServiceTimes(const std::string& name, std::shared_ptr<const tServiceTimeSpec> spec)
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   this->serviceTimes[name] = spec;
+}
+
+/**
+  Methods that return a specification given its name. A name that has not
+  been registered may still be that of a standard preset.
+  @param name is the name of the specification.
+  @return the compiled specification (NULL if it has not been loaded nor is a preset).
+*/
+std::shared_ptr<const tTimeWindowSpec> SpecRegistry::getTimeWindows(const std::string& name) const
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   std::map<std::string, std::shared_ptr<const tTimeWindowSpec> >::const_iterator found = this->timeWindows.find(name);
+   return (found == this->timeWindows.end())? timeWindowsPreset(name) : found->second;
+}
+
+std::shared_ptr<const tDemandSpec> SpecRegistry::getDemands(const std::string& name) const
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   std::map<std::string, std::shared_ptr<const tDemandSpec> >::const_iterator found = this->demands.find(name);
+   return (found == this->demands.end())? demandsPreset(name) : found->second;
+}
+
+std::shared_ptr<const tServiceTimeSpec> SpecRegistry::getServiceTimes(const std::string& name) const
+{
+   std::lock_guard<std::mutex> lock(this->registryMutex);
+   std::map<std::string, std::shared_ptr<const tServiceTimeSpec> >::const_iterator found = this->serviceTimes.find(name);
+   return (found == this->serviceTimes.end())? serviceTimesPreset(name) : found->second;
+}
@@ -0,0 +1,96 @@
+#ifndef SPECREGISTRY_H
+#define SPECREGISTRY_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "dataTypes.h"
+
+class XmlPullParser;
+
+/**
+  Registry of specifications:
+     Each specification file is parsed once, as a stream of elements (see
+     XmlPullParser), and compiled (the cumulative probabilities used to
+     sample its categories are computed at that moment). Only the elements
+     at their place in the original format are read (e.g. <time-window>
+     within <time-windows>), others are ignored. Compiled specifications
+     are immutable and shared, so any number of generators can reference
+     them by name. The standard presets (see specpresets.h) are used only
+     when there is no file (nor registered specification) with their name.
+     Loading and looking up specifications is thread-safe.
+     Parsing errors are reported by throwing std::runtime_error.
+*/
+class SpecRegistry
+{
+   private:
+      //! Compiled specifications by name
+      std::map<std::string, std::shared_ptr<const tTimeWindowSpec> > timeWindows;
+      std::map<std::string, std::shared_ptr<const tDemandSpec> > demands;
+      std::map<std::string, std::shared_ptr<const tServiceTimeSpec> > serviceTimes;
+
+      //! Mutex that guards the maps
+      mutable std::mutex registryMutex;
+
+      //! Method that reads the value of an attribute of the current element
+      template <typename T>
+      static T getAttribute(const XmlPullParser&, const char*);
+
+      //! Method that reads a continuous distribution from the current element
+      static tDistribution readDistribution(const XmlPullParser&);
+
+      //! Method that opens a specification file and checks its root element
+      static void openSpecification(XmlPullParser&, const char*, const char*);
+
+   public:
+
+      //! Method that parses and compiles a time windows specification file
+      static std::shared_ptr<const tTimeWindowSpec> parseTimeWindows(const char* fileName);
+
+      //! Method that parses and compiles a demands specification file
+      static std::shared_ptr<const tDemandSpec> parseDemands(const char* fileName);
+
+      //! Method that parses and compiles a service times specification file
+      static std::shared_ptr<const tServiceTimeSpec> parseServiceTimes(const char* fileName);
+
+      //! Methods that read a specification from the current element of a parser (up to its end)
+      static std::shared_ptr<const tTimeWindowSpec> readTimeWindows(XmlPullParser& parser);
+      static std::shared_ptr<const tDemandSpec> readDemands(XmlPullParser& parser);
+      static std::shared_ptr<const tServiceTimeSpec> readServiceTimes(XmlPullParser& parser);
+
+      //! Method that compiles a time windows specification
+      static std::shared_ptr<const tTimeWindowSpec> compile(const tTimeWindow&);
+
+      //! Method that compiles a demands specification
+      static std::shared_ptr<const tDemandSpec> compile(const tDemand&);
+
+      //! Method that compiles a service times specification
+      static std::shared_ptr<const tServiceTimeSpec> compile(const tServiceTime&);
+
+      //! Method that loads a time windows specification under a name (only the first time)
+      /*!
+        \param name is the name given to the specification.
+        \param fileName is the name of the file containing the specification.
+      */
+      std::shared_ptr<const tTimeWindowSpec> loadTimeWindows(const std::string& name, const char* fileName);
+
+      //! Method that loads a demands specification under a name (only the first time)
+      std::shared_ptr<const tDemandSpec> loadDemands(const std::string& name, const char* fileName);
+
+      //! Method that loads a service times specification under a name (only the first time)
+      std::shared_ptr<const tServiceTimeSpec> loadServiceTimes(const std::string& name, const char* fileName);
+
+      //! Methods that register an already compiled specification under a name
+      void addTimeWindows(const std::string& name, std::shared_ptr<const tTimeWindowSpec>);
+      void addDemands(const std::string& name, std::shared_ptr<const tDemandSpec>);
+      void addServiceTimes(const std::string& name, std::shared_ptr<const tServiceTimeSpec>);
+
+      //! Methods that return a specification given its name (NULL if it has not been loaded nor is a preset)
+      std::shared_ptr<const tTimeWindowSpec> getTimeWindows(const std::string& name) const;
+      std::shared_ptr<const tDemandSpec> getDemands(const std::string& name) const;
+      std::shared_ptr<const tServiceTimeSpec> getServiceTimes(const std::string& name) const;
+};
+
+#endif // SPECREGISTRY_H
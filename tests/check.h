@@ -0,0 +1,36 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+/**
+  Minimal checks of the tests:
+     Each test is a program whose checks report the failed conditions
+     (file and line) and whose exit status is the number of failures, so
+     tests/run.sh can tell which ones fail.
+   \code
+      CHECK(writer.isAvailable(TextWriter::NO_COMPRESSION));
+      return checkFailures();
+   \endcode
+*/
+
+//! Number of failed checks
+inline int& checkFailures()
+{
+   static int failures = 0;
+   return failures;
+}
+
+//! Checks a condition, reporting it if it does not hold
+#define CHECK(condition) \
+   do \
+   { \
+      if (!(condition)) \
+      { \
+         std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+         checkFailures()++; \
+      } \
+   } \
+   while (false)
+
+#endif // CHECK_H
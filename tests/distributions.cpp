@@ -0,0 +1,122 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "../distributions.h"
+#include "../specregistry.h"
+#include "check.h"
+
+namespace
+{
+   /**
+     Function that parses a demands specification with a distribution.
+     @param distribution is the <distribution> element.
+     @return the error parsing it (empty if none).
+   */
+   std::string parseDemands(const std::string& distribution)
+   {
+      {
+         std::ofstream file("demands.xml");
+         file << "<demands-specifications><delta value=\"60\"/>" << distribution << "</demands-specifications>\n";
+      }
+
+      try
+      {
+         SpecRegistry::parseDemands("demands.xml");
+      }
+      catch (const std::runtime_error& exception)
+      {
+         return exception.what();
+      }
+      return "";
+   }
+}
+
+int main()
+{
+   // Valid distributions
+   CHECK(parseDemands("<distribution type=\"uniform\" min=\"10\" max=\"30\"/>").empty());
+   CHECK(parseDemands("<distribution type=\"normal\" mean=\"20\" stddev=\"5\"/>").empty());
+   CHECK(parseDemands("<distribution type=\"lognormal\" mu=\"2.9\" sigma=\"0.4\" max=\"100\"/>").empty());
+
+   // Demands cannot be negative, and min cannot be greater than max
+   CHECK(parseDemands("<distribution type=\"uniform\" min=\"-5\" max=\"10\"/>") == "The min of the demand distribution is negative");
+   CHECK(parseDemands("<distribution type=\"normal\" mean=\"20\" stddev=\"5\" min=\"-1\"/>") == "The min of the demand distribution is negative");
+   CHECK(parseDemands("<distribution type=\"uniform\" min=\"30\" max=\"10\"/>") == "The min of the demand distribution is greater than its max");
+   CHECK(parseDemands("<distribution type=\"normal\" mean=\"20\" stddev=\"5\" min=\"10\" max=\"5\"/>") == "The min of the demand distribution is greater than its max");
+   CHECK(parseDemands("<distribution type=\"lognormal\" mu=\"2\" sigma=\"-1\"/>") == "The deviation of the demand distribution is negative");
+
+   // Service times and widths of time windows cannot be negative either, the opening times can
+   tServiceTime serviceTimes;
+   serviceTimes.distribution = noDistribution();
+   serviceTimes.distribution.type = UNIFORM_DISTRIBUTION;
+   serviceTimes.distribution.first = serviceTimes.distribution.min = -1;
+   serviceTimes.distribution.second = serviceTimes.distribution.max = 10;
+   bool rejected = false;
+   try
+   {
+      SpecRegistry::compile(serviceTimes);
+   }
+   catch (const std::runtime_error&)
+   {
+      rejected = true;
+   }
+   CHECK(rejected);
+
+   tTimeWindow timeWindows;
+   timeWindows.timeWindowDepot.opens = 0;
+   timeWindows.timeWindowDepot.closes = 100;
+   timeWindows.opensDistribution = serviceTimes.distribution;
+   timeWindows.widthDistribution = noDistribution();
+   timeWindows.widthDistribution.type = NORMAL_DISTRIBUTION;
+   timeWindows.widthDistribution.first = 20;
+   timeWindows.widthDistribution.second = 5;
+   CHECK(SpecRegistry::compile(timeWindows) != NULL);
+   timeWindows.widthDistribution.min = -1;
+   rejected = false;
+   try
+   {
+      SpecRegistry::compile(timeWindows);
+   }
+   catch (const std::runtime_error&)
+   {
+      rejected = true;
+   }
+   CHECK(rejected);
+
+   remove("demands.xml");
+   return checkFailures();
+}
@@ -0,0 +1,159 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../batchpipeline.h"
+#include "../journal.h"
+#include "../scenariofile.h"
+#include "../specregistry.h"
+#include "check.h"
+#include "testnetwork.h"
+
+namespace
+{
+   //! Reads a whole file (empty if it does not exist)
+   std::string readFile(const std::string& fileName)
+   {
+      std::ifstream file(fileName.c_str(), std::ios::binary);
+      std::ostringstream contents;
+      contents << file.rdbuf();
+      return contents.str();
+   }
+
+   //! Writes a whole file
+   void writeFile(const std::string& fileName, const std::string& contents)
+   {
+      std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+      file << contents;
+   }
+
+   /**
+     Function that runs a batch to disk with a journal.
+     @param network is the network of the instances.
+     @param scenarios is the list of scenarios.
+     @param verify is true to verify the checksums of the files recorded.
+     @return the number of records of the journal before the batch.
+   */
+   size_t runBatch(std::shared_ptr<const Network> network, const std::vector<tScenario>& scenarios, bool verify)
+   {
+      Journal journal;
+      journal.open("batch.journal");
+      size_t records = journal.getRecords().size();
+      BatchPipeline pipeline(network);
+      pipeline.setJournal(&journal, verify);
+      pipeline.run(scenarios, NULL);
+      journal.close();
+      return records;
+   }
+
+   //! Returns a record of a test instance
+   Journal::tRecord record(const std::string& instance)
+   {
+      Journal::tRecord record;
+      record.instance = instance;
+      Journal::tFile file = { instance + "Specs.dat", 1234, 0x0123456789abcdefull, 0 };
+      record.files.push_back(file);
+      return record;
+   }
+}
+
+int main()
+{
+   // Records written are read back; a torn last line is discarded, and so is everything after a corrupted line
+   {
+      Journal journal;
+      journal.open("records.journal");
+      journal.append(record("first"));
+      journal.append(record("second"));
+      journal.close();
+   }
+   std::string lines = readFile("records.journal");
+   writeFile("records.journal", lines + "instance\tthird\t1\tthirdSpe");
+   {
+      Journal journal;
+      journal.open("records.journal");
+      CHECK(journal.getRecords().size() == 2);
+      CHECK(journal.getRecords().size() == 2 && journal.getRecords()[1].instance == "second");
+      CHECK(journal.getRecords().size() == 2 && journal.getRecords()[1].files.size() == 1 &&
+            journal.getRecords()[1].files[0].size == 1234 && journal.getRecords()[1].files[0].checksum == 0x0123456789abcdefull);
+   }
+   lines[lines.find("first")] = 'F';
+   writeFile("records.journal", lines);
+   {
+      Journal journal;
+      journal.open("records.journal");
+      CHECK(journal.getRecords().empty());
+   }
+
+   // Batch resumed: only the instances whose files are missing (or, if verified, changed) are written again
+   std::shared_ptr<const Network> network = writeTestNetwork(30);
+   std::vector<tScenario> scenarios;
+   for (unsigned i = 0; i < 4; i++)
+   {
+      tScenario scenario = ScenarioFile::defaultScenario();
+      scenario.name = scenario.prefix = "instance" + std::to_string(i);
+      scenario.size = 8;
+      scenario.matrixSeed = i + 1;
+      scenario.timeWindows = SpecRegistry::parseTimeWindows("tw1-equal");
+      scenario.demands = SpecRegistry::parseDemands("d0-equal");
+      scenario.serviceTimes = SpecRegistry::parseServiceTimes("st0-equal");
+      scenarios.push_back(scenario);
+   }
+
+   CHECK(runBatch(network, scenarios, false) == 0);
+   const char* suffixes[] = { "DistanceMatrix.dat", "TimeMatrix.dat", "Specs.dat" };
+   std::map<std::string, std::string> written;
+   for (size_t i = 0; i < scenarios.size(); i++)
+      for (const char* suffix : suffixes)
+         written[scenarios[i].prefix + suffix] = readFile(scenarios[i].prefix + suffix);
+
+   // Each run records the instances it writes
+   std::string changed(written["instance0DistanceMatrix.dat"].size(), 'x');
+   writeFile("instance0DistanceMatrix.dat", changed);
+   remove("instance2Specs.dat");
+   CHECK(runBatch(network, scenarios, false) == 4);
+   CHECK(readFile("instance2Specs.dat") == written["instance2Specs.dat"]);
+   CHECK(readFile("instance0DistanceMatrix.dat") == changed);
+
+   CHECK(runBatch(network, scenarios, true) == 5);
+   CHECK(runBatch(network, scenarios, true) == 6);
+   for (std::map<std::string, std::string>::const_iterator file = written.begin(); file != written.end(); file++)
+      CHECK(readFile(file->first) == file->second);
+
+   return checkFailures();
+}
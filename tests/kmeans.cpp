@@ -0,0 +1,104 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../MersenneTwister.h"
+#include "../kmeans.h"
+#include "check.h"
+#include "testnetwork.h"
+
+int main()
+{
+   // Four groups of positions far apart from each other (several chunks of the assignment step)
+   const double centres[4][2] = { { 28.0, -16.0 }, { 28.0, -15.0 }, { 29.0, -16.0 }, { 29.0, -15.0 } };
+   costumersPosType positions;
+   MTRand random(3);
+   for (unsigned i = 0; i < 20000; i++)
+   {
+      tPos position;
+      position.id = i;
+      position.lat = centres[i % 4][0] + 0.05 * random.rand();
+      position.lng = centres[i % 4][1] + 0.05 * random.rand();
+      positions.push_back(position);
+   }
+
+   // Each group is a cluster
+   KMeans kmeans(4, 5);
+   kmeans.setThreads(1);
+   kmeans.run(positions);
+   const std::vector<unsigned>& assignment = kmeans.getAssignment();
+   CHECK(kmeans.getK() == 4);
+   CHECK(assignment.size() == positions.size());
+   std::set<unsigned> clusters;
+   for (size_t i = 0; i < assignment.size() && i < positions.size(); i++)
+   {
+      CHECK(assignment[i] == assignment[i % 4]);
+      clusters.insert(assignment[i]);
+   }
+   CHECK(clusters.size() == 4);
+
+   // The result only depends on the seed, not on the number of threads nor on previous runs
+   const unsigned threads[] = { 2, 3, 7 };
+   for (unsigned t : threads)
+   {
+      KMeans other(12, 7);
+      other.setThreads(t);
+      other.run(positions);
+      other.run(positions);
+
+      KMeans reference(12, 7);
+      reference.setThreads(1);
+      reference.run(positions);
+      CHECK(other.getAssignment() == reference.getAssignment());
+   }
+
+   // The clusters of a network are computed once for each k, even when several threads ask for them at once
+   std::shared_ptr<const Network> network = writeTestNetwork(60);
+   std::vector<std::shared_ptr<const std::vector<idsType> > > clusterings(8);
+   std::vector<std::thread> workers;
+   for (size_t i = 0; i < clusterings.size(); i++)
+      workers.push_back(std::thread([&network, &clusterings, i]() { clusterings[i] = network->getClusters(3 + i % 2, 2); }));
+   for (std::thread& worker : workers)
+      worker.join();
+   for (size_t i = 0; i < clusterings.size(); i++)
+   {
+      CHECK(clusterings[i]->size() == 3 + i % 2);
+      CHECK(clusterings[i] == clusterings[i % 2]);
+   }
+   CHECK(network->getClusters(3, 1) == clusterings[0]);
+
+   return checkFailures();
+}
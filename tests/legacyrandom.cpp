@@ -0,0 +1,103 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "../scenariofile.h"
+#include "../vrptwinstancegenerator.h"
+#include "check.h"
+#include "testnetwork.h"
+
+namespace
+{
+   /**
+     Function that returns the costumers drawn in Random mode as they have
+     always been drawn: the indexes of all the nodes shuffled with
+     std::random_shuffle after srand(seed), the first ones after the depot.
+     @param nodes is the number of nodes of the network.
+     @param size is the number of costumers.
+     @param seed is the seed of the matrices.
+     @return the depot (0) followed by the indexes of the costumers.
+   */
+   std::vector<unsigned> shuffledCostumers(unsigned nodes, unsigned size, unsigned seed)
+   {
+      std::vector<unsigned> indexes(nodes);
+      for (unsigned i = 0; i < nodes; i++)
+         indexes[i] = i;
+
+      srand(seed);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+      std::random_shuffle(indexes.begin(), indexes.end());
+#pragma GCC diagnostic pop
+
+      std::vector<unsigned> costumers(1, 0);
+      costumers.insert(costumers.end(), indexes.begin(), indexes.begin() + size);
+      return costumers;
+   }
+
+   //! Returns the costumers the generator draws in Random mode
+   std::vector<unsigned> generatedCostumers(VRPTWInstanceGenerator& generator, unsigned size, unsigned seed)
+   {
+      tScenario scenario = ScenarioFile::defaultScenario();
+      scenario.size = size;
+      scenario.matrixSeed = seed;
+      generator.setScenario(scenario);
+      generator.reset();
+      generator.generateMatrices();
+      return generator.getInstance().randomIds;
+   }
+}
+
+int main()
+{
+   const unsigned nodes = 40;
+   VRPTWInstanceGenerator generator(writeTestNetwork(nodes));
+
+   // Same costumers as std::random_shuffle with rand(), whatever was generated before
+   const unsigned seeds[] = { 0, 1, 2, 7, 12345, 4294967295u };
+   const unsigned sizes[] = { 1, 10, nodes - 1 };
+   for (unsigned seed : seeds)
+      for (unsigned size : sizes)
+         CHECK(generatedCostumers(generator, size, seed) == shuffledCostumers(nodes, size, seed));
+
+   // The state of rand() is left alone
+   srand(99);
+   int expected = rand();
+   srand(99);
+   generatedCostumers(generator, 10, 3);
+   CHECK(rand() == expected);
+
+   return checkFailures();
+}
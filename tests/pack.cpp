@@ -0,0 +1,226 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../packfile.h"
+#include "../packwriter.h"
+#include "check.h"
+
+namespace
+{
+   //! Returns the content of a test entry (of any length, not a multiple of the alignment)
+   std::string content(unsigned i)
+   {
+      std::string text;
+      for (unsigned j = 0; j <= i * 37; j++)
+         text += char('a' + (i + j) % 26);
+      return text;
+   }
+
+   //! Returns the name of a test entry
+   std::string name(unsigned i)
+   {
+      return "test" + std::to_string(i) + "Specs.dat";
+   }
+
+   //! Returns true if a pack has an entry with a given name and content (and a valid checksum)
+   bool hasEntry(const PackReader& pack, const std::string& name, const std::string& content)
+   {
+      const PackReader::tEntry* entry = pack.find(name);
+      return entry != NULL && std::string(entry->data, entry->size) == content && PackReader::verify(*entry);
+   }
+}
+
+int main()
+{
+   // Entries written, one of them linked to the data of another
+   {
+      PackWriter pack;
+      pack.open("test.pack");
+      for (unsigned i = 0; i < 10; i++)
+         CHECK(pack.append(name(i), content(i).data(), content(i).size()) == i);
+      pack.link("copy.dat", 3);
+      CHECK(pack.size() == 11);
+      CHECK(pack.entry(10).offset == pack.entry(3).offset);
+      pack.close();
+   }
+   {
+      PackReader pack("test.pack");
+      CHECK(pack.size() == 11);
+      for (unsigned i = 0; i < 10; i++)
+      {
+         CHECK(pack.entry(i).name == name(i));
+         CHECK(hasEntry(pack, name(i), content(i)));
+         CHECK((pack.entry(i).data - pack.entry(0).data) % 64 == 0);
+      }
+      CHECK(hasEntry(pack, "copy.dat", content(3)));
+      CHECK(pack.find("missing.dat") == NULL);
+   }
+
+   // A pack opened again is extended, and the last entry added with a name is the one found
+   {
+      PackWriter pack;
+      pack.open("test.pack");
+      CHECK(pack.size() == 11);
+      pack.append(name(2), content(20).data(), content(20).size());
+      pack.append("empty.dat", "", 0);
+      pack.close();
+   }
+   {
+      PackReader pack("test.pack");
+      CHECK(pack.size() == 13);
+      CHECK(hasEntry(pack, name(1), content(1)));
+      CHECK(hasEntry(pack, name(2), content(20)));
+      CHECK(hasEntry(pack, "empty.dat", ""));
+   }
+
+   // A pack left open after adding entries (data after its trailer, here with the magic of a trailer in it) is read
+   // with its last valid index, and it is extended from there
+   {
+      FILE* file = fopen("test.pack", "ab");
+      std::string garbage = content(30) + "MVRPTWIX" + content(31);
+      fwrite(garbage.data(), 1, garbage.size(), file);
+      fclose(file);
+   }
+   {
+      PackReader pack("test.pack");
+      CHECK(pack.size() == 13);
+      CHECK(hasEntry(pack, name(2), content(20)));
+   }
+   {
+      PackWriter pack;
+      pack.open("test.pack");
+      CHECK(pack.size() == 13);
+      pack.append(name(4), content(40).data(), content(40).size());
+      pack.close();
+   }
+   {
+      PackReader pack("test.pack");
+      CHECK(pack.size() == 14);
+      CHECK(hasEntry(pack, name(4), content(40)));
+      CHECK(hasEntry(pack, name(2), content(20)));
+   }
+
+   // A truncated pack falls back to its previous index, and it is rejected if it has none
+   {
+      FILE* file = fopen("test.pack", "r+b");
+      fseek(file, 0, SEEK_END);
+      long size = ftell(file);
+      fclose(file);
+      CHECK(truncate("test.pack", size - 1) == 0);
+      {
+         PackReader pack("test.pack");
+         CHECK(pack.size() == 13);
+         CHECK(hasEntry(pack, name(4), content(4)));
+      }
+
+      CHECK(truncate("test.pack", sizeof(tPackHeader) + 100) == 0);
+      bool rejected = false;
+      try
+      {
+         PackReader pack("test.pack");
+      }
+      catch (const std::runtime_error&)
+      {
+         rejected = true;
+      }
+      CHECK(rejected);
+
+      // Its entries are lost, but entries can be added to it
+      PackWriter writer;
+      writer.open("test.pack");
+      CHECK(writer.size() == 0);
+      writer.append(name(5), content(5).data(), content(5).size());
+      writer.close();
+      PackReader pack("test.pack");
+      CHECK(pack.size() == 1);
+      CHECK(hasEntry(pack, name(5), content(5)));
+   }
+
+   // Packs of shards merged: every entry is kept, and data shared between them is stored once
+   {
+      PackWriter first, second;
+      first.open("first.pack");
+      second.open("second.pack");
+      for (unsigned i = 0; i < 10; i++)
+      {
+         PackWriter& shard = (i % 2 == 0) ? first : second;
+         shard.append(name(i), content(i).data(), content(i).size());
+         shard.append("matrix" + std::to_string(i) + ".dat", content(50).data(), content(50).size());
+      }
+      first.close();
+      second.close();
+
+      PackWriter merged;
+      merged.open("merged.pack");
+      CHECK(merged.merge("first.pack") == 10);
+      CHECK(merged.merge("second.pack") == 10);
+      CHECK(merged.equals(1, content(50).data(), content(50).size()));
+      CHECK(!merged.equals(0, content(50).data(), content(50).size()));
+      uint64_t bytes = merged.bytes();
+      merged.close();
+
+      PackReader pack("merged.pack");
+      CHECK(pack.size() == 20);
+      for (unsigned i = 0; i < 10; i++)
+      {
+         CHECK(hasEntry(pack, name(i), content(i)));
+         CHECK(hasEntry(pack, "matrix" + std::to_string(i) + ".dat", content(50)));
+         CHECK(pack.find("matrix" + std::to_string(i) + ".dat")->data == pack.find("matrix0.dat")->data);
+      }
+      CHECK(bytes < 2 * content(50).size() + 10 * (content(9).size() + 64));
+
+      // A pack that cannot be read is not merged
+      bool rejected = false;
+      try
+      {
+         PackWriter other;
+         other.open("other.pack");
+         other.merge("missing.pack");
+      }
+      catch (const std::runtime_error&)
+      {
+         rejected = true;
+      }
+      CHECK(rejected);
+   }
+
+   remove("test.pack");
+   remove("first.pack");
+   remove("second.pack");
+   remove("merged.pack");
+   remove("other.pack");
+   return checkFailures();
+}
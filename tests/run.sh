@@ -0,0 +1,27 @@
+#!/bin/sh
+# Builds each test (tests/*.cpp) with the sources of the generator but its
+# main and runs it. Extra flags go in CXXFLAGS and LIBS, e.g. to exercise
+# the compressed output:
+#    CXXFLAGS="-DMOVRPTW_WITH_ZLIB -DMOVRPTW_WITH_ZSTD" LIBS="-lz -lzstd" tests/run.sh
+cd "$(dirname "$0")/.." || exit 1
+CXX=${CXX:-g++}
+build=${TMPDIR:-/tmp}/movrptw-tests
+mkdir -p "$build" || exit 1
+
+sources=$(ls *.cpp tinyxml/*.cpp | grep -v '^main\.cpp$')
+failed=0
+for test in tests/*.cpp; do
+   name=$(basename "$test" .cpp)
+   if ! $CXX -std=c++17 -O2 -pthread -I. $CXXFLAGS "$test" $sources -o "$build/$name" $LIBS; then
+      echo "BUILD FAILED $name"; failed=$((failed + 1)); continue
+   fi
+   # Each test runs in an empty directory; what it writes to its standard
+   # output (e.g. the messages of the generator) goes to its log
+   rm -rf "$build/$name.run" && mkdir "$build/$name.run" || exit 1
+   if (cd "$build/$name.run" && "../$name" > "../$name.log"); then
+      echo "ok $name"
+   else
+      echo "FAILED $name"; failed=$((failed + 1))
+   fi
+done
+exit $failed
@@ -0,0 +1,116 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../scenariofile.h"
+#include "../specregistry.h"
+#include "check.h"
+
+namespace
+{
+   /**
+     Function that reads a sweep from a scenario file.
+     @param attributes are the attributes of the <sweep> (other than its name).
+     @param sections are the elements it contains.
+     @param scenarios is where its instances are stored.
+     @return the error reading it (empty if none).
+   */
+   std::string readSweep(const std::string& attributes, const std::string& sections, std::vector<tScenario>& scenarios)
+   {
+      {
+         std::ofstream file("sweep.xml");
+         file << "<sweep name=\"t\" " << attributes << ">\n" << sections << "</sweep>\n";
+      }
+
+      scenarios.clear();
+      SpecRegistry registry;
+      try
+      {
+         ScenarioFile::read("sweep.xml", registry, scenarios);
+      }
+      catch (const std::runtime_error& exception)
+      {
+         return exception.what();
+      }
+      return "";
+   }
+
+   const std::string specifications = "<service-times-specifications ref=\"st0-equal\"/>\n"
+                                      "<demands-specifications ref=\"d0-equal\"/>\n"
+                                      "<demands-specifications ref=\"d1-equal\"/>\n"
+                                      "<time-windows-specification ref=\"tw0-equal\"/>\n";
+}
+
+int main()
+{
+   // Cartesian product of the lists, named and prefixed as the dataset, each sample consecutive
+   std::vector<tScenario> scenarios;
+   CHECK(readSweep("sizes=\"50 150\" matrices=\"0..2\" time-windows=\"4,5\"",
+                   "<output prefix=\"out/\"/>\n" + specifications, scenarios).empty());
+   CHECK(scenarios.size() == 2 * 3 * 2 * 2);
+   if (scenarios.size() == 24)
+   {
+      CHECK(scenarios[0].name == "t50-0-4-0-0.d0-equal.tw0-equal");
+      CHECK(scenarios[0].prefix == "out/t50-0-4-0-0.d0-equal.tw0-equal");
+      CHECK(scenarios[1].name == "t50-0-4-0-0.d1-equal.tw0-equal");
+      CHECK(scenarios[2].name == "t50-0-5-0-0.d0-equal.tw0-equal");
+      CHECK(scenarios[23].name == "t150-2-5-0-0.d1-equal.tw0-equal");
+      CHECK(scenarios[23].size == 150 && scenarios[23].matrixSeed == 2 && scenarios[23].timeWindowSeed == 5);
+      for (size_t i = 0; i < scenarios.size(); i++)
+      {
+         CHECK(scenarios[i].size == (i < 12 ? 50u : 150u));
+         CHECK(scenarios[i].matrixSeed == (i / 4) % 3);
+         CHECK(scenarios[i].timeWindows && scenarios[i].demands && scenarios[i].serviceTimes);
+      }
+   }
+
+   // Names must be unique
+   CHECK(readSweep("sizes=\"50,50\"", specifications, scenarios).find("repeated value 50") != std::string::npos);
+   CHECK(readSweep("sizes=\"50\" matrices=\"0..3 2..5\"", specifications, scenarios).find("repeated value 2") != std::string::npos);
+   CHECK(readSweep("sizes=\"50\"", specifications + "<demands-specifications ref=\"d0-equal\"/>\n", scenarios).find("Repeated specification 'd0-equal'") != std::string::npos);
+
+   // Grids too large are rejected before they are expanded
+   CHECK(readSweep("sizes=\"50\" matrices=\"0..4294967295\"", specifications, scenarios).find("more than") != std::string::npos);
+   CHECK(readSweep("sizes=\"50\" matrices=\"0..999\" time-windows=\"0..999\"", specifications, scenarios).find("More than") != std::string::npos);
+   CHECK(readSweep("sizes=\"50\" matrices=\"0..999\" time-windows=\"0..249\"", specifications, scenarios).empty());
+   CHECK(scenarios.size() == 500000);
+
+   // Other errors
+   CHECK(readSweep("matrices=\"0\"", specifications, scenarios).find("Missing sizes") != std::string::npos);
+   CHECK(readSweep("sizes=\"50\" matrices=\"3..1\"", specifications, scenarios).find("empty range") != std::string::npos);
+
+   return checkFailures();
+}
@@ -0,0 +1,51 @@
+#ifndef TESTNETWORK_H
+#define TESTNETWORK_H
+
+#include <cstdio>
+#include <memory>
+
+#include "../network.h"
+
+/**
+  Small network for the tests:
+     The nodes lie on a grid around the depot (real ids 1000 + i, the
+     depot first), with the distance and the time between every pair.
+     Its files are written to the current directory with the names the
+     generator reads (rawDistance.txt, rawTime.txt, idRid.txt and
+     idLatLng.dat) and read back.
+   \code
+      std::shared_ptr<const Network> network = writeTestNetwork(40);
+   \endcode
+*/
+inline std::shared_ptr<const Network> writeTestNetwork(unsigned nodes)
+{
+   FILE* distances = fopen("rawDistance.txt", "w");
+   FILE* times = fopen("rawTime.txt", "w");
+   FILE* ids = fopen("idRid.txt", "w");
+   FILE* positions = fopen("idLatLng.dat", "w");
+   for (unsigned i = 0; i < nodes; i++)
+   {
+      fprintf(ids, "%u %u\n", i, 1000 + i);
+      fprintf(positions, "%u %.6f %.6f\n", 1000 + i, 28.0 + 0.01 * (i % 7), -16.0 - 0.01 * (i / 7));
+      for (unsigned j = 0; j < nodes; j++)
+         if (i != j)
+         {
+            unsigned length = (i > j ? i - j : j - i) * 3 + (i + j) % 5;
+            fprintf(distances, "%u %u %u.5\n", 1000 + i, 1000 + j, length);
+            fprintf(times, "%u %u %u.25\n", 1000 + i, 1000 + j, length * 60);
+         }
+   }
+   fclose(distances);
+   fclose(times);
+   fclose(ids);
+   fclose(positions);
+
+   std::shared_ptr<Network> network(new Network());
+   network->readDistances("rawDistance.txt");
+   network->readTimes("rawTime.txt");
+   network->readIds("idRid.txt");
+   network->readPositions("idLatLng.dat");
+   return network;
+}
+
+#endif // TESTNETWORK_H
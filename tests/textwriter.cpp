@@ -0,0 +1,169 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifdef MOVRPTW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MOVRPTW_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "../textwriter.h"
+#include "check.h"
+
+namespace
+{
+   /**
+     Function that writes the same text to a writer (numbers in every
+     format and raw bytes), longer than its buffer so several buffers go
+     through the compression stage.
+     @param writer is the writer, already open.
+   */
+   void writeText(TextWriter& writer)
+   {
+      for (unsigned i = 0; i < 20000; i++)
+      {
+         writer.setFormat(TextWriter::tFormat(i % 3), 1 + i % 8);
+         writer << i << '\t' << (i / 7.0) << '\t' << -1.0 / (i + 1) << '\n';
+      }
+      writer.write("end\n", 4);
+   }
+
+   //! Reads a whole file
+   std::string readFile(const std::string& fileName)
+   {
+      std::string contents;
+      FILE* file = fopen(fileName.c_str(), "rb");
+      if (!file)
+         return contents;
+      char buffer[1 << 16];
+      size_t length;
+      while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+         contents.append(buffer, length);
+      fclose(file);
+      return contents;
+   }
+
+#ifdef MOVRPTW_WITH_ZLIB
+   //! Decompresses a gzip file
+   std::string gunzip(const std::string& fileName)
+   {
+      std::string contents;
+      gzFile file = gzopen(fileName.c_str(), "rb");
+      if (!file)
+         return contents;
+      char buffer[1 << 16];
+      int length;
+      while ((length = gzread(file, buffer, sizeof(buffer))) > 0)
+         contents.append(buffer, length);
+      gzclose(file);
+      return contents;
+   }
+#endif
+
+#ifdef MOVRPTW_WITH_ZSTD
+   //! Decompresses a zstd file (a stream, its size is not in the frame)
+   std::string unzstd(const std::string& fileName)
+   {
+      std::string compressed = readFile(fileName), contents;
+      ZSTD_DCtx* context = ZSTD_createDCtx();
+      ZSTD_inBuffer input = { compressed.data(), compressed.size(), 0 };
+      std::vector<char> buffer(ZSTD_DStreamOutSize());
+      size_t result = 1;
+      while (input.pos < input.size && !ZSTD_isError(result))
+      {
+         ZSTD_outBuffer output = { buffer.data(), buffer.size(), 0 };
+         result = ZSTD_decompressStream(context, &output, &input);
+         contents.append(buffer.data(), output.pos);
+      }
+      ZSTD_freeDCtx(context);
+      CHECK(result == 0);
+      return contents;
+   }
+#endif
+
+   /**
+     Function that writes a file with a kind of compression and checks
+     that it reads back to what was written to a string.
+     @param compression is the kind of compression.
+     @param expected is the text written to a string.
+   */
+   void checkRoundTrip(TextWriter::tCompression compression, const std::string& expected)
+   {
+      std::string fileName = std::string("textwriter") + TextWriter::extension(compression);
+      TextWriter writer(4096);
+      writer.setCompression(compression);
+      writer.open(fileName);
+      writeText(writer);
+      writer.close();
+
+      std::string contents;
+      if (compression == TextWriter::NO_COMPRESSION)
+         contents = readFile(fileName);
+#ifdef MOVRPTW_WITH_ZLIB
+      if (compression == TextWriter::GZIP_COMPRESSION)
+         contents = gunzip(fileName);
+#endif
+#ifdef MOVRPTW_WITH_ZSTD
+      if (compression == TextWriter::ZSTD_COMPRESSION)
+         contents = unzstd(fileName);
+#endif
+      CHECK(contents == expected);
+      remove(fileName.c_str());
+   }
+}
+
+int main()
+{
+   std::string expected;
+   TextWriter writer(4096);
+   writer.openString(expected);
+   writeText(writer);
+   writer.close();
+   CHECK(expected.size() > 100000);
+   CHECK(expected.compare(expected.size() - 4, 4, "end\n") == 0);
+
+   const TextWriter::tCompression compressions[] = { TextWriter::NO_COMPRESSION, TextWriter::GZIP_COMPRESSION, TextWriter::ZSTD_COMPRESSION };
+   for (TextWriter::tCompression compression : compressions)
+      if (TextWriter::isAvailable(compression))
+      {
+         checkRoundTrip(compression, expected);
+         std::cout << "Round trip of " << (compression == TextWriter::NO_COMPRESSION ? "plain" : TextWriter::extension(compression)) << " files" << std::endl;
+      }
+
+   return checkFailures();
+}
@@ -0,0 +1,526 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef MOVRPTW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef MOVRPTW_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#include "textwriter.h"
+
+namespace
+{
+   /**
+     Streaming compressor: each call compresses a piece of the file and
+     appends the compressed bytes to a vector.
+   */
+   class Compressor
+   {
+      public:
+         virtual ~Compressor() {}
+
+         //! Compresses a piece of data (the last one if finish is true)
+         virtual void compress(const char* data, size_t length, bool finish, std::vector<char>& output) = 0;
+   };
+
+#ifdef MOVRPTW_WITH_ZLIB
+   //! Compressor of gzip files (zlib)
+   class GzipCompressor : public Compressor
+   {
+      private:
+         z_stream stream;
+
+      public:
+         GzipCompressor()
+         {
+            memset(&this->stream, 0, sizeof(this->stream));
+            // 15 bits of window + 16: gzip header and trailer
+            if (deflateInit2(&this->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+               throw std::runtime_error("Unable to initialise zlib");
+         }
+
+         ~GzipCompressor()
+         {
+            deflateEnd(&this->stream);
+         }
+
+         void compress(const char* data, size_t length, bool finish, std::vector<char>& output)
+         {
+            this->stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            this->stream.avail_in = length;
+            int result;
+            do
+            {
+               size_t previous = output.size();
+               output.resize(previous + deflateBound(&this->stream, this->stream.avail_in) + 64);
+               this->stream.next_out = reinterpret_cast<Bytef*>(output.data() + previous);
+               this->stream.avail_out = output.size() - previous;
+               result = deflate(&this->stream, finish ? Z_FINISH : Z_NO_FLUSH);
+               if (result == Z_STREAM_ERROR)
+                  throw std::runtime_error("zlib compression failed");
+               output.resize(output.size() - this->stream.avail_out);
+            }
+            while (this->stream.avail_in > 0 || (finish && result != Z_STREAM_END));
+         }
+   };
+#endif
+
+#ifdef MOVRPTW_WITH_ZSTD
+   //! Compressor of zstd files
+   class ZstdCompressor : public Compressor
+   {
+      private:
+         ZSTD_CCtx* context;
+
+      public:
+         ZstdCompressor()
+         {
+            this->context = ZSTD_createCCtx();
+            if (!this->context)
+               throw std::runtime_error("Unable to initialise zstd");
+         }
+
+         ~ZstdCompressor()
+         {
+            ZSTD_freeCCtx(this->context);
+         }
+
+         void compress(const char* data, size_t length, bool finish, std::vector<char>& output)
+         {
+            ZSTD_inBuffer input = { data, length, 0 };
+            size_t remaining;
+            do
+            {
+               size_t previous = output.size();
+               output.resize(previous + ZSTD_CStreamOutSize());
+               ZSTD_outBuffer out = { output.data() + previous, output.size() - previous, 0 };
+               remaining = ZSTD_compressStream2(this->context, &out, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+               if (ZSTD_isError(remaining))
+                  throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+               output.resize(previous + out.pos);
+            }
+            while (input.pos < input.size || (finish && remaining != 0));
+         }
+   };
+#endif
+
+   //! Returns a compressor of the given kind
+   Compressor* newCompressor(TextWriter::tCompression compression)
+   {
+#ifdef MOVRPTW_WITH_ZLIB
+      if (compression == TextWriter::GZIP_COMPRESSION)
+         return new GzipCompressor;
+#endif
+#ifdef MOVRPTW_WITH_ZSTD
+      if (compression == TextWriter::ZSTD_COMPRESSION)
+         return new ZstdCompressor;
+#endif
+      (void)compression;
+      throw std::runtime_error("Compression not available in this build");
+   }
+}
+
+/**
+  Compression stage: the writer hands over a full buffer (pending) and the
+  thread compresses and writes it, so there are at most two buffers: the
+  one being formatted and the one being compressed.
+*/
+struct TextWriter::tCompressionStage
+{
+   std::unique_ptr<Compressor> compressor;
+   std::thread thread;
+
+   std::mutex mutex;
+   std::condition_variable changed;
+
+   //! Buffer handed over to the stage and number of characters in it
+   std::vector<char> pending;
+   size_t pendingUsed;
+   bool pendingReady;
+
+   //! No more buffers will be handed over
+   bool finishing;
+
+   //! Error of the stage (empty if none)
+   std::string error;
+
+   //! Compressed bytes (reused)
+   std::vector<char> compressed;
+};
+
+// --- Private --- //
+
+/**
+  Method that writes characters to the file.
+  @param data is the first character.
+  @param length is the number of characters.
+  @throw std::runtime_error if they cannot be written.
+*/
+void TextWriter::writeToFile(const char* data, size_t length)
+{
+   if (this->contents)
+   {
+      this->contents->append(data, length);
+      return;
+   }
+
+   while (length > 0)
+   {
+      ssize_t written = ::write(this->descriptor, data, length);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         throw std::runtime_error("Unable to write " + this->fileName + ": " + strerror(errno));
+      }
+      data += written;
+      length -= written;
+   }
+}
+
+/**
+  Method run by the thread of the compression stage: it compresses and
+  writes each buffer handed over until the file is closed.
+*/
+void TextWriter::compressBuffers()
+{
+   tCompressionStage& stage = *this->stage;
+   std::unique_lock<std::mutex> lock(stage.mutex);
+   while (true)
+   {
+      stage.changed.wait(lock, [&stage]() { return stage.pendingReady || stage.finishing; });
+      bool finish = !stage.pendingReady;
+
+      // Compression runs without the lock, the writer may format the next buffer meanwhile
+      lock.unlock();
+      try
+      {
+         if (stage.error.empty())
+         {
+            stage.compressed.clear();
+            stage.compressor->compress(stage.pending.data(), finish ? 0 : stage.pendingUsed, finish, stage.compressed);
+            writeToFile(stage.compressed.data(), stage.compressed.size());
+         }
+      }
+      catch (const std::exception& exception)
+      {
+         stage.error = exception.what();
+      }
+      lock.lock();
+
+      if (finish)
+         return;
+      stage.pendingReady = false;
+      stage.changed.notify_all();
+   }
+}
+
+// --- Public --- //
+
+/**
+  Ctor. No file is open until open() is invoked.
+  @param bufferSize is the size in bytes of the buffer.
+*/
+TextWriter::TextWriter(size_t bufferSize)
+   : buffer(bufferSize < maxNumberLength ? maxNumberLength : bufferSize)
+{
+   this->descriptor = -1;
+   this->contents = NULL;
+   this->used = 0;
+   this->format = GENERAL;
+   this->precision = 6;
+   this->compression = NO_COMPRESSION;
+}
+
+/**
+  Dtor. It writes what remains in the buffer and closes the file.
+*/
+TextWriter::~TextWriter()
+{
+   try
+   {
+      close();
+   }
+   catch (const std::runtime_error&)
+   {
+   }
+}
+
+/**
+  Method that creates the file to be written. An existing file is
+  truncated, unless it has other hard links (e.g. matrices shared by
+  several instances, see BatchPipeline): then it is replaced, so they keep
+  their content. Any file previously open is closed.
+  @param fileName is the path to the file.
+  @throw std::runtime_error if it cannot be created.
+*/
+void TextWriter::open(const std::string& fileName)
+{
+   close();
+   this->fileName = fileName;
+   struct stat status;
+   if (lstat(fileName.c_str(), &status) == 0 && S_ISREG(status.st_mode) && status.st_nlink > 1)
+      unlink(fileName.c_str());
+   this->descriptor = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (this->descriptor < 0)
+      throw std::runtime_error("Unable to create " + fileName + ": " + strerror(errno));
+
+   startCompression();
+}
+
+/**
+  Method that starts writing to memory instead of a file (e.g. to store
+  the file in a pack, see PackWriter). Any file previously open is closed.
+  @param contents is the string where characters are appended (it must
+         not be accessed until close() is invoked).
+*/
+void TextWriter::openString(std::string& contents)
+{
+   close();
+   this->fileName = "<string>";
+   this->contents = &contents;
+
+   startCompression();
+}
+
+/**
+  Method that starts the thread of the compression stage (if the file is
+  compressed). If the compressor cannot be initialised, the file is closed.
+*/
+void TextWriter::startCompression()
+{
+   if (this->compression == NO_COMPRESSION)
+      return;
+
+   std::unique_ptr<tCompressionStage> stage(new tCompressionStage);
+   try
+   {
+      stage->compressor.reset(newCompressor(this->compression));
+   }
+   catch (const std::runtime_error&)
+   {
+      if (this->descriptor >= 0)
+         ::close(this->descriptor);
+      this->descriptor = -1;
+      this->contents = NULL;
+      throw;
+   }
+
+   this->stage = std::move(stage);
+   this->stage->pending.resize(this->buffer.size());
+   this->stage->pendingUsed = 0;
+   this->stage->pendingReady = false;
+   this->stage->finishing = false;
+   this->stage->thread = std::thread(&TextWriter::compressBuffers, this);
+}
+
+/**
+  Method that writes raw bytes (e.g. binary files).
+  @param data is the first byte.
+  @param length is the number of bytes.
+*/
+void TextWriter::write(const void* data, size_t length)
+{
+   *this << std::string_view(static_cast<const char*>(data), length);
+}
+
+/**
+  Method that writes the remaining characters and closes the file.
+  @throw std::runtime_error if they cannot be written.
+*/
+void TextWriter::close()
+{
+   if (this->descriptor < 0 && !this->contents)
+      return;
+
+   std::string error;
+   try
+   {
+      flush();
+   }
+   catch (const std::runtime_error& exception)
+   {
+      error = exception.what();
+   }
+
+   if (this->stage)
+   {
+      {
+         std::lock_guard<std::mutex> lock(this->stage->mutex);
+         this->stage->finishing = true;
+      }
+      this->stage->changed.notify_all();
+      this->stage->thread.join();
+      if (error.empty())
+         error = this->stage->error;
+      this->stage.reset();
+   }
+
+   if (this->descriptor >= 0 && ::close(this->descriptor) != 0 && error.empty())
+      error = "Unable to write " + this->fileName + ": " + strerror(errno);
+   this->descriptor = -1;
+   this->contents = NULL;
+   this->used = 0;
+
+   if (!error.empty())
+      throw std::runtime_error(error);
+}
+
+/**
+  Method that writes the content of the buffer to the file. If the file is
+  compressed, the buffer is handed over to the compression stage (waiting
+  for it to finish the previous one) and writing goes on in another buffer.
+  @throw std::runtime_error if it cannot be written.
+*/
+void TextWriter::flush()
+{
+   if (this->descriptor < 0 && !this->contents)
+      throw std::runtime_error("There is no file open to write");
+
+   if (!this->stage)
+   {
+      writeToFile(this->buffer.data(), this->used);
+      this->used = 0;
+      return;
+   }
+
+   tCompressionStage& stage = *this->stage;
+   std::unique_lock<std::mutex> lock(stage.mutex);
+   stage.changed.wait(lock, [&stage]() { return !stage.pendingReady; });
+   if (!stage.error.empty())
+      throw std::runtime_error(stage.error);
+
+   this->buffer.swap(stage.pending);
+   stage.pendingUsed = this->used;
+   stage.pendingReady = true;
+   lock.unlock();
+   stage.changed.notify_all();
+   this->used = 0;
+}
+
+/**
+  Method that sets the compression of the files opened from now on.
+  @param compression is NO_COMPRESSION, GZIP_COMPRESSION or ZSTD_COMPRESSION.
+  @throw std::runtime_error if it is not available in this build.
+*/
+void TextWriter::setCompression(tCompression compression)
+{
+   if (!isAvailable(compression))
+      throw std::runtime_error("Compression not available in this build");
+   this->compression = compression;
+}
+
+/**
+  Method that tells whether a kind of compression is available.
+  @param compression is the kind of compression.
+  @return true if the generator has been built with it.
+*/
+bool TextWriter::isAvailable(tCompression compression)
+{
+   switch (compression)
+   {
+      case NO_COMPRESSION:
+         return true;
+      case GZIP_COMPRESSION:
+#ifdef MOVRPTW_WITH_ZLIB
+         return true;
+#else
+         return false;
+#endif
+      case ZSTD_COMPRESSION:
+#ifdef MOVRPTW_WITH_ZSTD
+         return true;
+#else
+         return false;
+#endif
+   }
+   return false;
+}
+
+/**
+  Method that returns the extension of the compressed files.
+  @param compression is the kind of compression.
+  @return ".gz", ".zst" or "" (no compression).
+*/
+const char* TextWriter::extension(tCompression compression)
+{
+   if (compression == GZIP_COMPRESSION)
+      return ".gz";
+   if (compression == ZSTD_COMPRESSION)
+      return ".zst";
+   return "";
+}
+
+/**
+  Method that sets the format of the floating-point values.
+  @param format is GENERAL (like std::ostream), SHORTEST (round-trip) or FIXED.
+  @param precision is the number of significant digits (GENERAL) or decimals (FIXED).
+*/
+void TextWriter::setFormat(tFormat format, int precision)
+{
+   this->format = format;
+   this->precision = precision;
+}
+
+/**
+  Method that writes a piece of text.
+  @param text is the text.
+  @return the writer.
+*/
+TextWriter& TextWriter::operator<<(std::string_view text)
+{
+   while (!text.empty())
+   {
+      if (this->used == this->buffer.size())
+         flush();
+      size_t length = std::min(text.size(), this->buffer.size() - this->used);
+      memcpy(this->buffer.data() + this->used, text.data(), length);
+      this->used += length;
+      text.remove_prefix(length);
+   }
+   return *this;
+}
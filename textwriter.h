@@ -0,0 +1,173 @@
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "conversions.h"
+
+/**
+  Buffered writer of text files:
+     Characters are accumulated in a large buffer which is written to the
+     file with a single system call when it is full, and numbers are
+     formatted with std::to_chars (no streams, no locale). Floating-point
+     values are written in one of these formats:
+        - General: like an std::ostream with the given precision (6 by
+          default, which is what operator<< writes).
+        - Shortest: the shortest representation that reads back to the
+          same value.
+        - Fixed: a fixed number of decimals.
+     Optionally, the output is compressed on the fly (gzip or zstd, when
+     compiled with MOVRPTW_WITH_ZLIB or MOVRPTW_WITH_ZSTD). Compression is
+     a second stage run by its own thread: while a full buffer is being
+     compressed and written, the next one is being formatted.
+     Errors are reported by throwing std::runtime_error.
+   \code
+      TextWriter writer;
+      writer.open("matrix.dat");
+      writer.setFormat(TextWriter::FIXED, 2);
+      writer << 1.5 << '\t' << 2u << '\n';
+      writer.close();
+   \endcode
+*/
+class TextWriter
+{
+   public:
+      //! Format of the floating-point values
+      enum tFormat { GENERAL, SHORTEST, FIXED };
+
+      //! Compression of the file
+      enum tCompression { NO_COMPRESSION, GZIP_COMPRESSION, ZSTD_COMPRESSION };
+
+   private:
+      //! Compression stage (thread, compressor and buffer being compressed)
+      struct tCompressionStage;
+      //! File descriptor (-1 if it is not open)
+      int descriptor;
+
+      //! String where characters are written instead of a file (NULL if a file is written)
+      std::string* contents;
+
+      //! Name of the file (for error messages)
+      std::string fileName;
+
+      //! Buffer and number of characters in it
+      std::vector<char> buffer;
+      size_t used;
+
+      //! Format and precision of the floating-point values
+      tFormat format;
+      int precision;
+
+      //! Compression of the next file opened and its stage (NULL if not compressed)
+      tCompression compression;
+      std::unique_ptr<tCompressionStage> stage;
+
+      //! Method that writes characters to the file (or the string)
+      void writeToFile(const char*, size_t);
+
+      //! Method that starts the compression stage (if any)
+      void startCompression();
+
+      //! Method run by the thread of the compression stage
+      void compressBuffers();
+
+      //! Max number of characters of a number (fixed format of the largest double)
+      static const size_t maxNumberLength = 512;
+
+      //! Method that makes room in the buffer for a number
+      char* reserveNumber()
+      {
+         if (this->buffer.size() - this->used < maxNumberLength)
+            flush();
+         return this->buffer.data() + this->used;
+      }
+
+      //! Non-copyable
+      TextWriter(const TextWriter&);
+      TextWriter& operator=(const TextWriter&);
+
+   public:
+
+      //! Ctor.
+      /*!
+        \param bufferSize is the size in bytes of the buffer (1 MB by default).
+      */
+      explicit TextWriter(size_t bufferSize = 1 << 20);
+
+      //! Dtor. It writes what remains in the buffer (errors are ignored, call close() to detect them).
+      ~TextWriter();
+
+      //! Method that creates (or replaces) the file to be written
+      void open(const std::string& fileName);
+
+      //! Method that starts writing to a string instead of a file
+      void openString(std::string& contents);
+
+      //! Method that writes what remains in the buffer and closes the file
+      void close();
+
+      //! Method that writes the content of the buffer to the file (or passes it to the compression stage)
+      void flush();
+
+      //! Sets the compression of the files opened from now on
+      void setCompression(tCompression);
+
+      //! Returns true if a kind of compression is available in this build
+      static bool isAvailable(tCompression);
+
+      //! Returns the extension of the files with a kind of compression (.gz, .zst or empty)
+      static const char* extension(tCompression);
+
+      //! Sets the format and precision of the floating-point values
+      void setFormat(tFormat format, int precision = 6);
+
+      //! Method that writes raw bytes
+      void write(const void* data, size_t length);
+
+      //! Methods that write text
+      TextWriter& operator<<(std::string_view text);
+      TextWriter& operator<<(char character)
+      {
+         if (this->used == this->buffer.size())
+            flush();
+         this->buffer[this->used++] = character;
+         return *this;
+      }
+
+      //! Method that writes a floating-point value in the current format
+      TextWriter& operator<<(double value)
+      {
+         char* first = reserveNumber();
+         char* last = first + maxNumberLength;
+         std::to_chars_result conversion;
+         if (this->format == SHORTEST)
+            conversion = std::to_chars(first, last, value);
+         else if (this->format == FIXED)
+            conversion = std::to_chars(first, last, value, std::chars_format::fixed, this->precision);
+         else
+            conversion = std::to_chars(first, last, value, std::chars_format::general, this->precision);
+         if (conversion.ec != std::errc())
+            throw std::length_error("Precision too large to write a value");
+         this->used = conversion.ptr - this->buffer.data();
+         return *this;
+      }
+
+      //! Method that writes an integer value
+      template <typename T>
+      typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, TextWriter&>::type
+      operator<<(T value)
+      {
+         char* first = reserveNumber();
+         this->used = somethingToChars(first, first + maxNumberLength, value) - this->buffer.data();
+         return *this;
+      }
+};
+
+#endif // TEXTWRITER_H
@@ -31,19 +31,115 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
-#include "tinyxml/tinyxml.h"
-
+#include "binaryinstance.h"
 #include "conversions.h"
+#include "distributions.h"
+#include "packwriter.h"
+#include "specregistry.h"
 #include "vrptwinstancegenerator.h"
 #include "MersenneTwister.h"
 
+namespace
+{
+   /**
+     Generator of the same sequence of numbers as rand() after srand(seed)
+     (glibc), but with its own state. The costumers of the Random mode
+     have always been shuffled with rand(); a private state keeps those
+     instances unchanged while making each one independent of the
+     instances generated before it in the same process.
+   */
+   class LegacyRandom
+   {
+      private:
+         int32_t state[31];
+         unsigned front;
+         unsigned rear;
+
+      public:
+         explicit LegacyRandom(unsigned seed)
+         {
+            if (seed == 0)
+               seed = 1;
+
+            int32_t word = seed;
+            this->state[0] = seed;
+            for (unsigned i = 1; i < 31; i++)
+            {
+               // 16807 * word % 2147483647 without overflow
+               int32_t hi = word / 127773;
+               int32_t lo = word % 127773;
+               word = 16807 * lo - 2836 * hi;
+               if (word < 0)
+                  word += 2147483647;
+               this->state[i] = word;
+            }
+
+            this->front = 3;
+            this->rear = 0;
+            for (unsigned i = 0; i < 310; i++)
+               next();
+         }
+
+         int next()
+         {
+            uint32_t value = uint32_t(this->state[this->front]) + uint32_t(this->state[this->rear]);
+            this->state[this->front] = int32_t(value);
+            this->front = (this->front + 1) % 31;
+            this->rear = (this->rear + 1) % 31;
+            return int(value >> 1);
+         }
+   };
+
+   /**
+     Output of the sections of a binary file that keeps the offset and the
+     checksum of what is written after the header. Without a writer,
+     nothing is written but the checksum is computed.
+   */
+   class BinaryOutput
+   {
+      private:
+         TextWriter* output;
+         uint64_t offset;
+         uint64_t hash;
+
+      public:
+         BinaryOutput(TextWriter* output, uint64_t offset) : output(output), offset(offset), hash(binaryInstanceHashSeed) {}
+
+         void write(const void* data, size_t length)
+         {
+            if (this->output)
+               this->output->write(data, length);
+            else
+               this->hash = binaryInstanceHash(this->hash, data, length);
+            this->offset += length;
+         }
+
+         //! Writes zeros up to the start of the next section and returns its offset
+         uint64_t align()
+         {
+            static const char zeros[binaryInstanceAlignment] = {};
+            write(zeros, binaryInstanceAlign(this->offset) - this->offset);
+            return this->offset;
+         }
+
+         uint64_t getOffset() const { return this->offset; }
+         uint64_t getHash() const { return this->hash; }
+   };
+}
+
 // --- Protected --- //
 
 /**
@@ -67,22 +163,25 @@ void VRPTWInstanceGenerator::warning(const std::string& warningMessage)
 }
 
 /**
-   Method that given the two first two elements of a table of nx3 returns the third element.
-   @param table is the matrix in which we want to look for the third element.
-   @param from is the first element or index.
-   @param to is the second element or index.
-   @return the value of the third element.
+  Method that returns the network, exiting if it has not been read.
+  @return the network.
 */
-double VRPTWInstanceGenerator::getData(const rawInfoVector& table, unsigned from, unsigned to)
+const Network& VRPTWInstanceGenerator::checkNetwork()
 {
-   if (from == to)
-      return 0;
-   for (size_t i = 0; i < table.size(); i++)
-      if (table[i].from == from && table[i].to == to)
-         return table[i].length;
+   if (!this->network)
+      error("The network has not been read");
+   return *this->network;
+}
 
-   error("Unexpected error looking for length");
-   return 0;
+/**
+  Method that returns a copy of the network to read a file into it. The
+  network is shared with other generators (and threads) and it is never
+  modified once read, so a new one replaces it.
+  @return the copy of the network (an empty one if none has been read).
+*/
+std::shared_ptr<Network> VRPTWInstanceGenerator::editNetwork()
+{
+   return this->network ? std::make_shared<Network>(*this->network) : std::make_shared<Network>();
 }
 
 /**
@@ -102,18 +201,239 @@ unsigned VRPTWInstanceGenerator::getCategoryRandomly(double randNumber, const ac
 }
 
 /**
-  Method that returns the index of a given element (id) within the positions vector
-  @param id is the id of the element we are looking for
-  @return the position (index) within the vector
+  Method that returns the position of the depot, exiting if the positions
+  have not been read.
+  @return the position of the depot.
 */
-unsigned VRPTWInstanceGenerator::getPosition(unsigned id)
+tPos VRPTWInstanceGenerator::getDepotPosition()
 {
-   for (size_t i = 0; i < this->positions.size(); i++)
-      if (this->positions[i].id == id)
-         return i;
+   const Network& network = checkNetwork();
+   if (network.getSpatialIndex().empty())
+      error("There are no positions to index");
 
-   error("getPosition(). Id not found");
-   return 0;
+   try
+   {
+      return network.getPositions()[network.getPosition(network.getIds()[0])];
+   }
+   catch (const std::exception& exception)
+   {
+      error(exception.what());
+   }
+   return tPos();
+}
+
+/**
+  Method that computes the size of the fleet and the max capacity of each
+  vehicle: the minimum capacity is the largest demand, and delta sets how
+  much of the remaining total demand is added to it.
+  @param sumOfDemands is the total demand of the costumers.
+  @param maxDemand is the largest demand a costumer may have.
+  @param sizeOfFleet is the number of vehicles.
+  @param vehicleMaxCapacity is the capacity of each vehicle.
+*/
+void VRPTWInstanceGenerator::computeFleet(double sumOfDemands, double maxDemand, unsigned& sizeOfFleet, capacityType& vehicleMaxCapacity)
+{
+   capacityType sum = sumOfDemands;
+   capacityType delta = this->demandSpec->demands.delta;
+   capacityType minCapacity = std::max(1.0, maxDemand);
+   sizeOfFleet = ceil((double)sum / (double)(minCapacity));
+   vehicleMaxCapacity = minCapacity + ceil((sum - minCapacity) * ((double)delta/(double)100));
+}
+
+/**
+  Method that returns the position of a costumer of the instance.
+  @param costumer is the index of the costumer within the random ids (0 is the depot).
+  @return the position.
+*/
+const tPos& VRPTWInstanceGenerator::getCostumerPosition(size_t costumer)
+{
+   const Network& network = checkNetwork();
+   try
+   {
+      return network.getPositions()[network.getPosition(network.getIds()[this->instance.randomIds[costumer]])];
+   }
+   catch (const std::exception& exception)
+   {
+      error(exception.what());
+   }
+   return network.getPositions()[0];
+}
+
+/**
+  Method that tells whether a position can be selected as a costumer, that is,
+  it has a real id, it is not the depot and it is within the sampling radius.
+  @param position is the index of the position.
+  @param depot is the position of the depot.
+  @return true if the position can be selected.
+*/
+bool VRPTWInstanceGenerator::isSelectable(unsigned position, const tPos& depot)
+{
+   unsigned idIndex = this->network->getIdIndex(position);
+   if (idIndex == 0 || idIndex >= this->network->getIds().size())
+      return false;
+
+   if (this->samplingRadius > 0)
+   {
+      const tPos& costumer = this->network->getPositions()[position];
+      return this->network->getSpatialIndex().distance(depot.lat, depot.lng, costumer.lat, costumer.lng) <= this->samplingRadius;
+   }
+
+   return true;
+}
+
+/**
+  Method that fills the random ids using the spatial index. In Clustered mode,
+  centres are drawn at random and their nearest neighbours make up the
+  clusters; in Mixed mode half of the costumers are clustered and the rest are
+  drawn at random. If a sampling radius is set, only costumers within that
+  distance of the depot are considered. Without a radius, the selection takes
+  O(size log N) (costumers are drawn directly from the whole network); with
+  a radius, the positions within it are collected first.
+*/
+void VRPTWInstanceGenerator::selectCostumersSpatially()
+{
+   const tPos depot = getDepotPosition();
+   const costumersPosType& positions = this->network->getPositions();
+   const SpatialIndex& spatialIndex = this->network->getSpatialIndex();
+
+   MTRand randomGenerator(this->matrixSeed);
+
+   // With a radius, candidates are drawn from the positions within it;
+   //   otherwise, from the whole network (without building a pool of them).
+   std::vector<unsigned> pool;
+   size_t poolSize = positions.size();
+   if (this->samplingRadius > 0)
+   {
+      std::vector<unsigned> withinRadius;
+      spatialIndex.withinRadius(depot.lat, depot.lng, this->samplingRadius, withinRadius);
+      for (size_t i = 0; i < withinRadius.size(); i++)
+         if (isSelectable(withinRadius[i], depot))
+            pool.push_back(withinRadius[i]);
+
+      if (pool.size() < this->size)
+         error("selectCostumersSpatially(). Not enough costumers within the sampling radius");
+      poolSize = pool.size();
+   }
+   auto draw = [&]() -> unsigned
+   {
+      unsigned i = randomGenerator.randInt(poolSize - 1);
+      return pool.empty()? i : pool[i];
+   };
+
+   std::set<unsigned> selected;
+   unsigned clustered = 0;
+   if (this->samplingMode == "Clustered")
+      clustered = this->size;
+   else if (this->samplingMode == "Mixed")
+      clustered = this->size / 2;
+
+   // Every draw that is rejected counts towards this limit to avoid looping forever
+   unsigned long attempts = 0;
+   unsigned long maxAttempts = 100 * (unsigned long)(this->size + 1) + 10 * (unsigned long)poolSize;
+
+   std::vector<unsigned> neighbours;
+   std::vector<unsigned> candidates;
+   while (selected.size() < clustered)
+   {
+      unsigned centre = draw();
+      if (++attempts > maxAttempts)
+         error("selectCostumersSpatially(). Unable to build the clusters");
+      if (!isSelectable(centre, depot) || selected.count(centre))
+         continue;
+
+      // Neighbours of the centre (it is the first one) not selected yet
+      spatialIndex.nearest(positions[centre].lat, positions[centre].lng, 2 * this->clusterSize, neighbours);
+      candidates.clear();
+      for (size_t i = 0; i < neighbours.size(); i++)
+         if (isSelectable(neighbours[i], depot) && !selected.count(neighbours[i]))
+            candidates.push_back(neighbours[i]);
+      if (candidates.empty())
+         continue;
+
+      unsigned take = std::min<size_t>(std::min<size_t>(this->clusterSize, clustered - selected.size()), candidates.size());
+      selected.insert(candidates[0]);
+      for (size_t i = 1; i < take; i++)
+      {
+         size_t j = i + randomGenerator.randInt(candidates.size() - 1 - i);
+         std::swap(candidates[i], candidates[j]);
+         selected.insert(candidates[i]);
+      }
+
+      for (size_t i = 0; i < take; i++)
+         this->instance.randomIds.push_back(this->network->getIdIndex(candidates[i]));
+   }
+
+   while (selected.size() < this->size)
+   {
+      unsigned position = draw();
+      if (++attempts > maxAttempts)
+         error("selectCostumersSpatially(). Not enough costumers in the network");
+      if (!isSelectable(position, depot) || !selected.insert(position).second)
+         continue;
+
+      this->instance.randomIds.push_back(this->network->getIdIndex(position));
+   }
+}
+
+/**
+  Method that fills the random ids drawing from each k-means cluster a number
+  of costumers given by the cluster proportions (largest remainder rounding).
+*/
+void VRPTWInstanceGenerator::selectCostumersByClusters()
+{
+   if (this->numberOfClusters == 0)
+      error("selectCostumersByClusters(). The number of clusters must be greater than 0 in KMeans mode");
+
+   const tPos depot = getDepotPosition();
+   std::shared_ptr<const std::vector<idsType> > clustering = this->network->getClusters(this->numberOfClusters, this->threads);
+   const std::vector<idsType>& clusters = *clustering;
+
+   std::vector<double> proportions(this->clusterProportions);
+   if (proportions.empty())
+      proportions.assign(clusters.size(), 1);
+   if (proportions.size() != clusters.size())
+      error("selectCostumersByClusters(). The number of proportions does not match the number of clusters");
+
+   double sum = 0;
+   for (size_t c = 0; c < proportions.size(); c++)
+      sum += proportions[c];
+   if (sum <= 0)
+      error("selectCostumersByClusters(). The proportions must add up to a positive value");
+
+   // Number of costumers from each cluster
+   std::vector<unsigned> counts(clusters.size());
+   std::vector<std::pair<double, size_t> > remainders;
+   unsigned assigned = 0;
+   for (size_t c = 0; c < clusters.size(); c++)
+   {
+      double share = this->size * proportions[c] / sum;
+      counts[c] = (unsigned)share;
+      assigned += counts[c];
+      remainders.push_back(std::make_pair(counts[c] - share, c));
+   }
+   std::sort(remainders.begin(), remainders.end());
+   for (size_t i = 0; assigned < this->size; i++, assigned++)
+      counts[remainders[i % remainders.size()].second]++;
+
+   MTRand randomGenerator(this->matrixSeed);
+   std::vector<unsigned> candidates;
+   for (size_t c = 0; c < clusters.size(); c++)
+   {
+      candidates.clear();
+      for (size_t i = 0; i < clusters[c].size(); i++)
+         if (isSelectable(clusters[c][i], depot))
+            candidates.push_back(clusters[c][i]);
+
+      if (candidates.size() < counts[c])
+         error("selectCostumersByClusters(). Not enough costumers in cluster " + somethingToString(c));
+
+      for (size_t i = 0; i < counts[c]; i++)
+      {
+         size_t j = i + randomGenerator.randInt(candidates.size() - 1 - i);
+         std::swap(candidates[i], candidates[j]);
+         this->instance.randomIds.push_back(this->network->getIdIndex(candidates[i]));
+      }
+   }
 }
 
 // --- Public ---
@@ -136,11 +456,36 @@ VRPTWInstanceGenerator::VRPTWInstanceGenerator()
 
    // Prefix will be set to the current time to avoid
    //   file name conflicts.
-   std::ostringstream outputStream;
-   outputStream << seed;
-   this->prefix = "output" + outputStream.str();
-
+   this->prefix = "output" + somethingToString(seed);
+
+   // By default, costumers are selected at random from the whole network
+   this->samplingMode = "Random";
+   this->samplingRadius = 0;
+   this->clusterSize = 10;
+   this->numberOfClusters = 8;
+   this->threads = 0;
+   this->reachableTimeWindows = false;
+   this->numberOfScenarios = 0;
+
+   // Matrices are written as std::ostream does by default
+   this->matrixFormat = TextWriter::GENERAL;
+   this->matrixPrecision = 6;
+   this->binaryOutput = false;
+   this->compression = TextWriter::NO_COMPRESSION;
+
+   this->instance.sizeOfFleet = 0;
+   this->instance.vehicleMaxCapacity = 0;
+}
 
+/**
+  Ctor. It sets default values for data members and the network the instances
+  are drawn from. Generators of the same network share it (e.g. those of
+  the threads of a batch), so creating or copying them does not copy it.
+  @param network is the network (already read).
+*/
+VRPTWInstanceGenerator::VRPTWInstanceGenerator(std::shared_ptr<const Network> network) : VRPTWInstanceGenerator()
+{
+   this->network = network;
 }
 
 /**
@@ -156,20 +501,16 @@ VRPTWInstanceGenerator::~VRPTWInstanceGenerator()
 */
 void VRPTWInstanceGenerator::readDistancesFile(const char *distanceFileName)
 {
-    // Read table of distances.
-    std::fstream distanceFile(distanceFileName);
-    unsigned from = 0;
-    unsigned to = 0;
-    double length = 0;
-    while (distanceFile >> from >> to >> length)
+    try
+    {
+        std::shared_ptr<Network> network = editNetwork();
+        network->readDistances(distanceFileName);
+        this->network = network;
+    }
+    catch (const std::exception& exception)
     {
-       tData info;
-       info.from = from;
-       info.to = to;
-       info.length = length;
-       distanceTable.push_back(info);
+        error(exception.what());
     }
-    distanceFile.close();
 }
 
 /**
@@ -178,20 +519,16 @@ void VRPTWInstanceGenerator::readDistancesFile(const char *distanceFileName)
 */
 void VRPTWInstanceGenerator::readTimesFile(const char *timeFileName)
 {
-    // Read table of times.
-    std::fstream timeFile(timeFileName);
-    unsigned from = 0;
-    unsigned to = 0;
-    double length = 0;
-    while (timeFile >> from >> to >> length)
+    try
+    {
+        std::shared_ptr<Network> network = editNetwork();
+        network->readTimes(timeFileName);
+        this->network = network;
+    }
+    catch (const std::exception& exception)
     {
-       tData info;
-       info.from = from;
-       info.to = to;
-       info.length = length;
-       timeTable.push_back(info);
+        error(exception.what());
     }
-    timeFile.close();
 }
 
 /**
@@ -202,12 +539,16 @@ void VRPTWInstanceGenerator::readIds(const char *idsFileName)
 {
     // Read ids for matching
     std::cout << "Reading ids" << std::endl;
-    std::fstream idsFile(idsFileName);
-    unsigned trash = 0;
-    unsigned id = 0;
-    while (idsFile >> trash >> id)
-       ids.push_back(id);
-    idsFile.close();
+    try
+    {
+        std::shared_ptr<Network> network = editNetwork();
+        network->readIds(idsFileName);
+        this->network = network;
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
+    }
 }
 
 /**
@@ -216,107 +557,135 @@ void VRPTWInstanceGenerator::readIds(const char *idsFileName)
 */
 void VRPTWInstanceGenerator::readPositions(const char* idslatlngFileName)
 {
-   std::fstream idsLatLngFile(idslatlngFileName);
-   tPos row;
-   while (idsLatLngFile >> row.id >> row.lat >> row.lng)
-      this->positions.push_back(row);
+   try
+   {
+      std::shared_ptr<Network> network = editNetwork();
+      network->readPositions(idslatlngFileName);
+      this->network = network;
+   }
+   catch (const std::exception& exception)
+   {
+      error(exception.what());
+   }
+}
+
+/**
+  Method that sets the network the instances are drawn from (e.g. read once
+  and shared by the generators of a batch). It is not copied.
+  @param network is the network.
+*/
+void VRPTWInstanceGenerator::setNetwork(std::shared_ptr<const Network> network)
+{
+   this->network = network;
+}
+
+/**
+  Method that returns the network the instances are drawn from.
+  @return the network (NULL if none has been read).
+*/
+std::shared_ptr<const Network> VRPTWInstanceGenerator::getNetwork() const
+{
+   return this->network;
 }
 
 /**
-  Method that reads the time windows specification
+  Method that reads the time windows specification (replacing any previous one).
+  If there is no such file, the standard preset with that name is used (tw0-equal to tw4-equal).
   @para fileName is the path to the file containing the time windows specification
 */
 void VRPTWInstanceGenerator::readTimeWindowsFile(const char* fileName)
 {
-    TiXmlDocument XMLdoc(fileName);
-    bool loadOkay = XMLdoc.LoadFile();
-    if (loadOkay)
+    try
     {
-        TiXmlElement *pRoot, *pDepot, *pTimeWindows, *pTimeWindow;
-        pRoot = XMLdoc.FirstChildElement( "time-windows-specification");
-        pDepot = pRoot->FirstChildElement("depot");
-        this->timeWindows.timeWindowDepot.opens = fromStringTo<double>(std::string(pDepot->Attribute("opens")));
-        this->timeWindows.timeWindowDepot.closes = fromStringTo<double>(std::string(pDepot->Attribute("closes")));
-
-        pTimeWindows = pRoot->FirstChildElement("time-windows");
-        pTimeWindow = pTimeWindows->FirstChildElement("time-window");
-        while (pTimeWindow)
-        {
-            tTimeWindowCostumer timeWindowCostumer;
-            timeWindowCostumer.opens = fromStringTo<double>(std::string(pTimeWindow->Attribute("opens")));
-            timeWindowCostumer.closes = fromStringTo<double>(std::string(pTimeWindow->Attribute("closes")));
-            timeWindowCostumer.probability = fromStringTo<unsigned>(std::string(pTimeWindow->Attribute("probability")));
-            this->timeWindows.timeWindowsCostumers.push_back(timeWindowCostumer);
-            pTimeWindow = pTimeWindow->NextSiblingElement("time-window");
-        }
+        this->timeWindowSpec = SpecRegistry::parseTimeWindows(fileName);
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
     }
-    else
-        error("Unable to read the time windows file");
-
 }
 
 /**
-  Method that reads the demand specifications
+  Method that reads the demand specifications (replacing any previous one).
+  If there is no such file, the standard preset with that name is used (d0-equal or d1-equal).
   @param fileName is the path to the file containing the demands specifications.
 */
 void VRPTWInstanceGenerator::readDemandsFile(const char* fileName)
 {
-    TiXmlDocument XMLdoc(fileName);
-    bool loadOkay = XMLdoc.LoadFile();
-    if (loadOkay)
+    try
     {
-        TiXmlElement *pRoot, *pParm, *pDemands, *pDemand;
-        pRoot = XMLdoc.FirstChildElement( "demands-specifications" );
-        if ( pRoot )
-        {
-            // Parse looseness
-            pParm = pRoot->FirstChildElement("delta");
-            this->demands.delta = fromStringTo<unsigned>(std::string(pParm->Attribute("value")));
-
-            // Parse Process
-            pDemands = pRoot->FirstChildElement("demands");
-            pDemand = pDemands->FirstChildElement("demand");
-            while ( pDemand )
-            {
-               tDemandCostumer demandCostumer;
-               demandCostumer.type = fromStringTo<unsigned>(std::string(pDemand->Attribute("type")));
-               demandCostumer.probability = fromStringTo<double>(std::string(pDemand->Attribute("probability")));
-               this->demands.demandsCostumers.push_back(demandCostumer);
-               pDemand = pDemand->NextSiblingElement( "demand" );
-
-            }
-        }
-        else
-            error("Unable to read the demands file");
+        this->demandSpec = SpecRegistry::parseDemands(fileName);
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
     }
 }
 
 /**
-  Method that reads the service times specifications.
+  Method that reads the service times specifications (replacing any previous one).
+  If there is no such file, the standard preset with that name is used (st0-equal).
   @param fieName is the path to the file containing the specifications.
 */
 void VRPTWInstanceGenerator::readServiceTimesFile(const char* fileName)
 {
-    TiXmlDocument XMLdoc(fileName);
-    bool loadOkay = XMLdoc.LoadFile();
-    if (loadOkay)
+    try
     {
-        TiXmlElement *pRoot, *pServiceTimes, *pServiceTime;
-        pRoot = XMLdoc.FirstChildElement("service-times-specifications");
-        pServiceTimes = pRoot->FirstChildElement("service-times");
-        pServiceTime = pServiceTimes->FirstChildElement("service-time");
-        while (pServiceTime)
-        {
-            tServiceTimeCostumer serviceTime;
-            serviceTime.type = fromStringTo<double>(std::string(pServiceTime->Attribute("type")));
-            serviceTime.probability = fromStringTo<unsigned>(std::string(pServiceTime->Attribute("probability")));
-            this->serviceTimes.push_back(serviceTime);
-            pServiceTime = pServiceTime->NextSiblingElement("service-time");
-        }
+        this->serviceTimeSpec = SpecRegistry::parseServiceTimes(fileName);
     }
-    else
-        error("Error - Unable to read the service time specifications file.");
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
+    }
+}
+
+/**
+  Methods that set an already compiled specification (e.g. from a SpecRegistry).
+  @param spec is the compiled specification.
+*/
+void VRPTWInstanceGenerator::setTimeWindows(std::shared_ptr<const tTimeWindowSpec> spec)
+{
+    this->timeWindowSpec = spec;
+}
+
+void VRPTWInstanceGenerator::setDemands(std::shared_ptr<const tDemandSpec> spec)
+{
+    this->demandSpec = spec;
+}
+
+void VRPTWInstanceGenerator::setServiceTimes(std::shared_ptr<const tServiceTimeSpec> spec)
+{
+    this->serviceTimeSpec = spec;
+}
 
+/**
+  Method that sets up the generator according to a scenario (see ScenarioFile).
+  @param scenario is the scenario.
+*/
+void VRPTWInstanceGenerator::setScenario(const tScenario& scenario)
+{
+    setSize(scenario.size);
+
+    setSeed("Matrices", scenario.matrixSeed);
+    setSeed("Time Windows", scenario.timeWindowSeed);
+    setSeed("Demands", scenario.demandSeed);
+    setSeed("Service Times", scenario.serviceTimeSeed);
+
+    setSamplingMode(scenario.samplingMode);
+    setSamplingRadius(scenario.samplingRadius);
+    setNumberOfClusters(scenario.numberOfClusters);
+    setClusterProportions(scenario.clusterProportions);
+    setReachableTimeWindows(scenario.reachableTimeWindows);
+    setDemandScenarios(scenario.demandScenarios);
+
+    setTimeWindows(scenario.timeWindows);
+    setDemands(scenario.demands);
+    setServiceTimes(scenario.serviceTimes);
+
+    setPrefix(scenario.prefix);
+    setMatrixFormat(scenario.matrixFormat, scenario.matrixPrecision);
+    setBinaryOutput(scenario.binaryOutput);
+    setCompression(scenario.compression);
 }
 
 /**
@@ -354,19 +723,161 @@ void VRPTWInstanceGenerator::setPrefix(const std::string& prefix)
    this->prefix = prefix;
 }
 
+/**
+  Method to set the mode employed to select the costumers.
+  @param mode is either Random, Clustered, Mixed (half clustered, half random)
+         or KMeans (drawn from geographic clusters of the network).
+*/
+void VRPTWInstanceGenerator::setSamplingMode(const std::string& mode)
+{
+   if (mode != "Random" && mode != "Clustered" && mode != "Mixed" && mode != "KMeans")
+      error("Unknown sampling mode: " + mode);
+   this->samplingMode = mode;
+}
+
+/**
+  Method to set the max distance between the depot and the costumers.
+  @param radius is the distance in km (0 means no limit).
+*/
+void VRPTWInstanceGenerator::setSamplingRadius(double radius)
+{
+   this->samplingRadius = radius;
+}
+
+/**
+  Method to set the number of costumers in each cluster.
+  @param clusterSize is the number of costumers per cluster.
+*/
+void VRPTWInstanceGenerator::setClusterSize(unsigned clusterSize)
+{
+   if (clusterSize == 0)
+      error("The size of the clusters must be greater than 0");
+   this->clusterSize = clusterSize;
+}
+
+/**
+  Method to set the number of geographic clusters employed in KMeans mode
+  (it is checked when the costumers are selected, so it is ignored in the
+  other modes).
+  @param numberOfClusters is the number of clusters.
+*/
+void VRPTWInstanceGenerator::setNumberOfClusters(unsigned numberOfClusters)
+{
+   this->numberOfClusters = numberOfClusters;
+}
+
+/**
+  Method to set the proportion of costumers drawn from each geographic cluster.
+  @param proportions is a vector of weights, one per cluster (empty means equal).
+*/
+void VRPTWInstanceGenerator::setClusterProportions(const std::vector<double>& proportions)
+{
+   this->clusterProportions = proportions;
+}
+
+/**
+  Method to set whether time windows must be reachable from the depot.
+  @param reachable is true to adjust the time windows in generateAll().
+*/
+void VRPTWInstanceGenerator::setReachableTimeWindows(bool reachable)
+{
+   this->reachableTimeWindows = reachable;
+}
+
+/**
+  Method to set the number of stochastic demand scenarios.
+  @param scenarios is the number of scenarios generated and written by generateAll() and writeAll() (0 means none).
+*/
+void VRPTWInstanceGenerator::setDemandScenarios(unsigned scenarios)
+{
+   this->numberOfScenarios = scenarios;
+}
+
+/**
+  Method to set whether writeAll() also writes the binary instance.
+  @param binary is true to write <prefix>Instance.bin.
+*/
+void VRPTWInstanceGenerator::setBinaryOutput(bool binary)
+{
+   this->binaryOutput = binary;
+}
+
+/**
+  Method to set the format of the values of the matrices.
+  @param format is General (as std::ostream, by default), Shortest (shortest
+         representation that reads back to the same value) or Fixed.
+  @param precision is the number of significant digits (General) or decimals (Fixed).
+*/
+void VRPTWInstanceGenerator::setMatrixFormat(const std::string& format, int precision)
+{
+   if (format == "General")
+      this->matrixFormat = TextWriter::GENERAL;
+   else if (format == "Shortest")
+      this->matrixFormat = TextWriter::SHORTEST;
+   else if (format == "Fixed")
+      this->matrixFormat = TextWriter::FIXED;
+   else
+      error("Unknown format of the matrices: " + format);
+
+   if (precision < 0 || precision > 100)
+      error("The precision of the matrices must be between 0 and 100");
+   this->matrixPrecision = precision;
+}
+
+/**
+  Method to set the compression of the text files (matrices and
+  specifications), which get the extension .gz or .zst.
+  @param compression is None (by default), Gzip or Zstd (if available in this build).
+*/
+void VRPTWInstanceGenerator::setCompression(const std::string& compression)
+{
+   TextWriter::tCompression kind = TextWriter::NO_COMPRESSION;
+   if (compression == "Gzip")
+      kind = TextWriter::GZIP_COMPRESSION;
+   else if (compression == "Zstd")
+      kind = TextWriter::ZSTD_COMPRESSION;
+   else if (compression != "None")
+      error("Unknown compression: " + compression);
+
+   if (!TextWriter::isAvailable(kind))
+      error("Compression " + compression + " is not available in this build");
+   this->compression = kind;
+}
+
+/**
+  Method to set the number of threads.
+  @param threads is the number of threads (0 means as many as cores).
+*/
+void VRPTWInstanceGenerator::setThreads(unsigned threads)
+{
+   this->threads = threads;
+}
+
 /**
   Method that generates the distance matrix using random ids.
 */
 void VRPTWInstanceGenerator::generateDistanceMatrix()
 {
+    const Network& network = checkNetwork();
+    const std::vector<unsigned>& ids = network.getIds();
+    const std::vector<unsigned>& randomIds = this->instance.randomIds;
+    matrixType& distanceMatrix = this->instance.distanceMatrix;
+
     unsigned matrixSize = this->size + 1;
     distanceMatrix.resize(matrixSize);
     for (size_t i = 0; i < (unsigned)matrixSize; i++)
        distanceMatrix[i].resize(matrixSize);
 
-    for (size_t i = 0; i < (unsigned)matrixSize; i++)
-       for (size_t j = 0; j < (unsigned)matrixSize; j++)
-          distanceMatrix[i][j] = getData(distanceTable, ids[randomIds[i]], ids[randomIds[j]]);
+    try
+    {
+        for (size_t i = 0; i < (unsigned)matrixSize; i++)
+           for (size_t j = 0; j < (unsigned)matrixSize; j++)
+              distanceMatrix[i][j] = network.getDistance(ids[randomIds[i]], ids[randomIds[j]]);
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
+    }
 }
 
 /**
@@ -374,44 +885,73 @@ void VRPTWInstanceGenerator::generateDistanceMatrix()
 */
 void VRPTWInstanceGenerator::generateTimeMatrix()
 {
+    const Network& network = checkNetwork();
+    const std::vector<unsigned>& ids = network.getIds();
+    const std::vector<unsigned>& randomIds = this->instance.randomIds;
+    matrixType& timeMatrix = this->instance.timeMatrix;
+
     unsigned matrixSize = this->size + 1;
     timeMatrix.resize(matrixSize);
     for (size_t i = 0; i < (unsigned)matrixSize; i++)
        timeMatrix[i].resize(matrixSize);
 
-    for (size_t i = 0; i < (unsigned)matrixSize; i++)
-       for (size_t j = 0; j < (unsigned)matrixSize; j++)
-          timeMatrix[i][j] = getData(timeTable, ids[randomIds[i]], ids[randomIds[j]]);
+    try
+    {
+        for (size_t i = 0; i < (unsigned)matrixSize; i++)
+           for (size_t j = 0; j < (unsigned)matrixSize; j++)
+              timeMatrix[i][j] = network.getTime(ids[randomIds[i]], ids[randomIds[j]]);
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
+    }
 }
 
 /**
   Method that generates a vector of random ids (size value random ids) and
-  invokes generateDistanceMatrix and generateTimeMatrix().
+  invokes generateDistanceMatrix and generateTimeMatrix(). Unless the sampling
+  mode is Random and there is no radius, costumers are selected using the
+  spatial index.
 */
 void VRPTWInstanceGenerator::generateMatrices()
 {
-    // Creation of random ids
-    idsType tempIds;
-    for (size_t i = 0; i < this->ids.size(); i++)
-        tempIds.push_back(i);
+    const std::vector<unsigned>& ids = checkNetwork().getIds();
 
-    std::random_shuffle(tempIds.begin(), tempIds.end());
-
-    for (size_t i = 0; i < this->size; i++)
-        this->randomIds.push_back(tempIds[i]);
-
-    // + depot
-    this->randomIds.insert(this->randomIds.begin(), 0);
+    // Depot + costumers of this sample (the capacity of a previous one is reused)
+    this->instance.randomIds.clear();
+    this->instance.randomIds.push_back(0);
+    if (this->samplingMode == "Random" && this->samplingRadius <= 0)
+    {
+        // Creation of random ids
+        idsType& tempIds = this->shuffledIds;
+        tempIds.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); i++)
+            tempIds[i] = i;
+
+        // Same permutation as std::random_shuffle with rand() seeded with the matrix seed
+        LegacyRandom randomGenerator(this->matrixSeed);
+        for (size_t i = 1; i < tempIds.size(); i++)
+            std::swap(tempIds[i], tempIds[randomGenerator.next() % (i + 1)]);
+
+        for (size_t i = 0; i < this->size; i++)
+            this->instance.randomIds.push_back(tempIds[i]);
+    }
+    else if (this->samplingMode == "KMeans")
+        selectCostumersByClusters();
+    else
+        selectCostumersSpatially();
 
-    // DEBUG: Printing
-    std::cout << "Random Ids:" << std::endl;
-    std::copy(this->randomIds.begin(), this->randomIds.end(), std::ostream_iterator<int>(std::cout, " "));
-    std::cout << std::endl;
+    // DEBUG: Printing (in one piece, instances may be generated by several threads)
+    std::ostringstream message;
+    message << "Random Ids:" << std::endl;
+    std::copy(this->instance.randomIds.begin(), this->instance.randomIds.end(), std::ostream_iterator<int>(message, " "));
+    message << std::endl;
 
-    std::cout << "Real Ids correspondence:" << std::endl;
-    for (size_t i = 0; i < this->randomIds.size(); i++)
-       std::cout << ids[randomIds[i]] << " ";
-    std::cout << std::endl;
+    message << "Real Ids correspondence:" << std::endl;
+    for (size_t i = 0; i < this->instance.randomIds.size(); i++)
+       message << ids[this->instance.randomIds[i]] << " ";
+    message << std::endl;
+    std::cout << message.str() << std::flush;
 
     generateDistanceMatrix();
     generateTimeMatrix();
@@ -419,116 +959,266 @@ void VRPTWInstanceGenerator::generateMatrices()
 
 /**
   Method that generates a vector of size (size) with all the time windows.
+  If the specification contains distributions, windows open at a time drawn
+  from the opens distribution and last a time drawn from the width
+  distribution (both clipped to the time window of the depot).
 */
 void VRPTWInstanceGenerator::generateTimeWindows()
 {
-    std::vector<double> accProbability;
     MTRand randomGenerator(this->timeWindowSeed);
 
-    // Checking integrity, the sum of probs must be 100.
-    unsigned sum = 0;
-    for (size_t i = 0; i < this->timeWindows.timeWindowsCostumers.size() ; i++)
-       sum += this->timeWindows.timeWindowsCostumers[i].probability;
-
-     if (sum != 100)
-        warning("Error - The sum of probabilities in the time windows specifications file is not 100.");
+    if (!this->timeWindowSpec)
+        error("generateTimeWindows(). The time windows have not been specified");
+    const tTimeWindow& timeWindows = this->timeWindowSpec->timeWindows;
+    const accProbabilityType& accProbability = this->timeWindowSpec->accProbability;
 
-    // - Segment for the creation of time windows
-    accProbability.resize(this->timeWindows.timeWindowsCostumers.size());
-    accProbability[0] = 0;
+    const tTimeWindowDepot& depot = timeWindows.timeWindowDepot;
+    if (timeWindows.opensDistribution.type != NO_DISTRIBUTION)
+    {
+        // Widths are drawn into the closes, which become opens + width
+        sampleDistribution(timeWindows.opensDistribution, randomGenerator, this->size, this->instance.opensValues);
+        sampleDistribution(timeWindows.widthDistribution, randomGenerator, this->size, this->instance.closesValues);
 
-    for (size_t i = 1; i < accProbability.size(); i++)
-       accProbability[i] = accProbability[i - 1] + (this->timeWindows.timeWindowsCostumers[i].probability / (double)sum);
-    accProbability.push_back(1);
+        this->instance.opensValues.insert(this->instance.opensValues.begin(), depot.opens);
+        this->instance.closesValues.insert(this->instance.closesValues.begin(), depot.closes);
+        for (size_t i = 1; i < this->instance.opensValues.size(); i++)
+        {
+            this->instance.opensValues[i] = std::min(std::max(this->instance.opensValues[i], depot.opens), depot.closes);
+            this->instance.closesValues[i] = std::min(this->instance.opensValues[i] + this->instance.closesValues[i], depot.closes);
+        }
+        return;
+    }
 
     unsigned index = 0;
+    this->instance.timeWindowsIndexes.clear();
     for (size_t i = 0; i < this->size; i++)
     {
        index = getCategoryRandomly(randomGenerator.rand(), accProbability);
-       this->timeWindowsIndexes.push_back(index);
+       this->instance.timeWindowsIndexes.push_back(index);
+    }
+
+    this->instance.opensValues.resize(this->size + 1);
+    this->instance.closesValues.resize(this->size + 1);
+    this->instance.opensValues[0] = depot.opens;
+    this->instance.closesValues[0] = depot.closes;
+    for (size_t i = 1; i < this->instance.opensValues.size(); i++)
+    {
+       this->instance.opensValues[i] = timeWindows.timeWindowsCostumers[this->instance.timeWindowsIndexes[i - 1]].opens;
+       this->instance.closesValues[i] = timeWindows.timeWindowsCostumers[this->instance.timeWindowsIndexes[i - 1]].closes;
     }
 }
 
 /**
-  Method that generates a vector of size (size) with all the demands.
+  Method that generates a vector of size (size) with all the demands, either
+  from the categories or from the distribution of the specification.
 */
 void VRPTWInstanceGenerator::generateDemands()
 {
-   std::vector<double> accProbability;
    MTRand randomGenerator(this->demandSeed);
 
+   if (!this->demandSpec)
+      error("generateDemands(). The demands have not been specified");
+   const tDemand& demands = this->demandSpec->demands;
+   const accProbabilityType& accProbability = this->demandSpec->accProbability;
 
-   // Checking integrity, the sum of probs must be 100.
-   unsigned sum = 0;
-   // Type of demans start in the second row, so it's from i = 1.
-   for (size_t i = 0; i < this->demands.demandsCostumers.size(); i++)
-      sum += this->demands.demandsCostumers[i].probability;
-
-   if (sum != 100)
-      warning("Error - The sum of probabilities in the demand specification file is not 100.");
-
-   // - Segment for the creation of demands
-   accProbability.resize(this->demands.demandsCostumers.size());
-   accProbability[0] = 0;
-   // First row is reserved, so we start in i = 1
-   for (size_t i = 1; i < accProbability.size(); i++)
-      accProbability[i] = accProbability[i - 1] + (this->demands.demandsCostumers[i].probability / (double)sum);
-   accProbability.push_back(1);
-
-   unsigned index = 0;
-   for (size_t i = 0; i < this->size; i++)
+   double maxDemand = 0;
+   if (demands.distribution.type != NO_DISTRIBUTION)
    {
-      // Demand for the depot is 0, for costumers we throw a die
-      index = getCategoryRandomly(randomGenerator.rand(), accProbability);
-      this->demandsIndexes.push_back(index);
+      sampleDistribution(demands.distribution, randomGenerator, this->size, this->instance.demandValues);
+      for (size_t i = 0; i < this->instance.demandValues.size(); i++)
+      {
+         // Demands are whole units
+         this->instance.demandValues[i] = floor(this->instance.demandValues[i] + 0.5);
+         maxDemand = std::max(maxDemand, this->instance.demandValues[i]);
+      }
+      this->instance.demandValues.insert(this->instance.demandValues.begin(), 0);
+   }
+   else
+   {
+      unsigned index = 0;
+      this->instance.demandsIndexes.clear();
+      for (size_t i = 0; i < this->size + 1; i++)
+      {
+         // Demand for the depot is 0, for costumers we throw a die
+         index = getCategoryRandomly(randomGenerator.rand(), accProbability);
+         this->instance.demandsIndexes.push_back(index);
+      }
+
+      // Demand of costumer i is given by demandsIndexes[i] (as the service times), so costumers keep the
+      // demands they have always had; the last one has its own draw
+      this->instance.demandValues.resize(this->size + 1);
+      this->instance.demandValues[0] = 0;
+      for (size_t i = 1; i < this->instance.demandValues.size(); i++)
+         this->instance.demandValues[i] = demands.demandsCostumers[this->instance.demandsIndexes[i]].type;
+
+      for (size_t i = 0; i < demands.demandsCostumers.size(); i++)
+         maxDemand = std::max(maxDemand, demands.demandsCostumers[i].type);
    }
 
    // Max capacity for each vehicle.
    capacityType sumOfDemands = 0;
-   for (size_t i = 0; i < this->demandsIndexes.size(); i++)
-       sumOfDemands += (this->demands.demandsCostumers[this->demandsIndexes[i]].type);
+   for (size_t i = 1; i < this->instance.demandValues.size(); i++)
+       sumOfDemands += this->instance.demandValues[i];
+
+   computeFleet(sumOfDemands, maxDemand, this->instance.sizeOfFleet, this->instance.vehicleMaxCapacity);
+}
+
+/**
+  Method that generates the demands of each stochastic scenario: a
+  (scenarios x size) matrix drawn in one batched pass. All the uniform numbers
+  are drawn first from a generator seeded with (demand seed, 1), so scenarios
+  differ from the base demands; categories are then found with the same
+  cumulative probabilities as the base demands (getCategoryRandomly). The size
+  of the fleet and the capacity are computed for each scenario.
+*/
+void VRPTWInstanceGenerator::generateDemandScenarios()
+{
+   size_t n = this->size;
+   size_t values = (size_t)this->numberOfScenarios * n;
+
+   MTRand::uint32 seeds[2] = { this->demandSeed, 1 };
+   MTRand randomGenerator(seeds, 2);
 
-   capacityType maxDemand = 0;
-   for (size_t i = 0; i < this->demands.demandsCostumers.size(); i++)
-       maxDemand = (this->demands.demandsCostumers[i].type > maxDemand)? this->demands.demandsCostumers[i].type : maxDemand;
+   if (!this->demandSpec)
+      error("generateDemandScenarios(). The demands have not been specified");
+   const tDemand& demands = this->demandSpec->demands;
 
-   capacityType delta = this->demands.delta;
-   capacityType minCapacity = maxDemand;
-   this->sizeOfFleet = ceil((double)sumOfDemands / (double)(minCapacity));
-   this->vehicleMaxCapacity = minCapacity + ceil((sumOfDemands - minCapacity) * ((double)delta/(double)100));
+   std::vector<double> draws;
+   double maxDemand = 0;
+   if (demands.distribution.type != NO_DISTRIBUTION)
+   {
+      sampleDistribution(demands.distribution, randomGenerator, values, draws);
+      for (size_t i = 0; i < values; i++)
+         draws[i] = floor(draws[i] + 0.5);
+   }
+   else
+   {
+      // Categories are drawn as the nominal demands are (see generateDemands)
+      const std::vector<tDemandCostumer>& categories = demands.demandsCostumers;
+      const accProbabilityType& accProbability = this->demandSpec->accProbability;
+      for (size_t j = 0; j < categories.size(); j++)
+         maxDemand = std::max(maxDemand, categories[j].type);
+
+      draws.resize(values);
+      for (size_t i = 0; i < values; i++)
+         draws[i] = randomGenerator.rand();
+
+      for (size_t i = 0; i < values; i++)
+         draws[i] = categories[getCategoryRandomly(draws[i], accProbability)].type;
+   }
 
-   return;
+   this->instance.scenarioDemands.resize(values);
+   this->instance.scenarioFleetSizes.resize(this->numberOfScenarios);
+   this->instance.scenarioCapacities.resize(this->numberOfScenarios);
+   for (size_t k = 0; k < this->numberOfScenarios; k++)
+   {
+      double sumOfDemands = 0;
+      double scenarioMax = 0;
+      for (size_t i = k * n; i < (k + 1) * n; i++)
+      {
+         // Within the range of the stored values (the bounds of the distribution are checked when it is compiled)
+         draws[i] = std::min(std::max(draws[i], 0.0), (double)std::numeric_limits<unsigned>::max());
+         this->instance.scenarioDemands[i] = (unsigned)draws[i];
+         sumOfDemands += draws[i];
+         scenarioMax = std::max(scenarioMax, draws[i]);
+      }
+
+      computeFleet(sumOfDemands, (maxDemand > 0)? maxDemand : scenarioMax, this->instance.scenarioFleetSizes[k], this->instance.scenarioCapacities[k]);
+   }
 }
 
 /**
-  Method that generates a vector of size (size) with all the time services.
+  Method that generates a vector of size (size) with all the time services,
+  either from the categories or from the distribution of the specification.
 */
 void VRPTWInstanceGenerator::generateServiceTimes()
 {
-   accProbabilityType accProbability;
    MTRand randomGenerator(this->serviceTimeSeed);
 
-   // Checking integrity, the sum of probs should be 100.
-   unsigned sum = 0;
-   for (size_t i = 0; i < this->serviceTimes.size(); i++)
-      sum += this->serviceTimes[i].probability;
+   if (!this->serviceTimeSpec)
+      error("generateServiceTimes(). The service times have not been specified");
+   const tServiceTime& serviceTimes = this->serviceTimeSpec->serviceTimes;
+   const accProbabilityType& accProbability = this->serviceTimeSpec->accProbability;
 
-   if (sum != 100)
-      warning("Error - The sum of probabilities in the service time specification file is not 100.");
+   if (serviceTimes.distribution.type != NO_DISTRIBUTION)
+   {
+      sampleDistribution(serviceTimes.distribution, randomGenerator, this->size, this->instance.serviceTimeValues);
+      this->instance.serviceTimeValues.insert(this->instance.serviceTimeValues.begin(), 0);
+      return;
+   }
 
-   // - Segment for the creation of demands.
-   accProbability.resize(this->serviceTimes.size() + 1);
-   accProbability[0] = 0;
-   for (size_t i = 1; i < accProbability.size(); i++)
-      accProbability[i] = accProbability[i - 1] + (this->serviceTimes[i - 1].probability / (double)sum);
-   accProbability.push_back(1);
+   const std::vector<tServiceTimeCostumer>& serviceTimesCostumers = serviceTimes.serviceTimesCostumers;
 
    unsigned index = 0;
+   this->instance.serviceTimesIndexes.clear();
    for (size_t i = 0; i < this->size + 1; i++)
    {
       index = getCategoryRandomly(randomGenerator.rand(), accProbability);
-      this->serviceTimesIndexes.push_back(index);
+      this->instance.serviceTimesIndexes.push_back(index);
    }
+
+   this->instance.serviceTimeValues.resize(this->size + 1);
+   this->instance.serviceTimeValues[0] = 0;
+   for (size_t i = 1; i < this->instance.serviceTimeValues.size(); i++)
+      this->instance.serviceTimeValues[i] = serviceTimesCostumers[this->instance.serviceTimesIndexes[i]].type;
+}
+
+/**
+  Method that adjusts the time windows using the travel times from and to the
+  depot. Service at costumer i can start no earlier than the depot opens plus
+  the travel time to i, and no later than the depot closes minus the service
+  time and the travel time back. Windows are clipped to that interval; those
+  falling completely outside it are shifted into it keeping their width
+  (as far as possible). It is a single pass over contiguous arrays.
+  Matrices, time windows and service times must have been generated.
+*/
+void VRPTWInstanceGenerator::makeTimeWindowsReachable()
+{
+    size_t n = this->instance.opensValues.size();
+    if (n == 0 || this->instance.timeMatrix.size() != n || this->instance.serviceTimeValues.size() != n)
+        error("makeTimeWindowsReachable(). The matrices, time windows and service times must be generated first");
+
+    const double depotOpens = this->timeWindowSpec->timeWindows.timeWindowDepot.opens;
+    const double depotCloses = this->timeWindowSpec->timeWindows.timeWindowDepot.closes;
+
+    // Row and column of the depot
+    std::vector<double> travelFrom(this->instance.timeMatrix[0]);
+    std::vector<double> travelTo(n);
+    for (size_t i = 0; i < n; i++)
+        travelTo[i] = this->instance.timeMatrix[i][0];
+
+    const double* from = &travelFrom[0];
+    const double* to = &travelTo[0];
+    const double* service = &this->instance.serviceTimeValues[0];
+    double* opens = &this->instance.opensValues[0];
+    double* closes = &this->instance.closesValues[0];
+
+    unsigned unreachable = 0;
+    for (size_t i = 1; i < n; i++)
+    {
+        double earliest = depotOpens + from[i];
+        double latest = depotCloses - service[i] - to[i];
+        double width = closes[i] - opens[i];
+
+        double o = std::max(opens[i], earliest);
+        double c = std::min(closes[i], latest);
+
+        // Outside the interval: shift it keeping the width
+        bool outside = c < o;
+        bool tooEarly = closes[i] < earliest;
+        double shiftedOpens = tooEarly? earliest : std::max(latest - width, earliest);
+        double shiftedCloses = tooEarly? std::min(earliest + width, latest) : latest;
+        o = outside? shiftedOpens : o;
+        c = outside? shiftedCloses : c;
+
+        // The costumer cannot be served within the depot time window at all
+        unreachable += (latest < earliest);
+        opens[i] = o;
+        closes[i] = std::max(o, c);
+    }
+
+    if (unreachable > 0)
+        warning(somethingToString(unreachable) + " costumers cannot be served within the time window of the depot.");
 }
 
 /**
@@ -537,9 +1227,70 @@ void VRPTWInstanceGenerator::generateServiceTimes()
 void VRPTWInstanceGenerator::generateAll()
 {
     generateMatrices();
+    generateSpecifications();
+}
+
+/**
+  Method that clears everything generated for the current instance, so that
+  the generator can be reused for another one (with other seeds, size or
+  specifications) as if it were new. The memory is kept: vectors are
+  emptied but not released, and the rows of the matrices are emptied but
+  kept, so generating instances of the same size again does not allocate.
+  The network and the options are not changed.
+*/
+void VRPTWInstanceGenerator::reset()
+{
+    tInstance& instance = this->instance;
+    instance.randomIds.clear();
+    for (size_t i = 0; i < instance.distanceMatrix.size(); i++)
+        instance.distanceMatrix[i].clear();
+    for (size_t i = 0; i < instance.timeMatrix.size(); i++)
+        instance.timeMatrix[i].clear();
+
+    instance.timeWindowsIndexes.clear();
+    instance.demandsIndexes.clear();
+    instance.serviceTimesIndexes.clear();
+
+    instance.opensValues.clear();
+    instance.closesValues.clear();
+    instance.demandValues.clear();
+    instance.serviceTimeValues.clear();
+
+    instance.sizeOfFleet = 0;
+    instance.vehicleMaxCapacity = 0;
+
+    instance.scenarioDemands.clear();
+    instance.scenarioFleetSizes.clear();
+    instance.scenarioCapacities.clear();
+}
+
+/**
+  Method that returns the instance generated, which only depends on the
+  network, the size, the seeds and the specifications.
+  @return the instance.
+*/
+const tInstance& VRPTWInstanceGenerator::getInstance() const
+{
+    return this->instance;
+}
+
+/**
+  Method that generates everything but the sample of costumers and the
+  matrices: the time windows, demands and service times (and what depends
+  on them). It may be invoked again, after changing the specifications or
+  their seeds, to generate another variant of the same sample.
+*/
+void VRPTWInstanceGenerator::generateSpecifications()
+{
     generateTimeWindows();
     generateDemands();
     generateServiceTimes();
+
+    if (this->reachableTimeWindows)
+        makeTimeWindowsReachable();
+
+    if (this->numberOfScenarios > 0)
+        generateDemandScenarios();
 }
 
 /**
@@ -547,10 +1298,10 @@ void VRPTWInstanceGenerator::generateAll()
 */
 void VRPTWInstanceGenerator::printDistanceMatrix()
 {
-    for (size_t i = 0; i < this->distanceMatrix.size(); i++)
+    for (size_t i = 0; i < this->instance.distanceMatrix.size(); i++)
     {
-       for (size_t j = 0; j < this->distanceMatrix[i].size(); j++)
-          std::cout << this->distanceMatrix[i][j] << "\t";
+       for (size_t j = 0; j < this->instance.distanceMatrix[i].size(); j++)
+          std::cout << this->instance.distanceMatrix[i][j] << "\t";
        std::cout << std::endl;
     }
 }
@@ -560,10 +1311,10 @@ void VRPTWInstanceGenerator::printDistanceMatrix()
 */
 void VRPTWInstanceGenerator::printTimeMatrix()
 {
-    for (size_t i = 0; i < this->timeMatrix.size(); i++)
+    for (size_t i = 0; i < this->instance.timeMatrix.size(); i++)
     {
-       for (size_t j = 0; j < this->timeMatrix[i].size(); j++)
-          std::cout << this->timeMatrix[i][j] << "\t";
+       for (size_t j = 0; j < this->instance.timeMatrix[i].size(); j++)
+          std::cout << this->instance.timeMatrix[i][j] << "\t";
        std::cout << std::endl;
     }
 }
@@ -581,7 +1332,7 @@ void VRPTWInstanceGenerator::printSpecifications()
     std::cout << std::endl;
     std::cout << "VEHICLE" << std::endl;
     std::cout << "NUMBER     CAPACITY" << std::endl;
-    std::cout << this->sizeOfFleet << "\t" << this->vehicleMaxCapacity << std::endl;
+    std::cout << this->instance.sizeOfFleet << "\t" << this->instance.vehicleMaxCapacity << std::endl;
     std::cout << std::endl;
     std::cout << "CUSTOMER" << std::endl;
     std::cout << "CUST NO." << "\t" <<  "XCOORD." << "\t" <<  "YCOORD."  << "\t" <<  "DEMAND" << "\t" <<  "READY TIME" << "\t" << "DUE DATE" << "\t" <<  "SERVICE   TIME" << std::endl;
@@ -603,8 +1354,8 @@ void VRPTWInstanceGenerator::printParameters()
     std::cout << "Seed Demand: " << this->demandSeed << std::endl;
     std::cout << std::endl;
     std::cout << "Random ids: ";
-    for (size_t i = 0; this->randomIds.size(); i++)
-        std::cout << this->randomIds[i] << " " << std::endl;
+    for (size_t i = 0; this->instance.randomIds.size(); i++)
+        std::cout << this->instance.randomIds[i] << " " << std::endl;
     std::cout << std::endl;
 
     std::cout << "Prefix: " << this->prefix << std::endl;
@@ -633,90 +1384,310 @@ void VRPTWInstanceGenerator::print()
 }
 
 /**
-  Method that creates the file containing the distance matrix.
+  Method that writes a matrix as text (a row per line, values followed by
+  a tab) in the format given by setMatrixFormat.
+  @param matrix is the matrix.
+  @param output is the writer (already open).
 */
-void VRPTWInstanceGenerator::writeDistanceMatrix()
+void VRPTWInstanceGenerator::writeMatrixTo(const matrixType& matrix, TextWriter& output)
 {
-    // Output to file
-    std::string outputFilename = this->prefix + "DistanceMatrix.dat";
-    std::ofstream outputFile(outputFilename.c_str());
+    output.setFormat(this->matrixFormat, this->matrixPrecision);
+    for (size_t i = 0; i < matrix.size(); i++)
+    {
+       for (size_t j = 0; j < matrix[i].size(); j++)
+          output << matrix[i][j] << '\t';
+       output << '\n';
+    }
+}
 
-    std::cout << "Writing distance matrix file: " << outputFilename << std::endl;
-    for (size_t i = 0; i < distanceMatrix.size(); i++)
+/**
+  Method that writes the specifications (Solomon-like) as text.
+  @param output is the writer (already open).
+*/
+void VRPTWInstanceGenerator::writeSpecificationsTo(TextWriter& output)
+{
+    // Name of the problem
+    output << this->prefix << "\n";
+    output << "\n";
+    output << "VEHICLE" << "\n";
+    output << "NUMBER     CAPACITY" << "\n";
+    output << this->instance.sizeOfFleet << "\t" << this->instance.vehicleMaxCapacity << "\n";
+    output << "\n";
+    output << "CUSTOMER" << "\n";
+    output << "CUST NO." << "\t" <<  "XCOORD." << "\t" <<  "YCOORD."  << "\t" <<  "DEMAND" << "\t" <<  "READY TIME" << "\t" << "DUE DATE" << "\t" <<  "SERVICE   TIME" << "\n";
+    output << "\n";
+
+    for (size_t i = 0; i < this->instance.randomIds.size(); i++)
     {
-       for (size_t j = 0; j < distanceMatrix[i].size(); j++)
-          outputFile << distanceMatrix[i][j] << "\t";
-       outputFile << "\n";
+        const tPos& position = getCostumerPosition(i);
+        output.setFormat(TextWriter::FIXED, 4);
+        output << this->network->getIds()[this->instance.randomIds[i]]
+                << '\t' << position.lat
+                << '\t' << position.lng;
+
+        output.setFormat(TextWriter::FIXED, 0);
+        output << '\t' << this->instance.demandValues[i]
+                << '\t' << this->instance.opensValues[i]
+                << '\t' << this->instance.closesValues[i]
+                << '\t' << this->instance.serviceTimeValues[i]
+                << '\n';
     }
-    outputFile.close();
 }
 
 /**
-  Method that creates the file containing the time matrix.
+  Method that writes the demand scenarios in binary.
+  Format (native byte order, 32-bit unsigned values but the capacities):
+     - Header: "MVRPTWSC", version (2), number of scenarios (K), number of costumers (n).
+     - K sizes of the fleet.
+     - K capacities of the vehicles (64-bit signed, as in binaryinstance.h).
+     - K x n demands (scenario after scenario, costumers in the order of the Specs file).
+  @param output is the writer (already open).
 */
-void VRPTWInstanceGenerator::writeTimeMatrix()
+void VRPTWInstanceGenerator::writeDemandScenariosTo(TextWriter& output)
 {
-    // Output to file
-    std::string outputFilename = this->prefix + "TimeMatrix.dat";
-    std::ofstream outputFile(outputFilename.c_str());
+    const uint32_t header[4] = { 2, this->numberOfScenarios, this->size, 0 };
+    const std::vector<int64_t> capacities(this->instance.scenarioCapacities.begin(), this->instance.scenarioCapacities.end());
+    output.write("MVRPTWSC", 8);
+    output.write(header, sizeof(header));
+    output.write(this->instance.scenarioFleetSizes.data(), this->instance.scenarioFleetSizes.size() * sizeof(unsigned));
+    output.write(capacities.data(), capacities.size() * sizeof(int64_t));
+    output.write(this->instance.scenarioDemands.data(), this->instance.scenarioDemands.size() * sizeof(unsigned));
+}
 
-    std::cout << "Writing time matrix file: " << outputFilename << std::endl;
-    for (size_t i = 0; i < timeMatrix.size(); i++)
+/**
+  Method that writes the instance (both matrices and the costumers, see
+  binaryinstance.h) in binary. The sections are traversed twice: first to
+  compute the checksum of the header, then to write them.
+  @param output is the writer (already open).
+*/
+void VRPTWInstanceGenerator::writeBinaryInstanceTo(TextWriter& output)
+{
+    std::vector<tBinaryCostumer> costumers(this->instance.randomIds.size());
+    for (size_t i = 0; i < this->instance.randomIds.size(); i++)
     {
-       for (size_t j = 0; j < timeMatrix[i].size(); j++)
-          outputFile << timeMatrix[i][j] << "\t";
-       outputFile << "\n";
+        tBinaryCostumer& costumer = costumers[i];
+        memset(&costumer, 0, sizeof(costumer));
+        const tPos& position = getCostumerPosition(i);
+        costumer.id = this->network->getIds()[this->instance.randomIds[i]];
+        costumer.lat = position.lat;
+        costumer.lng = position.lng;
+        costumer.demand = this->instance.demandValues[i];
+        costumer.readyTime = this->instance.opensValues[i];
+        costumer.dueDate = this->instance.closesValues[i];
+        costumer.serviceTime = this->instance.serviceTimeValues[i];
     }
-    outputFile.close();
+
+    tBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binaryInstanceMagic, sizeof(header.magic));
+    header.version = binaryInstanceVersion;
+    header.byteOrder = binaryInstanceByteOrder;
+    header.elementType = binaryInstanceDouble;
+    header.elementSize = sizeof(double);
+    header.nodes = this->instance.randomIds.size();
+    header.fleetSize = this->instance.sizeOfFleet;
+    header.capacity = this->instance.vehicleMaxCapacity;
+
+    // Sections after the header
+    auto writeSections = [&](BinaryOutput& sections)
+    {
+        header.distanceOffset = sections.align();
+        for (size_t i = 0; i < this->instance.distanceMatrix.size(); i++)
+            sections.write(this->instance.distanceMatrix[i].data(), this->instance.distanceMatrix[i].size() * sizeof(double));
+
+        header.timeOffset = sections.align();
+        for (size_t i = 0; i < this->instance.timeMatrix.size(); i++)
+            sections.write(this->instance.timeMatrix[i].data(), this->instance.timeMatrix[i].size() * sizeof(double));
+
+        header.costumersOffset = sections.align();
+        sections.write(costumers.data(), costumers.size() * sizeof(tBinaryCostumer));
+    };
+
+    BinaryOutput checksum(NULL, sizeof(header));
+    writeSections(checksum);
+    header.fileSize = checksum.getOffset();
+    header.checksum = checksum.getHash();
+
+    output.write(&header, sizeof(header));
+    BinaryOutput sections(&output, sizeof(header));
+    writeSections(sections);
 }
 
 /**
-  Method that creates the file containing the specifications.
+  Method that writes one of the output files to a writer.
+  @param kind is the kind of file.
+  @param output is the writer (already open).
 */
-void VRPTWInstanceGenerator::writeSpecifications()
+void VRPTWInstanceGenerator::writeOutputTo(tOutputFileKind kind, TextWriter& output)
 {
-    std::string outputFilename = this->prefix + "Specs.dat";
-    std::ofstream output(outputFilename.c_str());
-    std::cout << "Writing specifications file: " << outputFilename << std::endl;
+    switch (kind)
+    {
+        case DISTANCE_MATRIX_FILE:
+            writeMatrixTo(this->instance.distanceMatrix, output);
+            break;
+        case TIME_MATRIX_FILE:
+            writeMatrixTo(this->instance.timeMatrix, output);
+            break;
+        case SPECIFICATIONS_FILE:
+            writeSpecificationsTo(output);
+            break;
+        case DEMAND_SCENARIOS_FILE:
+            writeDemandScenariosTo(output);
+            break;
+        case BINARY_INSTANCE_FILE:
+            writeBinaryInstanceTo(output);
+            break;
+    }
+}
 
+/**
+  Method that tells whether a kind of file is text (which may be compressed).
+  @param kind is the kind of file.
+  @return true for the matrices and the specifications.
+*/
+bool VRPTWInstanceGenerator::isTextFile(tOutputFileKind kind)
+{
+    return kind == DISTANCE_MATRIX_FILE || kind == TIME_MATRIX_FILE || kind == SPECIFICATIONS_FILE;
+}
 
-    double opens, closes;
+/**
+  Method that returns the path to one of the output files.
+  @param kind is the kind of file.
+  @return the kind of file and its path (prefix + suffix).
+*/
+tOutputFile VRPTWInstanceGenerator::getOutputFile(tOutputFileKind kind)
+{
+    static const char* suffixes[] = { "DistanceMatrix.dat", "TimeMatrix.dat", "Specs.dat",
+                                      "Scenarios.dat", "Instance.bin" };
 
-    // Name of the problem
-    output << this->prefix << "\n";
-    output << "\n";
-    output << "VEHICLE" << "\n";
-    output << "NUMBER     CAPACITY" << "\n";
-    output << this->sizeOfFleet << "\t" << this->vehicleMaxCapacity << "\n";
-    output << "\n";
-    output << "CUSTOMER" << "\n";
-    output << "CUST NO." << "\t" <<  "XCOORD." << "\t" <<  "YCOORD."  << "\t" <<  "DEMAND" << "\t" <<  "READY TIME" << "\t" << "DUE DATE" << "\t" <<  "SERVICE   TIME" << "\n";
-    output << "\n";
+    // Text files may be compressed
+    std::string extension;
+    if (isTextFile(kind))
+        extension = TextWriter::extension(this->compression);
 
-    tIndex indexPosition;
-    for (size_t i = 0; i < this->randomIds.size(); i++)
-    {
-        opens = ((i == 0)? this->timeWindows.timeWindowDepot.opens :
-                           this->timeWindows.timeWindowsCostumers[this->timeWindowsIndexes[i - 1]].opens);
+    return tOutputFile(kind, this->prefix + suffixes[kind] + extension);
+}
 
-        closes = ((i == 0)? this->timeWindows.timeWindowDepot.closes :
-                            this->timeWindows.timeWindowsCostumers[this->timeWindowsIndexes[i - 1]].closes);
+/**
+  Method that returns the files written by writeAll() (and writeAllAsync()).
+  @param files is the vector where the files are stored, in the order they are written.
+*/
+void VRPTWInstanceGenerator::getOutputFiles(std::vector<tOutputFile>& files)
+{
+    files.clear();
+    files.push_back(getOutputFile(DISTANCE_MATRIX_FILE));
+    files.push_back(getOutputFile(TIME_MATRIX_FILE));
+    files.push_back(getOutputFile(SPECIFICATIONS_FILE));
 
-        indexPosition = getPosition(this->ids[this->randomIds[i]]);
-        output << ids[this->randomIds[i]] << std::setiosflags(std::ios::fixed) << std::setprecision(4)
-                << "\t" << this->positions[indexPosition].lat
-                << "\t" << this->positions[indexPosition].lng;
+    if (this->numberOfScenarios > 0)
+        files.push_back(getOutputFile(DEMAND_SCENARIOS_FILE));
 
-        output << "\t" <<  std::setprecision(0) << ((i == 0)? 0 : this->demands.demandsCostumers[this->demandsIndexes[i]].type)
-                << "\t" << opens
-                << "\t" << closes
-                << "\t" << ((i == 0)? 0 : this->serviceTimes[this->serviceTimesIndexes[i]].type)
-                << "\n";
+    if (this->binaryOutput)
+        files.push_back(getOutputFile(BINARY_INSTANCE_FILE));
+}
 
-    }
+/**
+  Method that writes one of the output files.
+  @param file is the kind of file and its path.
+  @throw std::runtime_error if the file cannot be written.
+*/
+void VRPTWInstanceGenerator::writeOutputFile(const tOutputFile& file)
+{
+    TextWriter output;
+    if (isTextFile(file.first))
+        output.setCompression(this->compression);
+    output.open(file.second);
+    writeOutputTo(file.first, output);
     output.close();
 }
 
+/**
+  Method that writes one of the output files to memory.
+  @param kind is the kind of file.
+  @param contents is the string where the content of the file is stored.
+*/
+void VRPTWInstanceGenerator::writeOutputToString(tOutputFileKind kind, std::string& contents)
+{
+    contents.clear();
+    TextWriter output;
+    if (isTextFile(kind))
+        output.setCompression(this->compression);
+    output.openString(contents);
+    writeOutputTo(kind, output);
+    output.close();
+}
+
+/**
+  Method that outputs the message announcing that a file is written.
+  @param file is the kind of file and its path.
+*/
+void VRPTWInstanceGenerator::announce(const tOutputFile& file)
+{
+    static const char* descriptions[] = { "distance matrix", "time matrix", "specifications",
+                                          "demand scenarios", "binary instance" };
+    std::cout << "Writing " << descriptions[file.first] << " file: " << file.second << std::endl;
+}
+
+/**
+  Method that writes one of the output files, exiting if it cannot be written.
+  @param kind is the kind of file.
+*/
+void VRPTWInstanceGenerator::write(tOutputFileKind kind)
+{
+    tOutputFile file = getOutputFile(kind);
+    announce(file);
+    try
+    {
+        writeOutputFile(file);
+    }
+    catch (const std::exception& exception)
+    {
+        error(exception.what());
+    }
+}
+
+/**
+  Method that creates the file containing the distance matrix.
+*/
+void VRPTWInstanceGenerator::writeDistanceMatrix()
+{
+    write(DISTANCE_MATRIX_FILE);
+}
+
+/**
+  Method that creates the file containing the time matrix.
+*/
+void VRPTWInstanceGenerator::writeTimeMatrix()
+{
+    write(TIME_MATRIX_FILE);
+}
+
+/**
+  Method that creates the file containing the specifications.
+*/
+void VRPTWInstanceGenerator::writeSpecifications()
+{
+    write(SPECIFICATIONS_FILE);
+}
+
+/**
+  Method that creates the binary file containing the demand scenarios
+  (see writeDemandScenariosTo for its format).
+*/
+void VRPTWInstanceGenerator::writeDemandScenarios()
+{
+    write(DEMAND_SCENARIOS_FILE);
+}
+
+/**
+  Method that creates the binary file containing the instance, which
+  solvers can map in memory instead of parsing the text files.
+*/
+void VRPTWInstanceGenerator::writeBinaryInstance()
+{
+    write(BINARY_INSTANCE_FILE);
+}
+
 /**
   Method that invokes all writing methods.
 */
@@ -725,4 +1696,64 @@ void VRPTWInstanceGenerator::writeAll()
     writeDistanceMatrix();
     writeTimeMatrix();
     writeSpecifications();
+
+    if (this->numberOfScenarios > 0)
+        writeDemandScenarios();
+
+    if (this->binaryOutput)
+        writeBinaryInstance();
+}
+
+/**
+  Method that writes the same files as writeAll(), each one formatted and
+  written by its own thread (at most as many threads as setThreads allows),
+  so the time employed is that of the largest file rather than the sum.
+  Messages are output in the same order as writeAll() does.
+  @param pack is the pack where the files are added as entries named as
+         the files (NULL to write them to disk).
+*/
+void VRPTWInstanceGenerator::writeAllAsync(PackWriter* pack)
+{
+    std::vector<tOutputFile> files;
+    getOutputFiles(files);
+    for (size_t i = 0; i < files.size(); i++)
+        announce(files[i]);
+
+    unsigned workers = this->threads;
+    if (workers == 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<size_t>(workers, files.size());
+
+    // Each worker takes the next file to write (the matrices come first)
+    std::atomic<size_t> nextFile(0);
+    std::vector<std::string> errors(files.size());
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < workers; w++)
+        pool.push_back(std::thread([&]()
+        {
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+            {
+                try
+                {
+                    if (pack == NULL)
+                        writeOutputFile(files[i]);
+                    else
+                    {
+                        std::string contents;
+                        writeOutputToString(files[i].first, contents);
+                        pack->append(files[i].second, contents.data(), contents.size());
+                    }
+                }
+                catch (const std::exception& exception)
+                {
+                    errors[i] = exception.what();
+                }
+            }
+        }));
+    for (size_t w = 0; w < pool.size(); w++)
+        pool[w].join();
+
+    for (size_t i = 0; i < errors.size(); i++)
+        if (!errors[i].empty())
+            error(errors[i]);
 }
@@ -1,10 +1,15 @@
 #ifndef VRPTWINSTANCEGENERATOR_H
 #define VRPTWINSTANCEGENERATOR_H
 
+#include <memory>
 #include <string>
 
 #include "dataTypes.h"
 #include "MersenneTwister.h"
+#include "network.h"
+#include "textwriter.h"
+
+class PackWriter;
 
 class VRPTWInstanceGenerator
 {
@@ -21,46 +26,64 @@ class VRPTWInstanceGenerator
       //! Size of the instance (number of costumers)
       unsigned size;
 
-      //! Raw info to generate the instance
-      rawInfoVector distanceTable;
-      rawInfoVector timeTable;
+      //! Network the costumers are drawn from (read only, it may be shared)
+      std::shared_ptr<const Network> network;
 
-      //! Specifications of the instance
-      tTimeWindow timeWindows;
-      tDemand demands;
-      tServiceTime serviceTimes;
+      //! Specifications of the instance (compiled, they may be shared)
+      std::shared_ptr<const tTimeWindowSpec> timeWindowSpec;
+      std::shared_ptr<const tDemandSpec> demandSpec;
+      std::shared_ptr<const tServiceTimeSpec> serviceTimeSpec;
 
-      //! Maximum capacity of each vehicle of the fleet
-      capacityType vehicleMaxCapacity;
+      //! Prefix for output-files
+      std::string prefix;
 
-      //! Number of max allowed vehicles for this instance
-      unsigned sizeOfFleet;
+      //! Instance generated (costumers, matrices, values, fleet...)
+      tInstance instance;
 
-      //! Costumer ids
-      std::vector<unsigned> ids;
+      //! Permutation of the ids of the network (Random mode, kept to reuse its memory)
+      idsType shuffledIds;
 
-      //! Costumers positions
-      costumersPosType positions;
+      //! Mode employed to select the costumers (Random, Clustered, Mixed or KMeans)
+      std::string samplingMode;
 
-      //! Matrices
-      matrixType distanceMatrix;
-      matrixType timeMatrix;
+      //! Max distance (km) between the depot and the costumers (0 means no limit)
+      double samplingRadius;
 
-      //! Prefix for output-files
-      std::string prefix;
+      //! Number of costumers per cluster in Clustered and Mixed modes
+      unsigned clusterSize;
+
+      //! Number of geographic clusters in KMeans mode
+      unsigned numberOfClusters;
+
+      //! Proportion of costumers drawn from each cluster (empty means equal)
+      std::vector<double> clusterProportions;
 
-      //! Solomon-type output structure
-      std::vector<unsigned> timeWindowsIndexes;
-      idsType demandsIndexes;
-      idsType serviceTimesIndexes;
+      //! Number of threads employed (0 means as many as cores)
+      unsigned threads;
 
-      //! Vector of costumers appearing in this instance
-      std::vector<unsigned> randomIds;
+      //! If true, time windows are adjusted so that costumers are reachable from the depot
+      bool reachableTimeWindows;
+
+      //! Number of stochastic demand scenarios (0 means none)
+      unsigned numberOfScenarios;
+
+      //! If true, writeAll() also writes the binary instance
+      bool binaryOutput;
+
+      //! Format and precision of the values of the matrices (see TextWriter)
+      TextWriter::tFormat matrixFormat;
+      int matrixPrecision;
+
+      //! Compression of the text files (matrices and specifications)
+      TextWriter::tCompression compression;
 
    protected:
 
-      //! Method that, given a table and 'from' 'to' information, returns the length in time or distance
-      double getData(const rawInfoVector&, unsigned, unsigned);
+      //! Method that returns the network (exiting if it has not been read)
+      const Network& checkNetwork();
+
+      //! Method that returns a copy of the network (or an empty one) where a file can be read
+      std::shared_ptr<Network> editNetwork();
 
       //! This method will receive a random number generator and a vector of accumulative probability and will return a category
       unsigned getCategoryRandomly(double, const accProbabilityType&);
@@ -71,8 +94,14 @@ class VRPTWInstanceGenerator
       //! Method to output warnings
       void warning(const std::string&);
 
-      //! Method to get the position of a costumer within vector
-      unsigned getPosition(unsigned);
+      //! Method that returns the position of the depot
+      tPos getDepotPosition();
+
+      //! Method that returns the position of a costumer of the instance
+      const tPos& getCostumerPosition(size_t);
+
+      //! Method that computes the size of the fleet and the capacity of the vehicles given the demands
+      void computeFleet(double, double, unsigned&, capacityType&);
 
       //! Method to generate the distance matrix for this instance
       void generateDistanceMatrix();
@@ -80,12 +109,40 @@ class VRPTWInstanceGenerator
       //! Method to generate the time matrix for this instance
       void generateTimeMatrix();
 
+      //! Method that tells whether a position can be selected as a costumer
+      bool isSelectable(unsigned, const tPos&);
+
+      //! Method that selects the costumers by means of the spatial index
+      void selectCostumersSpatially();
+
+      //! Method that selects the costumers from the k-means clusters
+      void selectCostumersByClusters();
+
+      //! Methods that write each kind of output file to an open writer
+      void writeMatrixTo(const matrixType&, TextWriter&);
+      void writeSpecificationsTo(TextWriter&);
+      void writeDemandScenariosTo(TextWriter&);
+      void writeBinaryInstanceTo(TextWriter&);
+      void writeOutputTo(tOutputFileKind, TextWriter&);
+
+      //! Returns true if a kind of output file is text (it may be compressed)
+      static bool isTextFile(tOutputFileKind);
+
+      //! Method that writes an output file given its kind and path (it throws std::runtime_error)
+      void writeOutputFile(const tOutputFile&);
+
+      //! Method that writes an output file, exiting if it cannot be written
+      void write(tOutputFileKind);
+
    public:
 
 
       //! Default Ctor.
       VRPTWInstanceGenerator();
 
+      //! Ctor. The instances are drawn from a network already read (it is shared, not copied).
+      explicit VRPTWInstanceGenerator(std::shared_ptr<const Network> network);
+
       //! Default Destructor.
       ~VRPTWInstanceGenerator();
 
@@ -114,6 +171,12 @@ class VRPTWInstanceGenerator
       */
       void readPositions(const char* idslatlngFileName);
 
+      //! Sets the network the instances are drawn from (it is shared, not copied)
+      void setNetwork(std::shared_ptr<const Network>);
+
+      //! Returns the network (NULL if none has been read)
+      std::shared_ptr<const Network> getNetwork() const;
+
 
       //! Method that parsers the time windows specifications
       /*!
@@ -133,6 +196,14 @@ class VRPTWInstanceGenerator
       */
       void readServiceTimesFile(const char* fileName);
 
+      //! Methods that set already compiled specifications (e.g. from a SpecRegistry)
+      void setTimeWindows(std::shared_ptr<const tTimeWindowSpec>);
+      void setDemands(std::shared_ptr<const tDemandSpec>);
+      void setServiceTimes(std::shared_ptr<const tServiceTimeSpec>);
+
+      //! Method that sets up everything given in a scenario (size, seeds, specifications, options...)
+      void setScenario(const tScenario&);
+
       //! Sets the size of the instance
       void setSize(unsigned);
 
@@ -142,6 +213,39 @@ class VRPTWInstanceGenerator
       //! Sets the prefix for the output files
       void setPrefix(const std::string&);
 
+      //! Sets the mode to select the costumers (Random, Clustered, Mixed or KMeans)
+      void setSamplingMode(const std::string&);
+
+      //! Sets the max distance (km) between the depot and the costumers
+      void setSamplingRadius(double);
+
+      //! Sets the number of costumers per cluster
+      void setClusterSize(unsigned);
+
+      //! Sets the number of geographic clusters (KMeans mode)
+      void setNumberOfClusters(unsigned);
+
+      //! Sets the proportion of costumers drawn from each geographic cluster
+      void setClusterProportions(const std::vector<double>&);
+
+      //! Sets the number of threads (0 means as many as cores)
+      void setThreads(unsigned);
+
+      //! Sets whether time windows must be reachable from the depot (see makeTimeWindowsReachable)
+      void setReachableTimeWindows(bool);
+
+      //! Sets the number of stochastic demand scenarios
+      void setDemandScenarios(unsigned);
+
+      //! Sets whether writeAll() also writes the binary instance (see writeBinaryInstance)
+      void setBinaryOutput(bool);
+
+      //! Sets the format of the values of the matrices (General, Shortest or Fixed) and their precision
+      void setMatrixFormat(const std::string&, int);
+
+      //! Sets the compression of the text files (None, Gzip or Zstd)
+      void setCompression(const std::string&);
+
       //! Method that generates the distance and time windows matrices with random costumers
       void generateMatrices();
 
@@ -154,9 +258,24 @@ class VRPTWInstanceGenerator
       //! Method that associates a type of service time to each costumer
       void generateServiceTimes();
 
+      //! Method that generates the demands of each stochastic scenario
+      void generateDemandScenarios();
+
+      //! Method that shifts/clips the time windows so that costumers can be served and the vehicle can return
+      void makeTimeWindowsReachable();
+
+      //! Method that generates the time windows, demands and service times of the current sample
+      void generateSpecifications();
+
       //! Method that call all generates
       void generateAll();
 
+      //! Method that clears the instance generated, keeping its memory to generate another one
+      void reset();
+
+      //! Returns the instance generated
+      const tInstance& getInstance() const;
+
       // Print
 
       //! Method to print the parameters
@@ -188,9 +307,30 @@ class VRPTWInstanceGenerator
       //! Method that writes the specification to a file
       void writeSpecifications();
 
+      //! Method that writes the demand scenarios to a binary file
+      void writeDemandScenarios();
+
+      //! Method that writes the matrices and the costumers to a binary file (see binaryinstance.h)
+      void writeBinaryInstance();
+
       //! Method that call all writes
       void writeAll();
 
+      //! Method that writes the same files as writeAll(), in parallel (to a pack instead, if given)
+      void writeAllAsync(PackWriter* pack = NULL);
+
+      //! Returns the kind and path of an output file
+      tOutputFile getOutputFile(tOutputFileKind);
+
+      //! Method that returns the files that writeAll() writes
+      void getOutputFiles(std::vector<tOutputFile>&);
+
+      //! Method that writes an output file to memory instead of a file
+      void writeOutputToString(tOutputFileKind, std::string&);
+
+      //! Method that outputs the message announcing that a file is written
+      static void announce(const tOutputFile&);
+
 };
 
 #endif // VRPTWINSTANCEGENERATOR_H
@@ -0,0 +1,146 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "workstealingpool.h"
+
+// --- Private --- //
+
+/**
+  Method that takes the next task of a worker: the first one of its own
+  queue or, if it is empty, the last one of the queue of another worker.
+  @param worker is the number of the worker.
+  @param task is where the number of the task is stored.
+  @return false if there are no tasks left in any queue.
+*/
+bool WorkStealingPool::nextTask(unsigned worker, size_t& task)
+{
+   {
+      tWorkerQueue& own = *this->queues[worker];
+      std::lock_guard<std::mutex> lock(own.queueMutex);
+      if (!own.tasks.empty())
+      {
+         task = own.tasks.front();
+         own.tasks.pop_front();
+         return true;
+      }
+   }
+
+   // Tasks are never added while running, so empty queues stay empty
+   for (unsigned i = 1; i < this->workers; i++)
+   {
+      tWorkerQueue& victim = *this->queues[(worker + i) % this->workers];
+      std::lock_guard<std::mutex> lock(victim.queueMutex);
+      if (!victim.tasks.empty())
+      {
+         task = victim.tasks.back();
+         victim.tasks.pop_back();
+         return true;
+      }
+   }
+   return false;
+}
+
+// --- Public --- //
+
+/**
+  Ctor.
+  @param workers is the number of threads (0 means as many as cores).
+*/
+WorkStealingPool::WorkStealingPool(unsigned workers) : workers(workers)
+{
+   if (this->workers == 0)
+      this->workers = std::max(1u, std::thread::hardware_concurrency());
+   for (unsigned i = 0; i < this->workers; i++)
+      this->queues.push_back(std::unique_ptr<tWorkerQueue>(new tWorkerQueue()));
+}
+
+/**
+  Method that returns the number of threads.
+  @return the number of workers.
+*/
+unsigned WorkStealingPool::size() const
+{
+   return this->workers;
+}
+
+/**
+  Method that runs n tasks and waits for them to finish.
+  @param tasks is the number of tasks.
+  @param work is invoked with the number of each task and the number of
+         the worker that runs it (tasks of the same worker never overlap).
+  @throw the first exception thrown by a task.
+*/
+void WorkStealingPool::run(size_t tasks, const std::function<void(size_t, unsigned)>& work)
+{
+   for (size_t task = 0; task < tasks; task++)
+      this->queues[task % this->workers]->tasks.push_back(task);
+
+   std::exception_ptr failure;
+   std::mutex failureMutex;
+   std::atomic<bool> failed(false);
+
+   std::vector<std::thread> pool;
+   unsigned threads = std::min<size_t>(this->workers, tasks);
+   for (unsigned w = 0; w < threads; w++)
+      pool.push_back(std::thread([&, w]()
+      {
+         size_t task;
+         while (!failed && nextTask(w, task))
+         {
+            try
+            {
+               work(task, w);
+            }
+            catch (...)
+            {
+               std::lock_guard<std::mutex> lock(failureMutex);
+               if (!failure)
+                  failure = std::current_exception();
+               failed = true;
+            }
+         }
+      }));
+   for (size_t w = 0; w < pool.size(); w++)
+      pool[w].join();
+
+   // Tasks not started after a failure
+   for (unsigned i = 0; i < this->workers; i++)
+      this->queues[i]->tasks.clear();
+
+   if (failure)
+      std::rethrow_exception(failure);
+}
@@ -0,0 +1,68 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+  Pool of threads with work stealing:
+     The tasks (numbered 0 to n - 1) are dealt out in turns to the queues
+     of the workers. Each worker takes the tasks of its own queue from the
+     front, in increasing order; when its queue is empty, it steals the
+     last task of the queue of another worker. Hence, workers are kept busy
+     even if tasks take very different times, and tasks are started in
+     roughly increasing order.
+     The first exception thrown by a task is rethrown by run() once all
+     the workers have finished (the remaining tasks are not started).
+   \code
+      WorkStealingPool pool(4);
+      pool.run(instances.size(), [&](size_t task, unsigned worker) { generate(instances[task]); });
+   \endcode
+*/
+class WorkStealingPool
+{
+   private:
+      //! Queue of tasks of a worker
+      struct tWorkerQueue
+      {
+         std::deque<size_t> tasks;
+         std::mutex queueMutex;
+      };
+
+      //! Number of workers
+      unsigned workers;
+
+      //! Queues of the workers
+      std::vector<std::unique_ptr<tWorkerQueue> > queues;
+
+      //! Method that takes the next task of a worker (false if there are no tasks left)
+      bool nextTask(unsigned worker, size_t& task);
+
+      //! Non-copyable
+      WorkStealingPool(const WorkStealingPool&);
+      WorkStealingPool& operator=(const WorkStealingPool&);
+
+   public:
+
+      //! Ctor.
+      /*!
+        \param workers is the number of threads (0 means as many as cores).
+      */
+      explicit WorkStealingPool(unsigned workers = 0);
+
+      //! Returns the number of threads
+      unsigned size() const;
+
+      //! Method that runs n tasks and waits for them
+      /*!
+        \param tasks is the number of tasks.
+        \param work is invoked with the number of each task and the number of the worker that runs it.
+      */
+      void run(size_t tasks, const std::function<void(size_t, unsigned)>& work);
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,384 @@
+/*
+ * --------------------------------------------------------------------------
+ *
+ *                             Copyright (c) 2010
+ *                  Juan Castro-Gutierrez <jpcastrog@gmail.com>      (1)
+ *             Dario Landa-Silva <dario.landasilva@nottingham.ac.uk> (1)
+ *            José A. Moreno Pérez <joseandresmorenoperez@gmail.com> (2)
+ *           --------------------------------------------------------
+ *            (1) University of Nottingham (UK) - ASAP research group.
+ *            (2) Universidad de La Laguna (Spain) - DEIOC.
+ *
+ * This program is free software (software libre); you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can obtain a copy of the GNU
+ * General Public License at:
+ *                http://www.gnu.org/copyleft/gpl.html
+ * or by writing to:
+ *           Free Software Foundation, Inc., 59 Temple Place,
+ *                 Suite 330, Boston, MA 02111-1307 USA
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xmlpullparser.h"
+
+namespace
+{
+   //! Characters considered as blanks by XML
+   bool isBlank(char c)
+   {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+   }
+
+   //! Returns true if the remaining characters start with a given prefix
+   bool startsWith(const char* position, const char* end, const char* prefix)
+   {
+      size_t length = strlen(prefix);
+      return (size_t)(end - position) >= length && memcmp(position, prefix, length) == 0;
+   }
+}
+
+// --- Private --- //
+
+/**
+  Method that throws an error indicating the line of the current position.
+  @param message is the description of the error.
+*/
+void XmlPullParser::fail(const std::string& message) const
+{
+   unsigned line = 1;
+   for (const char* c = this->data; c < this->position; c++)
+      line += (*c == '\n');
+   throw std::runtime_error(this->fileName + ":" + std::to_string(line) + ": " + message);
+}
+
+/**
+  Method that skips the characters until a given string (included).
+  @param terminator is the string that ends the section being skipped.
+*/
+void XmlPullParser::skipPast(const char* terminator)
+{
+   const char* end = this->data + this->length;
+   size_t terminatorLength = strlen(terminator);
+   const char* found = std::search(this->position, end, terminator, terminator + terminatorLength);
+   if (found == end)
+      fail("Unterminated section, expected '" + std::string(terminator) + "'");
+   this->position = found + terminatorLength;
+}
+
+/**
+  Method that reads the name and attributes of a start tag. The current
+  position must be at '<', and it ends right after '>'.
+*/
+void XmlPullParser::readStartTag()
+{
+   const char* end = this->data + this->length;
+   const char* c = this->position + 1;
+
+   const char* nameBegin = c;
+   while (c < end && !isBlank(*c) && *c != '/' && *c != '>')
+      c++;
+   if (c == nameBegin || c == end)
+      fail("Invalid start tag");
+   this->elementName = std::string_view(nameBegin, c - nameBegin);
+
+   this->attributes.clear();
+   this->pendingEnd = false;
+   while (true)
+   {
+      while (c < end && isBlank(*c))
+         c++;
+      if (c == end)
+         fail("Unterminated start tag <" + std::string(this->elementName) + ">");
+
+      if (*c == '>')
+      {
+         c++;
+         break;
+      }
+      if (*c == '/')
+      {
+         if (c + 1 == end || *(c + 1) != '>')
+            fail("Invalid start tag <" + std::string(this->elementName) + ">");
+         this->pendingEnd = true;
+         c += 2;
+         break;
+      }
+
+      // Attribute: name = "value"
+      const char* attributeBegin = c;
+      while (c < end && !isBlank(*c) && *c != '=' && *c != '>' && *c != '/')
+         c++;
+      std::string_view attributeName(attributeBegin, c - attributeBegin);
+      while (c < end && isBlank(*c))
+         c++;
+      if (c == end || *c != '=')
+         fail("Expected '=' after attribute '" + std::string(attributeName) + "'");
+      c++;
+      while (c < end && isBlank(*c))
+         c++;
+      if (c == end || (*c != '"' && *c != '\''))
+         fail("Expected a quoted value for attribute '" + std::string(attributeName) + "'");
+
+      char quote = *c++;
+      const char* valueBegin = c;
+      while (c < end && *c != quote)
+         c++;
+      if (c == end)
+         fail("Unterminated value of attribute '" + std::string(attributeName) + "'");
+      this->attributes.push_back(std::make_pair(attributeName, std::string_view(valueBegin, c - valueBegin)));
+      c++;
+   }
+
+   this->position = c;
+}
+
+// --- Public --- //
+
+/**
+  Ctor. There is nothing to parse until open() is invoked.
+*/
+XmlPullParser::XmlPullParser()
+{
+   this->data = NULL;
+   this->length = 0;
+   this->mapped = false;
+   this->position = NULL;
+   this->event = END_DOCUMENT;
+   this->pendingEnd = false;
+}
+
+/**
+  Dtor. It unmaps the file.
+*/
+XmlPullParser::~XmlPullParser()
+{
+   close();
+}
+
+/**
+  Method that maps a file in memory to be parsed.
+  @param fileName is the path to the file.
+  @throw std::runtime_error if the file cannot be read.
+*/
+void XmlPullParser::open(const char* fileName)
+{
+   close();
+   this->fileName = fileName;
+
+   int descriptor = ::open(fileName, O_RDONLY);
+   if (descriptor < 0)
+      throw std::runtime_error("Unable to open " + this->fileName);
+
+   struct stat status;
+   if (fstat(descriptor, &status) != 0)
+   {
+      ::close(descriptor);
+      throw std::runtime_error("Unable to read " + this->fileName);
+   }
+
+   this->length = status.st_size;
+   if (this->length > 0)
+   {
+      void* address = mmap(NULL, this->length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (address == MAP_FAILED)
+      {
+         ::close(descriptor);
+         throw std::runtime_error("Unable to map " + this->fileName);
+      }
+      madvise(address, this->length, MADV_SEQUENTIAL);
+      this->data = static_cast<const char*>(address);
+      this->mapped = true;
+   }
+   ::close(descriptor);
+
+   this->position = this->data;
+}
+
+/**
+  Method that parses a buffer in memory.
+  @param buffer is the document (it must outlive the parser).
+  @param length is the number of characters of the document.
+*/
+void XmlPullParser::open(const char* buffer, size_t length)
+{
+   close();
+   this->fileName = "<buffer>";
+   this->data = buffer;
+   this->length = length;
+   this->position = buffer;
+}
+
+/**
+  Method that unmaps the file (if any) and resets the parser.
+*/
+void XmlPullParser::close()
+{
+   if (this->mapped)
+      munmap(const_cast<char*>(this->data), this->length);
+   this->data = NULL;
+   this->length = 0;
+   this->mapped = false;
+   this->position = NULL;
+   this->event = END_DOCUMENT;
+   this->pendingEnd = false;
+   this->openElements.clear();
+   this->attributes.clear();
+}
+
+/**
+  Method that advances to the next start or end of an element.
+  @return false when the end of the document is reached.
+*/
+bool XmlPullParser::next()
+{
+   // The element that ended in the previous event is not open anymore
+   if (this->event == END_ELEMENT && !this->openElements.empty())
+      this->openElements.pop_back();
+
+   if (this->pendingEnd)
+   {
+      this->pendingEnd = false;
+      this->event = END_ELEMENT;
+      return true;
+   }
+
+   const char* end = this->data + this->length;
+   while (true)
+   {
+      // Text is skipped
+      while (this->position < end && *this->position != '<')
+         this->position++;
+
+      if (this->position >= end)
+      {
+         if (!this->openElements.empty())
+            fail("Unexpected end of document, <" + std::string(this->openElements.back()) + "> is not closed");
+         this->event = END_DOCUMENT;
+         return false;
+      }
+
+      if (startsWith(this->position, end, "<?"))
+         skipPast("?>");
+      else if (startsWith(this->position, end, "<!--"))
+         skipPast("-->");
+      else if (startsWith(this->position, end, "<![CDATA["))
+         skipPast("]]>");
+      else if (startsWith(this->position, end, "<!"))
+         skipPast(">");
+      else if (startsWith(this->position, end, "</"))
+      {
+         const char* nameBegin = this->position + 2;
+         const char* c = nameBegin;
+         while (c < end && !isBlank(*c) && *c != '>')
+            c++;
+         this->elementName = std::string_view(nameBegin, c - nameBegin);
+         while (c < end && isBlank(*c))
+            c++;
+         if (c == end || *c != '>')
+            fail("Invalid end tag </" + std::string(this->elementName) + ">");
+         if (this->openElements.empty())
+            fail("Unexpected end tag </" + std::string(this->elementName) + ">");
+         if (this->elementName != this->openElements.back())
+            fail("Unexpected end tag </" + std::string(this->elementName) + ">, <" + std::string(this->openElements.back()) + "> is not closed");
+
+         this->position = c + 1;
+         this->attributes.clear();
+         this->event = END_ELEMENT;
+         return true;
+      }
+      else
+      {
+         readStartTag();
+         this->openElements.push_back(this->elementName);
+         this->event = START_ELEMENT;
+         return true;
+      }
+   }
+}
+
+/**
+  Method that returns the current event.
+  @return START_ELEMENT, END_ELEMENT or END_DOCUMENT.
+*/
+XmlPullParser::tEvent XmlPullParser::getEvent() const
+{
+   return this->event;
+}
+
+/**
+  Method that tells whether the current event is the start of an element.
+  @return true if it is the start of an element.
+*/
+bool XmlPullParser::isStartElement() const
+{
+   return this->event == START_ELEMENT;
+}
+
+/**
+  Method that tells whether the current event is the end of an element.
+  @return true if it is the end of an element.
+*/
+bool XmlPullParser::isEndElement() const
+{
+   return this->event == END_ELEMENT;
+}
+
+/**
+  Method that returns the name of the current element.
+  @return the name (valid while the file is open).
+*/
+std::string_view XmlPullParser::name() const
+{
+   return this->elementName;
+}
+
+/**
+  Method that returns the name of the file being parsed.
+  @return the name of the file ("<buffer>" if a buffer is parsed).
+*/
+const std::string& XmlPullParser::getFileName() const
+{
+   return this->fileName;
+}
+
+/**
+  Method that returns the number of open elements.
+  @return the depth of the current element (the root element has depth 1).
+*/
+unsigned XmlPullParser::getDepth() const
+{
+   return this->openElements.size();
+}
+
+/**
+  Method that returns the value of an attribute of the current element.
+  @param attributeName is the name of the attribute.
+  @return pointer to the value (NULL if the attribute does not exist).
+*/
+const std::string_view* XmlPullParser::attribute(std::string_view attributeName) const
+{
+   for (size_t i = 0; i < this->attributes.size(); i++)
+      if (this->attributes[i].first == attributeName)
+         return &this->attributes[i].second;
+   return NULL;
+}
@@ -0,0 +1,114 @@
+#ifndef XMLPULLPARSER_H
+#define XMLPULLPARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+  Streaming (pull) XML parser:
+     The file is mapped in memory and scanned element by element, without
+     building a tree, so the memory employed does not depend on the size of
+     the document. It supports the subset of XML employed by the
+     specification files: elements, attributes, comments, processing
+     instructions, DOCTYPE and CDATA sections (text is skipped).
+     Entities within attribute values are not decoded. Every end tag must
+     match the element that is open.
+     Malformed documents are reported by throwing std::runtime_error.
+   \code
+      XmlPullParser parser;
+      parser.open("demands.xml");
+      while (parser.next())
+         if (parser.isStartElement() && parser.name() == "demand")
+            std::cout << *parser.attribute("type") << std::endl;
+   \endcode
+*/
+class XmlPullParser
+{
+   public:
+      //! Type of event
+      enum tEvent { START_ELEMENT, END_ELEMENT, END_DOCUMENT };
+
+   private:
+      //! Mapped file (or buffer)
+      const char* data;
+      size_t length;
+      bool mapped;
+
+      //! Current position within the document
+      const char* position;
+
+      //! Current event
+      tEvent event;
+
+      //! Name and attributes of the current element
+      std::string_view elementName;
+      std::vector<std::pair<std::string_view, std::string_view> > attributes;
+
+      //! The current element is self-closing (<element/>), so an END_ELEMENT comes next
+      bool pendingEnd;
+
+      //! Names of the open elements (the current one last)
+      std::vector<std::string_view> openElements;
+
+      //! Name of the file (for error messages)
+      std::string fileName;
+
+      //! Method that throws an error indicating the line of the current position
+      void fail(const std::string&) const;
+
+      //! Method that skips the characters until a given string (included)
+      void skipPast(const char*);
+
+      //! Method that reads the name and attributes of a start tag
+      void readStartTag();
+
+      //! Non-copyable
+      XmlPullParser(const XmlPullParser&);
+      XmlPullParser& operator=(const XmlPullParser&);
+
+   public:
+
+      //! Default Ctor.
+      XmlPullParser();
+
+      //! Dtor. It unmaps the file.
+      ~XmlPullParser();
+
+      //! Method that maps a file to be parsed
+      void open(const char* fileName);
+
+      //! Method that parses a buffer in memory (it must outlive the parser)
+      void open(const char* buffer, size_t length);
+
+      //! Method that unmaps the file
+      void close();
+
+      //! Method that advances to the next event (false at the end of the document)
+      bool next();
+
+      //! Returns the current event
+      tEvent getEvent() const;
+
+      //! Returns true if the current event is the start of an element
+      bool isStartElement() const;
+
+      //! Returns true if the current event is the end of an element
+      bool isEndElement() const;
+
+      //! Returns the name of the current element
+      std::string_view name() const;
+
+      //! Returns the name of the file being parsed
+      const std::string& getFileName() const;
+
+      //! Returns the number of open elements (the root element has depth 1)
+      unsigned getDepth() const;
+
+      //! Returns the value of an attribute of the current element (NULL if it does not exist)
+      const std::string_view* attribute(std::string_view) const;
+};
+
+#endif // XMLPULLPARSER_H